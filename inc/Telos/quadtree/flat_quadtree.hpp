@@ -0,0 +1,292 @@
+/**
+ * @file flat_quadtree.hpp
+ * @author Radica
+ * @brief 无指针四叉树: 节点存放在连续数组中
+ * @version 0.1
+ * @date 2025-03-12
+ *
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef FLAT_QUADTREE_H
+#define FLAT_QUADTREE_H
+
+#include "Telos/quadtree/quadtree.hpp"
+
+#include <stdint.h>
+
+constexpr int FLAT_QUADTREE_MAX_DEPTH = 24;  // 最大深度(相同包围盒的元素过多时停止分裂)
+
+/**
+  * @brief 无指针四叉树节点(12字节)
+  * 节点包围盒不存储，遍历时由父节点包围盒按中点计算
+  */
+struct FlatQuadTreeNode
+{
+    uint32_t firstChild;  // 第一个子节点下标，四个子节点连续存放 [左上，右上，左下，右下]；0表示叶子节点
+    uint32_t elemBegin;   // 节点元素在元素数组中的起始下标
+    uint32_t elemCount;   // 节点元素数量(非叶子节点为跨越多个子节点的元素)
+};
+
+/**
+  * @brief 无指针四叉树: 一次性构建
+  * 元素被某个象限包含(误差 G_EP 以内)时放入该子节点，否则留在本节点；元素数不超过 CAPACITY 的节点不分裂。
+  * 与 QuadTree 按插入顺序和节点容量逐个划分不同，树的形状只由元素集合决定。
+  * 所有节点存放在一个连续数组中，以32位下标寻址，四个子节点连续存放；
+  * 所有元素按先序存放在一个连续数组中，每个节点占据其中一段。
+  *
+  * @tparam ELEM_T 存储的元素类型
+  * @tparam NUM_T 包围盒的值类型
+  * @tparam BBOX_F 包围盒计算策略: 可调用对象 BBox<NUM_T>(const ELEM_T&)
+  * @tparam CACHE_BBOX 是否缓存元素包围盒
+  */
+template <typename ELEM_T, typename NUM_T = double, typename BBOX_F = QuadTreeMemberBBox<ELEM_T, NUM_T>,
+          bool CACHE_BBOX = false>
+class FlatQuadTree
+{
+   private:
+    typedef QuadTreeSlot<ELEM_T, NUM_T, CACHE_BBOX> Slot;
+
+    std::vector<FlatQuadTreeNode> _nodes;  // 所有节点，[0]为根节点
+    std::vector<Slot> _elems;              // 所有元素，每个节点占据连续的一段
+    BBOX_F _getBBox;                       // 包围盒计算函数，用户提供
+    BBox<NUM_T> _bbox;                     // 根节点包围盒
+
+    BBox<NUM_T> slotBBox(const Slot& slot) const
+    {
+        if constexpr (CACHE_BBOX)
+            return slot.bbox;
+        else
+            return _getBBox(slot.elem);
+    }
+
+    // 第i个子节点的包围盒，顺序与 QuadTree::subdivided 相同
+    static BBox<NUM_T> childBBox(const BBox<NUM_T>& box, int i)
+    {
+        NUM_T mid_x = (box.min_x + box.max_x) / 2.0;
+        NUM_T mid_y = (box.min_y + box.max_y) / 2.0;
+        switch (i)
+        {
+            case 0:
+                return BBox<NUM_T>{box.min_x, mid_y, mid_x, box.max_y};  // 左上
+            case 1:
+                return BBox<NUM_T>{mid_x, mid_y, box.max_x, box.max_y};  // 右上
+            case 2:
+                return BBox<NUM_T>{box.min_x, box.min_y, mid_x, mid_y};  // 左下
+            default:
+                return BBox<NUM_T>{mid_x, box.min_y, box.max_x, mid_y};  // 右下
+        }
+    }
+
+    // 调用访问函数，返回值为void的访问函数视为总是继续
+    template <typename Visitor>
+    static bool visitElem(Visitor& visitor, const ELEM_T& elem)
+    {
+        if constexpr (std::is_void<decltype(visitor(elem))>::value)
+        {
+            visitor(elem);
+            return true;
+        }
+        else
+        {
+            return visitor(elem);
+        }
+    }
+
+    /**
+      * @brief 构建节点: 将 [begin, end) 中的元素划分为本节点元素(排在前面)和四个子节点的元素
+      *
+      * @param node 节点下标
+      * @param box 节点包围盒
+      * @param begin 元素起始下标
+      * @param end 元素结束下标
+      * @param depth 节点深度
+      * @param quad 与元素数组等长的暂存区，记录元素所属的子节点，所有节点共用
+      */
+    void build(uint32_t node, const BBox<NUM_T>& box, uint32_t begin, uint32_t end, int depth,
+               std::vector<uint8_t>& quad)
+    {
+        _nodes[node] = FlatQuadTreeNode{0, begin, end - begin};
+        if (end - begin <= (uint32_t)CAPACITY || depth >= FLAT_QUADTREE_MAX_DEPTH)
+            return;
+
+        // 计算每个元素所属的子节点(4表示跨越多个子节点，留在本节点)
+        const std::array<BBox<NUM_T>, 4> quadrants = {
+            {childBBox(box, 0), childBBox(box, 1), childBBox(box, 2), childBBox(box, 3)}};
+        std::array<uint32_t, 5> count = {{0, 0, 0, 0, 0}};
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            BBox<NUM_T> elem_bbox = slotBBox(_elems[i]);
+            uint8_t q = 0;
+            while (q < 4 && quadrants[q].contains(elem_bbox) == false)
+                ++q;
+            quad[i] = q;
+            ++count[q];
+        }
+        // 元素都跨越多个子节点时不分裂
+        if (count[4] == end - begin)
+            return;
+
+        // 按 [本节点, 左上, 右上, 左下, 右下] 的顺序原地交换重排元素(段内顺序不保留)
+        const uint8_t order[5] = {4, 0, 1, 2, 3};
+        std::array<uint32_t, 5> childBegin;
+        std::array<uint32_t, 5> next;
+        for (uint32_t k = 0, sum = begin; k < 5; ++k)
+        {
+            childBegin[order[k]] = sum;
+            next[order[k]] = sum;
+            sum += count[order[k]];
+        }
+        for (uint8_t q : order)
+        {
+            uint32_t end_q = childBegin[q] + count[q];
+            while (next[q] < end_q)
+            {
+                // 当前位置的元素交换到其所属段的下一个空位，直到当前位置放入本段的元素
+                uint32_t i = next[q];
+                uint8_t t = quad[i];
+                if (t != q)
+                {
+                    std::swap(_elems[i], _elems[next[t]]);
+                    std::swap(quad[i], quad[next[t]]);
+                }
+                ++next[t];
+            }
+        }
+
+        // 四个子节点连续分配，分配后 _nodes 可能扩容，只使用下标访问
+        uint32_t firstChild = (uint32_t)_nodes.size();
+        _nodes.resize(_nodes.size() + 4);
+        _nodes[node].firstChild = firstChild;
+        _nodes[node].elemCount = count[4];
+        for (uint32_t q = 0; q < 4; ++q)
+        {
+            build(firstChild + q, quadrants[q], childBegin[q], childBegin[q] + count[q], depth + 1, quad);
+        }
+    }
+
+    template <typename Visitor>
+    bool visitNode(uint32_t node, const BBox<NUM_T>& box, const BBox<NUM_T>& range, Visitor& visitor) const
+    {
+        const FlatQuadTreeNode& n = _nodes[node];
+        for (uint32_t i = n.elemBegin, end = n.elemBegin + n.elemCount; i < end; ++i)
+        {
+            if (range.intersects(slotBBox(_elems[i])) == true && visitElem(visitor, _elems[i].elem) == false)
+                return false;
+        }
+        if (n.firstChild == 0)
+            return true;
+        for (int q = 0; q < 4; ++q)
+        {
+            // 子节点中的元素可以超出子节点包围盒 G_EP，子节点包围盒按 G_EP 放大后判断
+            BBox<NUM_T> child = childBBox(box, q);
+            if (range.intersects(child.loose()) == true && visitNode(n.firstChild + q, child, range, visitor) == false)
+                return false;
+        }
+        return true;
+    }
+
+   public:
+    FlatQuadTree() = default;
+
+    /**
+      * @brief 构建四叉树，不在包围盒范围内的元素被忽略
+      *
+      * @param box 四叉树包围盒
+      * @param elems 元素
+      * @param bboxFunc 包围盒计算函数
+      */
+    FlatQuadTree(const BBox<NUM_T>& box, const std::vector<ELEM_T>& elems, BBOX_F bboxFunc = BBOX_F())
+        : _getBBox(bboxFunc), _bbox(box)
+    {
+        _elems.reserve(elems.size());
+        for (const auto& e : elems)
+        {
+            BBox<NUM_T> elem_bbox = _getBBox(e);
+            if (_bbox.contains(elem_bbox) == false)
+                continue;
+            if constexpr (CACHE_BBOX)
+                _elems.push_back(Slot{e, elem_bbox});
+            else
+                _elems.push_back(Slot{e});
+        }
+        _nodes.resize(1);
+        std::vector<uint8_t> quad(_elems.size());
+        build(0, _bbox, 0, (uint32_t)_elems.size(), 0, quad);
+    }
+
+    /**
+      * @brief 访问与范围相交的元素，不分配内存
+      *
+      * @param range 包围盒范围
+      * @param visitor 访问函数: bool(const ELEM_T&) 返回false时停止访问；也可以返回void
+      * @return true 访问完成
+      * @return false 被访问函数提前停止
+      */
+    template <typename Visitor>
+    bool visit(const BBox<NUM_T>& range, Visitor&& visitor) const
+    {
+        if (_nodes.empty() == true)
+            return true;
+        return visitNode(0, _bbox, range, visitor);
+    }
+
+    /**
+      * @brief 四叉树中查询元素（粗查询），结果写入输出迭代器
+      *
+      * @param range 包围盒范围
+      * @param out 输出迭代器
+      * @return OutputIt 写入最后一个元素之后的迭代器
+      */
+    template <typename OutputIt>
+    OutputIt query(const BBox<NUM_T>& range, OutputIt out) const
+    {
+        visit(range, [&out](const ELEM_T& e) { *out++ = e; });
+        return out;
+    }
+
+    /**
+      * @brief 四叉树中查询元素（粗查询），结果追加到容器末尾(不清空容器)
+      *
+      * @param range 包围盒范围
+      * @param result 结果容器
+      */
+    void query(const BBox<NUM_T>& range, std::vector<ELEM_T>& result) const
+    {
+        visit(range, [&result](const ELEM_T& e) { result.push_back(e); });
+    }
+
+    /**
+      * @brief 四叉树中查询元素（粗查询）
+      *
+      * @param range 包围盒范围
+      * @return std::vector<ELEM_T> 查找到的元素
+      */
+    std::vector<ELEM_T> query(const BBox<NUM_T>& range) const
+    {
+        std::vector<ELEM_T> result;
+        query(range, result);
+        return result;
+    }
+
+    /**
+      * @brief 统计与范围相交的元素数量，不分配内存
+      *
+      * @param range 包围盒范围
+      * @return size_t 元素数量
+      */
+    size_t count(const BBox<NUM_T>& range) const
+    {
+        size_t num = 0;
+        visit(range, [&num](const ELEM_T&) { ++num; });
+        return num;
+    }
+
+    // 元素数量
+    size_t size() const { return _elems.size(); }
+
+    // 节点数量
+    size_t nodeCount() const { return _nodes.size(); }
+};
+
+#endif  // FLAT_QUADTREE_H
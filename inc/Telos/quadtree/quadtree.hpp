@@ -11,7 +11,11 @@
 #ifndef QUADTREE_H
 #define QUADTREE_H
 
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #ifndef DEBUG_ON
@@ -59,36 +63,141 @@ struct BBox
         return (other.min_x - G_EP) <= max_x && (other.max_x + G_EP) >= min_x && (other.min_y - G_EP) <= max_y &&
                (other.max_y + G_EP) >= min_y;
     }
+
+    // 四边各放大 G_EP 的包围盒；整数坐标比较没有精度误差，不放大
+    BBox<T> loose() const
+    {
+        if constexpr (std::is_floating_point<T>::value)
+            return BBox<T>(static_cast<T>(min_x - G_EP), static_cast<T>(min_y - G_EP), static_cast<T>(max_x + G_EP),
+                           static_cast<T>(max_y + G_EP));
+        else
+            return *this;
+    }
 };
 
 // 包围盒回调函数，需要外部提供
 template <typename ELEM_T, typename NUM_T = double>
 using BBoxFunc = std::function<BBox<NUM_T>(const ELEM_T& elem)>;
 
+/**
+  * @brief 默认的包围盒计算策略(无状态函数对象): 调用元素的 bbox() 成员函数，元素为指针时通过指针调用
+  * 使用回调函数时以 BBoxFunc 作为 BBOX_F 模板参数
+  */
+template <typename ELEM_T, typename NUM_T = double>
+struct QuadTreeMemberBBox
+{
+    BBox<NUM_T> operator()(const ELEM_T& elem) const
+    {
+        if constexpr (std::is_pointer<ELEM_T>::value)
+            return elem->bbox();
+        else
+            return elem.bbox();
+    }
+};
+
+/**
+  * @brief 包围盒计算策略的存放: 无状态的函数对象作为空基类，不占用节点空间
+  *
+  * @tparam EMPTY 是否为无状态的函数对象
+  */
+template <typename BBOX_F, bool EMPTY = std::is_empty<BBOX_F>::value && !std::is_final<BBOX_F>::value>
+class QuadTreeBBoxHolder : private BBOX_F
+{
+   protected:
+    QuadTreeBBoxHolder() = default;
+    explicit QuadTreeBBoxHolder(const BBOX_F& bboxFunc) : BBOX_F(bboxFunc) {}
+
+    const BBOX_F& bboxFunc() const { return *this; }
+};
+
+// 有状态的可调用对象(如 std::function)只在根节点创建一次，所有子节点共享，分裂时不复制
+template <typename BBOX_F>
+class QuadTreeBBoxHolder<BBOX_F, false>
+{
+   private:
+    std::shared_ptr<const BBOX_F> _bboxFunc;
+
+   protected:
+    QuadTreeBBoxHolder() = default;
+    explicit QuadTreeBBoxHolder(const BBOX_F& bboxFunc) : _bboxFunc(std::make_shared<const BBOX_F>(bboxFunc)) {}
+
+    const BBOX_F& bboxFunc() const { return *_bboxFunc; }
+};
+
+/**
+  * @brief 四叉树中存放的元素: 缓存模式下包围盒与元素存放在一起
+  *
+  * @tparam CACHE_BBOX 是否缓存包围盒
+  */
+template <typename ELEM_T, typename NUM_T, bool CACHE_BBOX>
+struct QuadTreeSlot
+{
+    ELEM_T elem;       // 元素
+    BBox<NUM_T> bbox;  // 插入时计算的包围盒
+};
+
+template <typename ELEM_T, typename NUM_T>
+struct QuadTreeSlot<ELEM_T, NUM_T, false>
+{
+    ELEM_T elem;  // 元素
+};
+
 /**
   * @brief 四叉树类
   * 
   * @tparam ELEM_T 存储的元素类型
   * @tparam NUM_T 包围盒的值类型
+  * @tparam BBOX_F 包围盒计算策略: 可调用对象 BBox<NUM_T>(const ELEM_T&)，使用函数对象类型时调用可以内联；
+  *                无状态的函数对象不占用节点空间，其它可调用对象由所有节点共享一份
+  * @tparam CACHE_BBOX 是否缓存元素包围盒: 缓存时每个元素只在插入时计算一次包围盒，查询不再调用 BBOX_F
   */
-template <typename ELEM_T, typename NUM_T = double>
-class QuadTree
+template <typename ELEM_T, typename NUM_T = double, typename BBOX_F = QuadTreeMemberBBox<ELEM_T, NUM_T>,
+          bool CACHE_BBOX = false>
+class QuadTree : private QuadTreeBBoxHolder<BBOX_F>
 {
    private:
+    typedef QuadTreeSlot<ELEM_T, NUM_T, CACHE_BBOX> Slot;
+    typedef QuadTreeBBoxHolder<BBOX_F> Holder;
+
     std::vector<std::shared_ptr<QuadTree>> _children;  // 四个子节点 [左上，右上，左下，右下]
-    std::vector<ELEM_T> _elem;                         // 存储的元素
-    std::vector<ELEM_T> _spanElem;                     // 存储跨越多个子节点的元素
-    BBoxFunc<ELEM_T, NUM_T> _getBBox;                  // 包围盒计算函数，用户提供
+    std::vector<Slot> _elem;                           // 存储的元素
+    std::vector<Slot> _spanElem;                       // 存储跨越多个子节点的元素
     BBox<NUM_T> _bbox;                                 // 节点包围盒 [min_x, min_y, max_x, max_y]
 
+    // 子节点: 与父节点共用包围盒计算策略
+    QuadTree(const BBox<NUM_T>& box, const Holder& holder)
+        : Holder(holder), _children(4, nullptr), _elem({}), _spanElem({}), _bbox(box)
+    {
+    }
+
+    // 调用包围盒计算函数
+    BBox<NUM_T> _getBBox(const ELEM_T& elem) const { return this->bboxFunc()(elem); }
+
+    static Slot makeSlot(const ELEM_T& elem, const BBox<NUM_T>& box)
+    {
+        if constexpr (CACHE_BBOX)
+            return Slot{elem, box};
+        else
+            return Slot{elem};
+    }
+
+    // 元素的包围盒: 缓存模式下直接读取，否则调用包围盒计算函数
+    BBox<NUM_T> slotBBox(const Slot& slot) const
+    {
+        if constexpr (CACHE_BBOX)
+            return slot.bbox;
+        else
+            return _getBBox(slot.elem);
+    }
+
     /**
       * @brief 判断元素是否跨越多个子节点
       *
-      * @param elem 元素
+      * @param elem_bbox 元素包围盒
       * @param box 包围盒
       * @return bool 跨越返回true，不跨越返回false
       */
-    bool crossQuadrant(const ELEM_T& elem, const BBox<NUM_T>& box)
+    bool crossQuadrant(const BBox<NUM_T>& elem_bbox, const BBox<NUM_T>& box) const
     {
         // 计算中点，避免潜在溢出
         NUM_T mid_x = box.min_x + (box.max_x - box.min_x) / 2;
@@ -102,7 +211,6 @@ class QuadTree
             {mid_x, mid_y, box.max_x, box.max_y}   // 第四象限
         }};
 
-        BBox<NUM_T> elem_bbox = _getBBox(elem);
         int count = 0;
 
         for (const auto& quad : quadrants)
@@ -119,38 +227,39 @@ class QuadTree
         return false;
     }
 
-   public:
-    QuadTree() = default;
-    explicit QuadTree(const BBox<NUM_T>& box, BBoxFunc<ELEM_T, NUM_T> bboxFunc = nullptr)
-        : _children(4, nullptr), _elem({}), _spanElem({}), _getBBox(bboxFunc), _bbox(box)
-    {
-    }
-
-    QuadTree(const ELEM_T& elem, BBoxFunc<ELEM_T, NUM_T> bboxFunc)
-        : _children(4, nullptr), _elem({}), _spanElem({}), _getBBox(bboxFunc), _bbox(_getBBox(elem))
+    // 调用访问函数，返回值为void的访问函数视为总是继续
+    template <typename Visitor>
+    static bool visitElem(Visitor& visitor, const ELEM_T& elem)
     {
+        if constexpr (std::is_void<decltype(visitor(elem))>::value)
+        {
+            visitor(elem);
+            return true;
+        }
+        else
+        {
+            return visitor(elem);
+        }
     }
-    ~QuadTree() = default;
 
     /**
-      * @brief 四叉树中插入元素
+      * @brief 插入已计算包围盒的元素
       *
-      * @param elem 要插入的元素
+      * @param slot 要插入的元素
       * @param box 元素的包围盒
       */
-    int insert(ELEM_T elem)
+    int insertSlot(const Slot& slot, const BBox<NUM_T>& box)
     {
 #ifdef DEBUG_ON
         // 打印当前节点的包围盒
         std::cout << "_bbox: " << _bbox.min_x << "," << _bbox.min_y << "," << _bbox.max_x << "," << _bbox.max_y
                   << std::endl;
         // 打印要插入元素的包围盒
-        std::cout << "_getBBox(elem): " << _getBBox(elem).min_x << "," << _getBBox(elem).min_y << ","
-                  << _getBBox(elem).max_x << "," << _getBBox(elem).max_y << std::endl;
+        std::cout << "box: " << box.min_x << "," << box.min_y << "," << box.max_x << "," << box.max_y << std::endl;
 #endif
 
         // 如果要插入的元素不在当前节点的包围盒内，则返回-1
-        if (_bbox.contains(_getBBox(elem)) == false)
+        if (_bbox.contains(box) == false)
             return -1;
 
         // 如果当前节点有子节点，需要递归插入
@@ -159,7 +268,7 @@ class QuadTree
             bool insertSuc = false;
             for (auto& child : _children)
             {
-                int err = child->insert(elem);
+                int err = child->insertSlot(slot, box);
                 // 如果插入成功，则返回0
                 if (err == 0)
                 {
@@ -173,31 +282,31 @@ class QuadTree
         }
         // 如果当前节点的元素数量小于容量，且没有溢出元素，则将元素插入到当前节点
         if ((_elem.size() < CAPACITY) && (_spanElem.empty() == true))
-            _elem.push_back(elem);
+            _elem.push_back(slot);
         // 如果当前节点的元素数量大于等于容量，且有溢出元素，则将元素插入到溢出元素中
         else
         {
             // 如果要插入的元素跨越了四个象限，则将元素插入到溢出元素中
-            if (crossQuadrant(elem, _bbox) == true)
+            if (crossQuadrant(box, _bbox) == true)
             {
-                _spanElem.emplace_back(elem);
+                _spanElem.emplace_back(slot);
                 return 0;
             }
 
             // 将当前节点划分为四个子节点
             subdivided();
             // 将当前节点的元素移动到子节点中
-            std::vector<ELEM_T> elems = std::move(_elem);
+            std::vector<Slot> elems = std::move(_elem);
             _elem.clear();
             // 将要插入的元素插入到子节点中
-            elems.emplace_back(elem);
+            elems.emplace_back(slot);
             for (auto& e : elems)
             {
-                bool span = false;
+                BBox<NUM_T> e_box = slotBBox(e);
                 int tryCnt = 0;
                 for (auto& child : _children)
                 {
-                    int err = child->insert(e);
+                    int err = child->insertSlot(e, e_box);
                     // 如果插入成功，则跳出循环
                     if (err == 0)
                         break;
@@ -213,79 +322,147 @@ class QuadTree
         return 0;
     }
 
+   public:
+    QuadTree() = default;
+    explicit QuadTree(const BBox<NUM_T>& box, const BBOX_F& bboxFunc = BBOX_F())
+        : Holder(bboxFunc), _children(4, nullptr), _elem({}), _spanElem({}), _bbox(box)
+    {
+    }
+
+    QuadTree(const ELEM_T& elem, const BBOX_F& bboxFunc)
+        : Holder(bboxFunc), _children(4, nullptr), _elem({}), _spanElem({}), _bbox(_getBBox(elem))
+    {
+    }
+    ~QuadTree() = default;
+
+    /**
+      * @brief 四叉树中插入元素
+      *
+      * @param elem 要插入的元素
+      * @return int 成功返回0，元素不在树的范围内返回-1
+      */
+    int insert(ELEM_T elem)
+    {
+        // 包围盒只计算一次，向下递归时传递
+        BBox<NUM_T> box = _getBBox(elem);
+        return insertSlot(makeSlot(elem, box), box);
+    }
+
     void remove(ELEM_T elem)
     {
         if (isLeaf() == true)
         {
             // 删除找到的元素
-            _elem.erase(std::remove(_elem.begin(), _elem.end(), elem), _elem.end());
+            _elem.erase(std::remove_if(_elem.begin(), _elem.end(), [&elem](const Slot& e) { return e.elem == elem; }),
+                        _elem.end());
             return;
         }
         else
         {
             // 跨越数据移除
-            _spanElem.erase(std::remove(_spanElem.begin(), _spanElem.end(), elem), _spanElem.end());
+            _spanElem.erase(
+                std::remove_if(_spanElem.begin(), _spanElem.end(), [&elem](const Slot& e) { return e.elem == elem; }),
+                _spanElem.end());
             // 递归删除子节点中的元素
             for (auto& child : _children)
                 child->remove(elem);
 
-            // 如果子节点为空，则将子节点置为空
+            // 如果四个子节点均为空的叶子节点，则回收子节点(只回收部分子节点会破坏 isLeaf 判断)
             for (auto& child : _children)
             {
-                if (child->isLeaf() == true)
-                {
-                    if (child->size() == 0)
-                        child = nullptr;
-                }
+                if (child->isLeaf() == false || child->size() != 0)
+                    return;
             }
+            for (auto& child : _children)
+                child = nullptr;
         }
     }
 
     /**
-      * @brief 四叉树中查询元素（粗查询）
+      * @brief 访问与范围相交的元素，不分配内存
       *
-      * @param box 包围盒范围
-      * @return std::vector<ELEM_T> 查找到的元素
+      * @param range 包围盒范围
+      * @param visitor 访问函数: bool(const ELEM_T&) 返回false时停止访问；也可以返回void
+      * @return true 访问完成
+      * @return false 被访问函数提前停止
       */
-    std::vector<ELEM_T> query(const BBox<NUM_T>& range)
+    template <typename Visitor>
+    bool visit(const BBox<NUM_T>& range, Visitor&& visitor) const
     {
-        // 如果传入的范围和存储元素的包围盒有交集，则返回
-        std::vector<ELEM_T> result;
-
-        // 如果当前没有子节点，则搜索当前节点中存储的元素
-        if (isLeaf() == true)
+        // 叶子节点存储在 _elem 中；非叶子节点的子节点都无法容纳元素时，元素也会留在 _elem 中
+        for (const auto& e : _elem)
         {
-            for (auto& e : _elem)
-            {
-                if (range.intersects(_getBBox(e)) == true)
-                    result.emplace_back(e);
-            }
-            for (auto& e : _spanElem)
-            {
-                if (range.intersects(_getBBox(e)) == true)
-                    result.emplace_back(e);
-            }
+            if (range.intersects(slotBBox(e)) == true && visitElem(visitor, e.elem) == false)
+                return false;
         }
-        else
+        for (const auto& e : _spanElem)
         {
-            // 如果当前节点有子节点，则递归查询子节点，递归之前需要检查跨越象限元素
-            // 查询当前节点的跨越元素
-            for (auto& e : _spanElem)
-            {
-                if (range.intersects(_getBBox(e)) == true)
-                    result.emplace_back(e);
-            }
-            // 递归查询子节点
-            for (auto& child : _children)
-            {
-                auto ret = child->query(range);
-                result.insert(result.end(), ret.begin(), ret.end());
-            }
+            if (range.intersects(slotBBox(e)) == true && visitElem(visitor, e.elem) == false)
+                return false;
         }
+        if (_children.empty() == true || isLeaf() == true)
+            return true;
 
+        // 子节点中的元素都被子节点包围盒包含(误差 G_EP 以内)，与范围不相交的子节点可以跳过
+        for (const auto& child : _children)
+        {
+            if (range.intersects(child->_bbox.loose()) == true && child->visit(range, visitor) == false)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+      * @brief 四叉树中查询元素（粗查询），结果写入输出迭代器
+      *
+      * @param range 包围盒范围
+      * @param out 输出迭代器
+      * @return OutputIt 写入最后一个元素之后的迭代器
+      */
+    template <typename OutputIt>
+    OutputIt query(const BBox<NUM_T>& range, OutputIt out) const
+    {
+        visit(range, [&out](const ELEM_T& e) { *out++ = e; });
+        return out;
+    }
+
+    /**
+      * @brief 四叉树中查询元素（粗查询），结果追加到容器末尾(不清空容器)
+      *
+      * @param range 包围盒范围
+      * @param result 结果容器
+      */
+    void query(const BBox<NUM_T>& range, std::vector<ELEM_T>& result) const
+    {
+        visit(range, [&result](const ELEM_T& e) { result.push_back(e); });
+    }
+
+    /**
+      * @brief 四叉树中查询元素（粗查询）
+      *
+      * @param range 包围盒范围
+      * @return std::vector<ELEM_T> 查找到的元素
+      */
+    std::vector<ELEM_T> query(const BBox<NUM_T>& range) const
+    {
+        std::vector<ELEM_T> result;
+        query(range, result);
         return result;
     }
 
+    /**
+      * @brief 统计与范围相交的元素数量，不分配内存
+      *
+      * @param range 包围盒范围
+      * @return size_t 元素数量
+      */
+    size_t count(const BBox<NUM_T>& range) const
+    {
+        size_t num = 0;
+        visit(range, [&num](const ELEM_T&) { ++num; });
+        return num;
+    }
+
     /**
       * @brief 更新四叉树中元素
       *
@@ -310,15 +487,12 @@ class QuadTree
         NUM_T mid_x = (_bbox.min_x + _bbox.max_x) / 2.0;
         NUM_T mid_y = (_bbox.min_y + _bbox.max_y) / 2.0;
 
-        // 创建四个子节点
-        _children[0] = std::make_shared<QuadTree<ELEM_T, NUM_T>>(BBox<NUM_T>{_bbox.min_x, mid_y, mid_x, _bbox.max_y},
-                                                                 _getBBox);  // 左上
-        _children[1] = std::make_shared<QuadTree<ELEM_T, NUM_T>>(BBox<NUM_T>{mid_x, mid_y, _bbox.max_x, _bbox.max_y},
-                                                                 _getBBox);  // 右上
-        _children[2] = std::make_shared<QuadTree<ELEM_T, NUM_T>>(BBox<NUM_T>{_bbox.min_x, _bbox.min_y, mid_x, mid_y},
-                                                                 _getBBox);  // 左下
-        _children[3] = std::make_shared<QuadTree<ELEM_T, NUM_T>>(BBox<NUM_T>{mid_x, _bbox.min_y, _bbox.max_x, mid_y},
-                                                                 _getBBox);  // 右下
+        // 创建四个子节点，子节点共用本节点的包围盒计算策略(不复制)
+        const Holder& holder = *this;
+        _children[0].reset(new QuadTree(BBox<NUM_T>{_bbox.min_x, mid_y, mid_x, _bbox.max_y}, holder));  // 左上
+        _children[1].reset(new QuadTree(BBox<NUM_T>{mid_x, mid_y, _bbox.max_x, _bbox.max_y}, holder));  // 右上
+        _children[2].reset(new QuadTree(BBox<NUM_T>{_bbox.min_x, _bbox.min_y, mid_x, mid_y}, holder));  // 左下
+        _children[3].reset(new QuadTree(BBox<NUM_T>{mid_x, _bbox.min_y, _bbox.max_x, mid_y}, holder));  // 右下
     }
 
     /**
@@ -328,6 +502,13 @@ class QuadTree
       * @return false 不是叶子节点
       */
     bool isLeaf() const { return _children[0] == nullptr; }
+
+    /**
+      * @brief 当前节点(不含子节点)存储的元素数量
+      *
+      * @return size_t 元素数量
+      */
+    size_t size() const { return _elem.size() + _spanElem.size(); }
 };
 
 #endif  // QUADTREE_H
\ No newline at end of file
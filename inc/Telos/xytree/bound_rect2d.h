@@ -1,6 +1,7 @@
 #ifndef BOUND_RECT2D_H
 #define BOUND_RECT2D_H
 
+#include <assert.h>
 #include <cfloat>
 #include <vector>
 
@@ -22,7 +23,23 @@ class BoundRect2D
     void setBound(const BoundRect2D* aSrcBound);
     void expandBound(const BoundRect2D* aSrcBound);
 
-    bool isDisjoint(const BoundRect2D* aSrcBound) const;
+    // 查询热点路径，内联实现
+    bool isDisjoint(const BoundRect2D* aSrcBound) const
+    {
+        assert(aSrcBound && aSrcBound->isValid());
+        return aSrcBound->mMinX > mMaxX || aSrcBound->mMaxX < mMinX || aSrcBound->mMinY > mMaxY ||
+               aSrcBound->mMaxY < mMinY;
+    }
+    // 两个矩形之间欧氏距离的平方(相交或接触时为0)
+    double getSqrDistance(const BoundRect2D* aSrcBound) const
+    {
+        assert(aSrcBound && aSrcBound->isValid());
+        double dx = aSrcBound->mMinX > mMaxX ? aSrcBound->mMinX - mMaxX
+                                              : (mMinX > aSrcBound->mMaxX ? mMinX - aSrcBound->mMaxX : 0.0);
+        double dy = aSrcBound->mMinY > mMaxY ? aSrcBound->mMinY - mMaxY
+                                              : (mMinY > aSrcBound->mMaxY ? mMinY - aSrcBound->mMaxY : 0.0);
+        return dx * dx + dy * dy;
+    }
     bool isContains(const BoundRect2D* aSrcBound) const;
     bool isEqual(const BoundRect2D* aSrcBound) const;
     bool isValid() const { return mMinX <= mMaxX && mMinY <= mMaxY; }
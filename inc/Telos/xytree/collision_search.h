@@ -1,32 +1,90 @@
 #ifndef COLLISION_SEARCH_H
 #define COLLISION_SEARCH_H
 
+#include "Telos/macros.h"
+#include "Telos/xytree/bound_rect2d.h"
+#include "Telos/xytree/xytree.h"
+
 #include <vector>
 
 namespace Telos
 {
 
+// 搜索栈中的一项: 待搜索的子树(树节点或树叶)
 class RXYTreeSearchItem
 {
    private:
-    void* mSearchAddr = nullptr;
-    bool mIsAreaArray = false;
+    const void* mSearchAddr = nullptr;  // 树节点或树叶地址
+    bool mIsAreaArray = false;          // 是否为树叶
+
+   public:
+    RXYTreeSearchItem() = default;
+    RXYTreeSearchItem(const void* aSearchAddr, bool bAreaArray) : mSearchAddr(aSearchAddr), mIsAreaArray(bAreaArray)
+    {
+    }
+
+    bool isAreaArray() const { return mIsAreaArray; }
+    const XYTreeNode* getNode() const { return mIsAreaArray ? nullptr : (const XYTreeNode*)mSearchAddr; }
+    const XYTreeLeaf* getLeaf() const { return mIsAreaArray ? (const XYTreeLeaf*)mSearchAddr : nullptr; }
 };
 
-class BoundRect2D;
-// RedEDA 搜索盒
-class RXYTreeSearchBox
+/**
+ * @brief RedEDA 搜索盒: 可暂停、可恢复的区域搜索游标
+ * 以显式栈代替递归遍历树，每次取出若干个与搜索区域相交的area，未取完的搜索状态保存在搜索盒中，
+ * 下次调用时从上次停止的位置继续；内存只与树深度相关，与结果数量无关。
+ * 遍历顺序与 RXYTree::search 相同。搜索过程中树不能被修改(增删area或重新平衡)，否则需要重新 begin。
+ */
+class TELOS_PUBLIC RXYTreeSearchBox
 {
    private:
-    std::vector<RXYTreeSearchItem> mSearchStack;
-    int mCurSearchIndex = 0;             // 当前搜索到的索引
-    BoundRect2D* mBoundRect = nullptr;  // 器件包围盒信息
+    std::vector<RXYTreeSearchItem> mSearchStack;  // 待搜索的子树
+    const XYTreeLeaf* mCurLeaf = nullptr;         // 当前正在搜索的树叶
+    int mCurSearchIndex = 0;                      // 当前树叶中正在检查的块的起始下标
+    unsigned int mCurMask = 0;                    // 当前块中尚未取出的相交area掩码
+    bool mFilterType = false;                     // 当前树叶中是否存在需要过滤掉的类型
+    BoundRect2D mBoundRect;                       // 搜索区域
+    XYTreeTypeMask mTypeMask;                     // 器件类型掩码
+
+   private:
+    // 将子树压入搜索栈(空子树、类型不符或包围盒不相交的子树直接跳过)
+    void pushChild(const XYTreeNode* node, XYTreeChildType aChildType);
+
+    // 从当前树叶中取出下一个相交的area，树叶搜索完时返回nullptr
+    ComponentArea* nextInLeaf();
 
    public:
     RXYTreeSearchBox();
     ~RXYTreeSearchBox();
+
+    /**
+     * @brief 开始一次新的搜索(丢弃上一次搜索未取完的结果)
+     * @param tree 被搜索的树
+     * @param srcRect 搜索区域
+     * @param aTypeMask 器件类型掩码，只返回类型位于掩码中的area
+     */
+    void begin(const RXYTree& tree, const BoundRect2D& srcRect, XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL);
+
+    /**
+     * @brief 取出下一个与搜索区域相交的area
+     * @return ComponentArea* 搜索结束时返回nullptr
+     */
+    ComponentArea* next();
+
+    /**
+     * @brief 取出至多 aCount 个与搜索区域相交的area，追加到数组中
+     * @param aCount 本次最多取出的area数
+     * @param resultArray 结果数组(不清空，结果追加在末尾)
+     * @return int 本次取出的area数，小于 aCount 表示搜索已结束
+     */
+    int next(int aCount, std::vector<ComponentArea*>& resultArray);
+
+    // 搜索是否已结束
+    bool isFinished() const { return nullptr == mCurLeaf && mSearchStack.empty(); }
+
+    // 结束搜索，释放搜索状态
+    void reset();
 };
 
 }  // namespace Telos
 
-#endif  // COLLISION_SEARCH_H
\ No newline at end of file
+#endif  // COLLISION_SEARCH_H
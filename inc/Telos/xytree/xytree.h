@@ -2,35 +2,40 @@
 #define XYTREE_H
 
 #include "Telos/macros.h"
+#include "Telos/xytree/bound_rect2d.h"
+#include "Telos/xytree/xytree_common.h"
+#include "Telos/xytree/xytree_mem_pool.h"
+#include "Telos/xytree/xytree_simd.h"
+#include "Telos/xytree/xytree_thread_pool.h"
 
 #include <assert.h>
+#include <functional>
+#include <type_traits>
 #include <vector>
 
 namespace Telos
 {
 
-#define XY_THRESHOLD 16  // 树叶中area列表的最大长度(推荐4-25，默认16)
+#define XY_PARALLEL_CUTOFF 4096   // 并行构建时，area数量不少于该值的子树作为独立任务构建
+#define XYTREE_INVALID_HANDLE -1  // 无效的器件区域句柄
 
-// XYTree子节点类型
-enum XYTreeChildType
-{
-    XYTREE_CHILD_LEFT = 0,  // 左节点
-    XYTREE_CHILD_MIDDLE,    // 中节点
-    XYTREE_CHILD_RIGHT,     // 右节点
-    XYTREE_CHILD_NUM,       // 表示数字3
-    XYTREE_CHILD_INVALID    // 无效的子节点类型
-};
+class ComponentArea;
+class XYTreeLeaf;
+
+// 器件区域句柄: RXYTree 分配的稠密整数，删除后可被复用
+typedef int XYTreeHandle;
+
+// 器件类型掩码: 第i位对应类型i(0<=i<63)，其余类型(负数或>=63)共用第63位，掩码无法区分这些类型
+typedef unsigned long long XYTreeTypeMask;
+#define XYTREE_TYPE_MASK_ALL (~0ULL)  // 接受所有类型
 
-// XYTree分割方向
-enum XYTreeSplitDirection
+inline XYTreeTypeMask xyTreeTypeBit(int aTypeId)
 {
-    XYTREE_SPLIT_X = 0,  // X轴向分割
-    XYTREE_SPLIT_Y,      // Y轴向分割
-    XYTREE_SPLIT_NUM,
-    XYTREE_SPLIT_INVALID  // 无效的分割方向
-};
+    return 1ULL << (aTypeId >= 0 && aTypeId < 63 ? aTypeId : 63);
+}
 
-class BoundRect2D;
+// 树叶中的area列表(从内存池中分配)
+typedef std::vector<ComponentArea*, XYTreeAllocator<ComponentArea*>> XYTreeAreaArray;
 
 // 器件信息
 class TELOS_PUBLIC ComponentArea
@@ -38,9 +43,12 @@ class TELOS_PUBLIC ComponentArea
    private:
     void* mCompGeoData;       // 原始器件几何信息
     unsigned int mCompId;     // 原始器件的ID唯一标识
-    BoundRect2D* mBoundRect;  // 器件的包围盒信息
+    BoundRect2D mBoundRect;   // 器件的包围盒信息
     int mTypeId;              // ud1:数据类型
     void* mAddr;              // ud2:节点地址
+    XYTreeHandle mHandle;     // 句柄(未加入RXYTree时为 XYTREE_INVALID_HANDLE)
+
+    friend class RXYTree;
 
    private:
     /**
@@ -52,7 +60,7 @@ class TELOS_PUBLIC ComponentArea
 
    public:
     ComponentArea();
-    ~ComponentArea();
+    ~ComponentArea() = default;
 
     /**
      * @brief 创建器件区域
@@ -67,19 +75,33 @@ class TELOS_PUBLIC ComponentArea
     static ComponentArea* createComponentArea(double minX, double minY, double maxX, double maxY, int typeId,
                                               void* userDef);
 
+    /**
+     * @brief 在内存池中创建器件区域
+     * @param memPool 内存池
+     * @param minX
+     * @param minY
+     * @param maxX
+     * @param maxY
+     * @param typeId 器件类型
+     * @param userDef 用户自定义行为
+     * @return ComponentArea* 器件区域
+     */
+    static ComponentArea* createComponentArea(XYTreeMemPool* memPool, double minX, double minY, double maxX,
+                                              double maxY, int typeId, void* userDef);
+
     /**
      * @brief 计算区域数组的总包围盒
      * @param areaArray 区域数组
      * @return BBox 总包围盒
      */
-    static BoundRect2D calcAreaArrayBound(const std::vector<ComponentArea*>& areaArray);
+    static BoundRect2D calcAreaArrayBound(const XYTreeAreaArray& areaArray);
 
     /**
      * @brief 打印器件信息
      * @param areaArray 器件区域数组
      * @param prefixInfo 前置信息
      */
-    static void print(const std::vector<ComponentArea*>& areaArray, const char* prefixInfo);
+    static void print(const XYTreeAreaArray& areaArray, const char* prefixInfo);
 
     /**
      * @brief 设置器件的原始信息
@@ -142,6 +164,41 @@ class TELOS_PUBLIC ComponentArea
      * @return true:相同 ｜ false:不相同
      */
     bool isEqual(const ComponentArea* otherArea) const;
+
+    /**
+     * @brief 获取器件区域句柄
+     * @return XYTreeHandle 句柄，未加入RXYTree时为 XYTREE_INVALID_HANDLE
+     */
+    XYTreeHandle getHandle() const { return mHandle; }
+};
+
+/**
+ * @brief 批量查询结果(CSR格式)
+ * 第i个查询的结果为 mAreaArray 中 [mOffsetArray[i], mOffsetArray[i+1]) 区间的器件区域
+ */
+struct XYTreeBatchResult
+{
+    std::vector<int> mOffsetArray;            // 各查询结果的起始偏移(长度为查询数+1)
+    std::vector<ComponentArea*> mAreaArray;  // 所有查询结果
+
+    int getQueryNum() const { return mOffsetArray.empty() ? 0 : (int)mOffsetArray.size() - 1; }
+    int getResultNum(int nQueryIndex) const { return mOffsetArray[nQueryIndex + 1] - mOffsetArray[nQueryIndex]; }
+    ComponentArea* const* getResult(int nQueryIndex) const { return mAreaArray.data() + mOffsetArray[nQueryIndex]; }
+    void clear()
+    {
+        mOffsetArray.clear();
+        mAreaArray.clear();
+    }
+};
+
+// 批量查询命中: (查询索引, 器件区域)
+typedef std::pair<int, ComponentArea*> XYTreeBatchHit;
+
+// 近邻查询结果
+struct XYTreeNeighbor
+{
+    ComponentArea* mArea;  // 器件区域
+    double mDistance;      // 与查询矩形的距离(相交时为0)
 };
 
 class XYTreeLeaf;
@@ -151,56 +208,154 @@ class XYTreeLeaf;
 class XYTreeNode
 {
    private:
-    BoundRect2D* mBBox;                   // 树节点包围盒
+    BoundRect2D mBBox;                    // 树节点包围盒
     XYTreeNode* mParent;                  // 父节点
     void* mChild[XYTREE_CHILD_NUM];       // 左中右三个子节点
     bool mIsAreaArray[XYTREE_CHILD_NUM];  // 左中右三个子节点中，每个子节点是否为叶子节点
     XYTreeSplitDirection mSplitDir;       // 是否按x轴向分割(默认x轴向分割)
     double mSplitPos;                     // 分割点位置
+    XYTreeTypeMask mTypeMask;             // 子树中所有area的类型掩码(与包围盒同步维护)
 
    private:
     void isValid() const;
 
-    // 查找子树中相交的Area区域
-    void searchChild(XYTreeChildType childIndex, const BoundRect2D& srcRect,
-                     std::vector<ComponentArea*>& resultArray) const;
+    // 获取指定子树的类型掩码(空子树为0)
+    XYTreeTypeMask getChildTypeMask(XYTreeChildType aChildType) const;
 
     // 打印子树
     void printChild(const char* pSpan, const char* pChildStr, XYTreeChildType childIndex, int nLevel);
 
+    // 按照 aSplitDir/aSplitPos 原地划分area数组，并递归构建左中右三个子树
+    // 尺寸不小于 aParallelCutoff 的子树在线程池 aThreadPool 中并行构建(aThreadPool为空时串行构建)
+    static XYTreeNode* splitAreaArray(XYTreeMemPool* aMemPool, ComponentArea** aAreaArray, int aAreaNum,
+                                      const BoundRect2D& aBound, XYTreeSplitDirection aSplitDir, double aSplitPos,
+                                      XYTreeThreadPool* aThreadPool, int aParallelCutoff);
+
    public:
     XYTreeNode();
-    ~XYTreeNode();
+    ~XYTreeNode() = default;
 
-    // 创建一个树节点
-    static XYTreeNode* createTreeNode(double aSplitPos, XYTreeSplitDirection aSplitDir = XYTREE_SPLIT_X);
+    // 在内存池中创建一个树节点
+    static XYTreeNode* createTreeNode(XYTreeMemPool* aMemPool, double aSplitPos,
+                                      XYTreeSplitDirection aSplitDir = XYTREE_SPLIT_X);
 
-    // 递归释放子节点，并根据需求释放树根自身
-    static void freeNodesWithoutArea(XYTreeNode** aNode, bool bFreeRoot);
+    // 递归释放子节点(内存归还内存池，但不释放area)，并根据需求释放树根自身
+    static void freeNodesWithoutArea(XYTreeMemPool* aMemPool, XYTreeNode** aNode, bool bFreeRoot);
 
     // 返回在树中搜索一颗n层树的大致时间log(n):返回值>=1，即使树的层树为0
-    static int getLogTime(int n);
+    static int getLogTime(int n) { return xyTreeLogTime(n); }
+
+    // 子树高度上限: 高度(树节点层数)超过该值的子树视为失衡，插入时需要重建
+    static int getHeightLimit(int nAreaNum, int nFactor) { return xyTreeHeightLimit(nAreaNum, nFactor); }
 
     // 重新平衡化XYTree(中的树叶)，按照整个包围盒中的中点划分左右子树，以便保持较高的搜索效率（不由使用者直接调用）
-    static void* rebalance(const XYTreeLeaf* aLeaf, bool& bOriginArray);
+    static void* rebalance(XYTreeMemPool* aMemPool, const XYTreeLeaf* aLeaf, bool& bOriginArray);
+
+    /**
+     * @brief 计算area数组的包围盒，并按X/Y方向最优值(figure of merit)选择分割方向和分割位置
+     * @param aAreaArray area数组
+     * @param aAreaNum area数量
+     * @param aBound 返回area数组的总包围盒
+     * @param aSplitDir 返回分割方向
+     * @param aSplitPos 返回分割位置
+     * @return true:需要分割 ｜ false:area数量不足或无法有效分割，应作为树叶
+     */
+    static bool chooseSplit(ComponentArea* const* aAreaArray, int aAreaNum, BoundRect2D& aBound,
+                            XYTreeSplitDirection& aSplitDir, double& aSplitPos);
+
+    /**
+     * @brief 在area数组上一次性构建平衡子树(数组会被原地重排)，复杂度O(nlogn)
+     * @param aMemPool 内存池
+     * @param aAreaArray area数组
+     * @param aAreaNum area数量(>0)
+     * @param bAreaArray 返回结果是否为树叶
+     * @param aThreadPool 线程池(为空时串行构建)
+     * @param aParallelCutoff area数量不少于该值的子树作为独立任务并行构建
+     * @return void* 子树根节点或树叶(父节点为空，由调用者挂接)
+     */
+    static void* buildSubTree(XYTreeMemPool* aMemPool, ComponentArea** aAreaArray, int aAreaNum, bool& bAreaArray,
+                              XYTreeThreadPool* aThreadPool = nullptr, int aParallelCutoff = XY_PARALLEL_CUTOFF);
+
+    void TreeAreaToArray(XYTreeAreaArray& dstAreaArray) const;
+
+    // 统计子树中的area数
+    int getAreaNum() const;
 
-    void TreeAreaToArray(std::vector<ComponentArea*>& dstAreaArray) const;
+    // 子树高度(树节点层数，只有树叶子树的节点为1)
+    int getHeight() const;
 
-    // 根据子节点的尺寸（假定每个子节点的包围盒已正确），重新计算当前节点的包围盒尺寸，并返回是否需要调整的标记
+    // 根据子节点的尺寸和类型掩码（假定每个子节点的均已正确），重新计算当前节点的包围盒和类型掩码，并返回是否发生变化
     bool adjustBoundBox();
 
-    // 拓展当前节点包围盒到树叶，并返回最终的子树类型
-    XYTreeNode* expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTreeChildType& childType);
+    // 从当前节点开始逐层向上重新计算包围盒和类型掩码，直到某一层不再变化
+    void adjustBoundToRoot();
 
-    // 获取指定包围盒所属的树叶，并返回最终的子树类型
+    // 返回指定子节点(树叶或树节点)在当前节点中的子树类型
+    XYTreeChildType getChildIndex(const void* aChild) const;
+
+    // 拓展当前节点包围盒和类型掩码到树叶，并返回最终的子树类型
+    XYTreeNode* expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTreeTypeMask aTypeMask,
+                                  XYTreeChildType& childType);
+
+    // 获取指定包围盒所属的树叶，并返回最终的子树类型；途经的子树为空(删除后)或树叶不存在时返回空
     XYTreeLeaf* getLeafWithBound(const BoundRect2D* srcBoundRect, XYTreeChildType& childType) const;
 
     // 判别 aSrcBound 属于哪个子树：aSrcBound在当前分割点的哪一侧
-    XYTreeChildType getChildType(const BoundRect2D* aSrcBound) const;
+    XYTreeChildType getChildType(const BoundRect2D* aSrcBound) const
+    {
+        assert(mBBox.isValid());
+        return getSplitSide(aSrcBound);
+    }
+
+    // 只按分割位置判别 aSrcBound 属于哪个子树，不要求当前节点非空(批量插入时节点包围盒尚未更新)
+    XYTreeChildType getSplitSide(const BoundRect2D* aSrcBound) const
+    {
+        assert(aSrcBound && aSrcBound->isValid());
+        switch (mSplitDir)
+        {
+            case XYTREE_SPLIT_X:  //X轴向分割
+                if (aSrcBound->getMaxX() < mSplitPos)
+                    return XYTREE_CHILD_LEFT;
+                else if (aSrcBound->getMinX() > mSplitPos)
+                    return XYTREE_CHILD_RIGHT;
+                else
+                    return XYTREE_CHILD_MIDDLE;
+            case XYTREE_SPLIT_Y:  //Y轴向分割
+                if (aSrcBound->getMaxY() < mSplitPos)
+                    return XYTREE_CHILD_LEFT;
+                else if (aSrcBound->getMinY() > mSplitPos)
+                    return XYTREE_CHILD_RIGHT;
+                else
+                    return XYTREE_CHILD_MIDDLE;
+            default:
+                assert(false);
+        }
+        return XYTREE_CHILD_INVALID;
+    }
 
     // 向指定的子树area列表中添加一个器件area
-    const BoundRect2D* addLeafArea(XYTreeChildType aChildType, ComponentArea* area);
+    const BoundRect2D* addLeafArea(XYTreeMemPool* aMemPool, XYTreeChildType aChildType, ComponentArea* area);
+
+    // 将一个已构建好的树叶挂到指定的空子树上
+    void attachLeaf(XYTreeChildType aChildType, XYTreeLeaf* aLeaf);
 
+    // 对指定子树的树叶原地执行 rebalance 分裂，返回是否分裂成功(失败时树叶保持不变)
+    bool splitLeaf(XYTreeMemPool* aMemPool, XYTreeChildType aChildType);
+
+    /**
+     * @brief 在指定子树的所有area上重新构建该子树(原子树的节点和树叶释放，area保留)，并逐层向上调整包围盒
+     * @param aMemPool 内存池
+     * @param aChildType 子树类型(子树为树节点)
+     * @param aThreadPool 线程池(为空时串行构建)
+     * @param aParallelCutoff area数量不少于该值的子树作为独立任务并行构建
+     */
+    void rebuildChild(XYTreeMemPool* aMemPool, XYTreeChildType aChildType, XYTreeThreadPool* aThreadPool,
+                      int aParallelCutoff);
+
+    // 将指定子树的空树叶从树中摘除并释放
+    void removeEmptyLeaf(XYTreeMemPool* aMemPool, XYTreeChildType aChildType);
+
+    // 按包围盒和用户数据查找并删除area(不维护 RXYTree 的句柄目录，RXYTree 使用 deleteComponentArea)
     bool deleteArea(const ComponentArea* srcArea);
 
     bool isFindArea(const ComponentArea* srcArea) const;
@@ -211,6 +366,13 @@ class XYTreeNode
         return mIsAreaArray[aChildType];
     }
 
+    XYTreeLeaf* getChildLeaf(XYTreeChildType aChildType) const
+    {
+        if (!isChildAreaArray(aChildType))
+            return nullptr;
+        return (XYTreeLeaf*)(mChild[aChildType]);
+    }
+
     XYTreeNode* getChildNode(XYTreeChildType aChildType) const
     {
         if (isChildAreaArray(aChildType))
@@ -222,10 +384,49 @@ class XYTreeNode
     XYTreeNode* getParent() { return mParent; }
     const XYTreeNode* getParent() const { return mParent; }
 
-    BoundRect2D* getBoundRect() { return mBBox; }
-    const BoundRect2D* getBoundRect() const { return mBBox; }
+    BoundRect2D* getBoundRect() { return &mBBox; }
+    const BoundRect2D* getBoundRect() const { return &mBBox; }
+
+    XYTreeTypeMask getTypeMask() const { return mTypeMask; }
+
+    XYTreeSplitDirection getSplitDir() const { return mSplitDir; }
+    double getSplitPos() const { return mSplitPos; }
 
     void search(const BoundRect2D& srcRect, std::vector<ComponentArea*>& resultArray) const;
+
+    /**
+     * @brief 批量搜索: 多个查询区域共同向下遍历，每个节点和树叶在一次批量搜索中只访问一次
+     * @param aRectArray 所有查询区域
+     * @param aQueryArray 当前子树的候选查询索引
+     * @param aQueryNum 候选查询数
+     * @param nDepth 当前节点深度
+     * @param levelArray 每层一个查询索引工作数组(按需扩展，同层节点复用)
+     * @param hitArray 命中结果(按遍历顺序追加)
+     */
+    void searchBatch(const BoundRect2D* aRectArray, const int* aQueryArray, int aQueryNum, int nDepth,
+                     std::vector<std::vector<int>>& levelArray, std::vector<XYTreeBatchHit>& hitArray) const;
+
+    /**
+     * @brief 最近邻搜索(best-first): 按包围盒到查询矩形的距离从近到远扩展节点、树叶和area，不枚举整个窗口
+     * @param srcRect 查询矩形
+     * @param aCount 最多返回的area数，<=0 表示不限数量
+     * @param aMaxDist 最大距离(含)
+     * @param aTypeMask 器件类型掩码
+     * @param resultArray 返回按距离从近到远排序的结果(先清空)
+     */
+    void searchNearest(const BoundRect2D& srcRect, int aCount, double aMaxDist, XYTreeTypeMask aTypeMask,
+                       std::vector<XYTreeNeighbor>& resultArray) const;
+
+    /**
+     * @brief 搜索与 srcRect 相交的area，对每个area调用访问者(无堆分配)
+     * @param srcRect 搜索区域
+     * @param visitor 访问者: bool(ComponentArea*) 返回false时停止搜索；也可以返回void
+     * @param aTypeMask 器件类型掩码: 类型掩码与之不相交的子树整体跳过
+     * @return true:搜索完成 ｜ false:被访问者提前停止
+     */
+    template <typename Visitor>
+    bool search(const BoundRect2D& srcRect, Visitor&& visitor, XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
     void print(const char* pSpan, int nLevel);
 };
 
@@ -233,59 +434,793 @@ class XYTreeNode
 class XYTreeLeaf
 {
    private:
-    BoundRect2D* mBoundRect;  //树节点的包围盒信息
-    XYTreeNode* mParent;      //父节点
-    std::vector<ComponentArea*> mAreaArray;
+    BoundRect2D mBoundRect;      //树节点的包围盒信息
+    XYTreeNode* mParent;         //父节点
+    XYTreeAreaArray mAreaArray;  //area列表(从内存池中分配)
+    XYTreeRectArray mRectArray;  //与area列表一一对应的包围盒坐标(SoA布局，供SIMD过滤)
+    XYTreeTypeMask mTypeMask;    //树叶中所有area的类型掩码
+    int mSplitLimit;             //插入时的分裂门限: area数超过该值才尝试分裂(分裂失败时加倍)
+
+   private:
+    void calcTypeMask();  //重新计算类型掩码
 
    public:
-    XYTreeLeaf(XYTreeNode* aParent);
+    XYTreeLeaf(XYTreeNode* aParent, XYTreeMemPool* aMemPool = nullptr);
     ~XYTreeLeaf();
 
     const BoundRect2D* addArea(ComponentArea* area);
     void deleteArea(const ComponentArea* srcArea);
-    BoundRect2D* adjustBoundBox();  //重新完整计算包围盒尺寸
-    void expandBoundToLeaf(const BoundRect2D* srcBoundRect);
+
+    // 移除指定槽位的area(不释放area)，最后一个area移入该槽位；返回树叶包围盒或类型掩码是否发生变化
+    bool removeArea(int aSlot);
+
+    // 移除多个槽位的area(不释放area，槽位须降序排列)，包围盒和类型掩码只重新计算一次；返回是否发生变化
+    bool removeAreaBatch(const int* aSlotArray, int aSlotNum);
+
+    // 将指定槽位area的包围盒修改为 aNewRect，返回树叶包围盒是否发生变化
+    bool updateArea(int aSlot, const BoundRect2D& aNewRect);
+
+    // 判断包围盒 aSrcBound 按各祖先节点的分割位置向下查找时，是否仍落在当前树叶
+    bool isRouteTo(const BoundRect2D& aSrcBound) const;
+    BoundRect2D* adjustBoundBox();  //重新完整计算包围盒尺寸和类型掩码
+    void expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTreeTypeMask aTypeMask);
     void removeAreaArray(bool bDelete);
-    void TreeAreaToArray(std::vector<ComponentArea*>& dstAreaArray, bool bRemove);
+    void TreeAreaToArray(XYTreeAreaArray& dstAreaArray, bool bRemove);
 
     void getJointArea(const BoundRect2D& srcRect, std::vector<ComponentArea*>& resultArray) const;
-    std::vector<ComponentArea*>& getAreaArray() { return mAreaArray; }
-    const std::vector<ComponentArea*>& getAreaArray() const { return mAreaArray; }
+
+    // 批量求交: 对 aQueryArray 中的每个查询，将与之相交的area追加到命中结果
+    void getJointAreaBatch(const BoundRect2D* aRectArray, const int* aQueryArray, int aQueryNum,
+                           std::vector<XYTreeBatchHit>& hitArray) const;
+
+    // 对树叶中与 srcRect 相交且类型位于 aTypeMask 中的每个area调用访问者，返回false表示访问者要求停止
+    template <typename Visitor>
+    bool visitJointArea(const BoundRect2D& srcRect, Visitor&& visitor,
+                        XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+    // area列表与 mRectArray 必须保持同步，因此只提供只读访问
+    const XYTreeAreaArray& getAreaArray() const { return mAreaArray; }
+
+    const XYTreeRectArray& getRectArray() const { return mRectArray; }
+
+    // 获取树叶所属的内存池(与area列表共用同一个内存池)
+    XYTreeMemPool* getMemPool() const { return mAreaArray.get_allocator().getMemPool(); }
 
     XYTreeNode* getParent() { return mParent; }
     const XYTreeNode* getParent() const { return mParent; }
+    void setParent(XYTreeNode* aParent) { mParent = aParent; }
+
+    int getSplitLimit() const { return mSplitLimit; }
+    void setSplitLimit(int aSplitLimit) { mSplitLimit = aSplitLimit; }
+
+    // 用给定的area数组和包围盒替换树叶内容
+    void setAreaArray(ComponentArea* const* aAreaArray, int aAreaNum, const BoundRect2D& aBound);
 
-    BoundRect2D* getBoundRect() { return mBoundRect; }
-    const BoundRect2D* getBoundRect() const { return mBoundRect; }
+    BoundRect2D* getBoundRect() { return &mBoundRect; }
+    const BoundRect2D* getBoundRect() const { return &mBoundRect; }
+
+    XYTreeTypeMask getTypeMask() const { return mTypeMask; }
 
     void print(const char* pszPrefix) const;
 
 };  //end of class RXYTreeLeaf
 
+// 遍历(空间连接、迭代搜索)中的子树: 树节点或树叶
+struct XYTreeJoinItem
+{
+    const void* mPtr;  // XYTreeNode* 或 XYTreeLeaf*
+    bool mIsLeaf;      // 是否为树叶
+
+    const BoundRect2D* getBoundRect() const
+    {
+        return mIsLeaf ? ((const XYTreeLeaf*)mPtr)->getBoundRect() : ((const XYTreeNode*)mPtr)->getBoundRect();
+    }
+};
+
+// 空间连接任务: 一棵子树的自连接或两棵子树之间的连接
+struct XYTreeJoinTask
+{
+    XYTreeJoinItem mItem1;
+    XYTreeJoinItem mItem2;
+    bool mIsSelf;  // true:mItem1的自连接 | false:mItem1与mItem2的连接
+};
+
+// 空间连接的器件区域对回调(并行连接时在多个线程中被并发调用)
+typedef std::function<void(ComponentArea*, ComponentArea*)> XYTreePairCallback;
+
 //RedEDA XYTree: 存放树根等相关信息
+//线程安全: 所有const查询方法不修改树的任何状态(无缓存、无惰性计算)。调用 freeze() 冻结后，修改接口均被拒绝，
+//此时可以在任意多个线程中无锁并发查询；未冻结时，查询与修改不能并发执行。
 class TELOS_PUBLIC RXYTree
 {
 
    private:
-    XYTreeNode* mRootNode;  //树根节点
-                            //void* mMemPool = nullptr; //内存池: 保留, 暂不用
+    // 句柄目录项: 句柄对应的area及其所在的树叶和槽位
+    struct AreaEntry
+    {
+        ComponentArea* mArea;  //为空表示句柄未使用
+        XYTreeLeaf* mLeaf;     //所在树叶；批量修改中待插入的area为空
+        int mSlot;             //在树叶area列表中的下标；批量修改中待插入的area为在待插入列表中的下标
+        bool mIsDeleted;       //批量修改中已删除，提交时从树中移除
+    };
+
+    XYTreeNode* mRootNode;          //树根节点
+    XYTreeMemPool* mMemPool;        //内存池: 树节点和树叶(含area列表)从中分配，rebalance 时整体替换
+    XYTreeMemPool* mAreaPool;       //area内存池: area地址在 rebalance 后保持不变
+    XYTreeThreadPool* mThreadPool;  //线程池: 为空时串行构建
+    int mParallelCutoff;            //并行构建时，area数量不少于该值的子树作为独立任务构建
+    int mLeafSplitFactor;           //树叶中area数超过 XY_THRESHOLD 的该倍数后原地分裂
+    int mRebuildDepthFactor;        //子树高度超过 该倍数*log2(area数/XY_THRESHOLD) 时重建(scapegoat)
+    bool mIsFrozen;                 //是否冻结(只读)
+    std::vector<AreaEntry> mAreaDirectory;       //句柄目录: 句柄 -> (area, 树叶, 槽位)
+    std::vector<XYTreeHandle> mFreeHandleArray;  //已释放、可复用的句柄
+    bool mIsInBatch;                              //是否处于批量修改中
+    std::vector<ComponentArea*> mBatchAddArray;   //批量修改中待插入的area(插入后又被删除的为空)
+    std::vector<XYTreeHandle> mBatchDeleteArray;  //批量修改中待删除的句柄
 
    private:
     bool addAreaToTree(ComponentArea* area);
+    void rebuildUnbalancedAncestor(XYTreeNode* aNode);  //树叶分裂使树过深时，重建 aNode 最低的失衡祖先子树
+    void removeAreaFromTree(XYTreeHandle aHandle);  //将area从所属树叶中移除(不释放area)，并调整包围盒
+    XYTreeHandle allocHandle(ComponentArea* area);   //为area分配句柄
+    void updateDirectory(XYTreeLeaf* aLeaf);          //登记树叶中所有area的(树叶, 槽位)
+    void updateDirectory(XYTreeNode* aNode);          //登记子树中所有area的(树叶, 槽位)
+    bool buildRootNode(ComponentArea** aAreaArray, int aAreaNum);  //在area数组上构建整棵树
+    void commitBatchDelete(std::vector<XYTreeNode*>& dirtyArray);  //按树叶分组删除，记录需要调整包围盒的节点
+    void commitBatchAdd(std::vector<XYTreeNode*>& dirtyArray);     //按目标树叶分组插入，记录需要调整包围盒的节点
+    // 将area数组按分割位置逐层划分到子树(aBufArray 为同样长度的划分缓冲区)，每个树叶一次性追加
+    void commitBatchAdd(XYTreeNode* aNode, ComponentArea** aAreaArray, ComponentArea** aBufArray, int aAreaNum,
+                        std::vector<XYTreeNode*>& dirtyArray);
 
    public:
     RXYTree();
     ~RXYTree();
 
+    /**
+     * @brief 批量构建: 从连续的包围盒数组一次性构建平衡树
+     * @param aRectArray 器件包围盒数组
+     * @param aAddrArray 器件地址数组(可为空)
+     * @param aCount 器件数量
+     * @param aTypeIdArray 器件类型数组(可为空，默认类型为-1)
+     */
+    RXYTree(const BoundRect2D* aRectArray, void* const* aAddrArray, int aCount, const int* aTypeIdArray = nullptr);
+
+    RXYTree(const RXYTree&) = delete;
+    RXYTree& operator=(const RXYTree&) = delete;
+
     void createTree(double aSplitPos, XYTreeSplitDirection aSplitDir = XYTREE_SPLIT_X);  //创建一颗XYTree
-    bool addComponentArea(double aMinX, double aMinY, double aMaxX, double aMaxY, int aTypeId, void* aAddr);
-    bool rebalance();  //重新平衡化整棵树
+
+    /**
+     * @brief 添加器件区域
+     * @return XYTreeHandle 器件区域句柄，在删除该区域或 clear/bulkLoad 之前保持有效(rebalance不影响句柄)；
+     *         失败时返回 XYTREE_INVALID_HANDLE
+     */
+    XYTreeHandle addComponentArea(double aMinX, double aMinY, double aMaxX, double aMaxY, int aTypeId, void* aAddr);
+
+    /**
+     * @brief 删除器件区域，并释放该区域(O(1)定位，句柄随后可被复用)
+     * @param aHandle addComponentArea 返回的句柄
+     * @return true:删除成功 ｜ false:树已冻结或句柄无效
+     */
+    bool deleteComponentArea(XYTreeHandle aHandle);
+
+    /**
+     * @brief 移动器件区域(句柄保持不变)
+     * 新包围盒仍落在原树叶时只更新该树叶(树叶包围盒变化时逐层向上调整祖先包围盒)，否则从原树叶移除后重新插入
+     * @param aHandle addComponentArea 返回的句柄
+     * @return true:更新成功 ｜ false:树已冻结或句柄无效
+     */
+    bool updateComponentArea(XYTreeHandle aHandle, double aMinX, double aMinY, double aMaxX, double aMaxY);
+
+    // 判断句柄对应的器件区域是否在树中(批量修改中待插入的视为在树中，已删除的视为不在树中)
+    bool isIndexed(XYTreeHandle aHandle) const
+    {
+        return aHandle >= 0 && aHandle < (int)mAreaDirectory.size() && mAreaDirectory[aHandle].mArea &&
+               !mAreaDirectory[aHandle].mIsDeleted;
+    }
+
+    // 获取句柄对应的器件区域，句柄无效时返回空
+    ComponentArea* getComponentArea(XYTreeHandle aHandle) const
+    {
+        return isIndexed(aHandle) ? mAreaDirectory[aHandle].mArea : nullptr;
+    }
+    bool rebalance();  //重新平衡化整棵树(树节点和树叶在新内存池中重建，句柄和 ComponentArea* 不变)
+
+    /**
+     * @brief 开始批量修改: 之后的 addComponentArea/deleteComponentArea 立即分配/作废句柄，但只登记修改，
+     * 在 commitBatch 时一次性应用到树上。提交前，查询看不到新增的area，仍可能返回已删除的area；
+     * 批量修改中的 updateComponentArea 对待插入的area只修改其包围盒，对树中的area立即生效
+     * @return true:开始成功 ｜ false:树已冻结或已处于批量修改中
+     */
+    bool beginBatch();
+
+    /**
+     * @brief 提交批量修改: 先按树叶分组删除，再按目标树叶分组插入，最后自底向上对每个受影响的节点只重新计算一次
+     * 包围盒和类型掩码；插入后超过分裂门限的树叶在提交中原地重新平衡化
+     * @return true:提交成功 ｜ false:未处于批量修改中或树已冻结
+     */
+    bool commitBatch();
+
+    bool isInBatch() const { return mIsInBatch; }
+
+    /**
+     * @brief 批量构建: 清空当前树，并从连续的包围盒数组一次性构建平衡树(不经过未平衡的中间树)，复杂度O(nlogn)
+     * 第i个器件的句柄为i
+     * @param aRectArray 器件包围盒数组
+     * @param aAddrArray 器件地址数组(可为空)
+     * @param aCount 器件数量
+     * @param aTypeIdArray 器件类型数组(可为空，默认类型为-1)
+     * @return true:构建出平衡树 ｜ false:器件数量不足，所有器件存放在根节点的树叶中；
+     *         树已冻结或处于批量修改中时不做任何修改，也返回false
+     */
+    bool bulkLoad(const BoundRect2D* aRectArray, void* const* aAddrArray, int aCount,
+                  const int* aTypeIdArray = nullptr);
+    /**
+     * @brief 设置构建(rebalance/bulkLoad)使用的线程数
+     * @param aThreadNum 线程数: 1为串行构建，<=0 使用硬件线程数
+     */
+    void setThreadNum(int aThreadNum);
+    int getThreadNum() const;
+
+    /**
+     * @brief 设置并行构建的子树尺寸门限
+     * @param aParallelCutoff area数量不少于该值的子树作为独立任务构建
+     */
+    void setParallelCutoff(int aParallelCutoff);
+
+    /**
+     * @brief 设置插入时树叶原地分裂的倍数
+     * @param aLeafSplitFactor 树叶中area数超过 XY_THRESHOLD*aLeafSplitFactor 时对该树叶执行rebalance分裂，0表示不分裂
+     */
+    void setLeafSplitFactor(int aLeafSplitFactor);
+
+    /**
+     * @brief 设置插入时重建失衡子树的高度倍数(scapegoat)
+     * @param aRebuildDepthFactor 树叶分裂后树的高度超过 aRebuildDepthFactor*log2(area数/XY_THRESHOLD) 时，
+     * 从新节点向上找到最低的、高度超过该上限(按其自身area数计算)的祖先，原地重建其子树；0表示不重建
+     */
+    void setRebuildDepthFactor(int aRebuildDepthFactor);
+
+    const XYTreeNode* getRootNode() const { return mRootNode; }
+
+    // 树占用的内存字节数(含并行构建时接管的子内存池)
+    size_t getMemoryBytes() const { return mMemPool->getBlockBytes() + mAreaPool->getBlockBytes(); }
+
     void print();
-    std::vector<ComponentArea*> getCollideAreaArray(double aMinX, double aMinY, double aMaxX,
-                                                    double aMaxY);  //返回和指定矩形区碰撞的器件区域列表
+    bool clear();  //一次性释放整棵树(归还内存池)，树已冻结或处于批量修改中时不做任何修改并返回false
+    std::vector<ComponentArea*> getCollideAreaArray(
+        double aMinX, double aMinY, double aMaxX, double aMaxY,
+        XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;  //返回和指定矩形区碰撞的器件区域列表
+
+    /**
+     * @brief 将和指定矩形区碰撞的器件区域追加到调用者提供的(可复用)数组中
+     * @param resultArray 结果数组(不清空，结果追加在末尾)
+     * @param aTypeMask 器件类型掩码，只返回类型位于掩码中的器件区域(不含这些类型的子树整体跳过)
+     * @return int 追加的器件区域数
+     */
+    int getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                            std::vector<ComponentArea*>& resultArray,
+                            XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
+    // 判断指定矩形区内是否存在类型位于掩码中的碰撞器件区域(找到第一个即停止)
+    bool isCollide(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                   XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
+    // 返回和指定矩形区碰撞的第一个类型位于掩码中的器件区域，不存在时返回空
+    ComponentArea* getFirstCollideArea(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                                       XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
+    /**
+     * @brief k近邻查询: 返回距离查询矩形最近的 aCount 个器件区域(矩形间欧氏距离，相交时为0)
+     * @param srcRect 查询矩形(点查询时为退化矩形)
+     * @param aCount 最多返回的器件区域数，<=0 表示返回 aMaxDist 内的全部器件区域
+     * @param resultArray 返回按距离从近到远排序的结果(先清空)
+     * @param aMaxDist 最大搜索距离(含)
+     * @param aTypeMask 器件类型掩码，只返回类型位于掩码中的器件区域
+     * @return int 结果数
+     */
+    int getNearestAreaArray(const BoundRect2D& srcRect, int aCount, std::vector<XYTreeNeighbor>& resultArray,
+                            double aMaxDist = DBL_MAX, XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
+    /**
+     * @brief 返回距离查询矩形最近的器件区域
+     * @param aDistance 返回最近距离(可为空)
+     * @return ComponentArea* 最近的器件区域，aMaxDist 内不存在时返回空
+     */
+    ComponentArea* getNearestArea(const BoundRect2D& srcRect, double* aDistance = nullptr, double aMaxDist = DBL_MAX,
+                                  XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
+    /**
+     * @brief 批量查询: 查询区域按空间顺序(Morton码)排序后共同向下遍历，每个节点和树叶在一批查询中只访问一次
+     * @param aRectArray 查询区域数组
+     * @param aCount 查询数
+     * @param result 返回CSR格式结果，查询顺序与 aRectArray 一致，每个查询内的结果顺序与单次查询一致
+     */
+    void getCollideAreaBatch(const BoundRect2D* aRectArray, int aCount, XYTreeBatchResult& result) const;
+
+    /**
+     * @brief 并行批量查询: 查询列表切分后在线程池中执行批量查询，各线程结果独立存放，最后无竞争地合并；
+     * 树未冻结时不能保证并发只读访问，在调用线程中串行执行
+     * @param aRectArray 查询区域数组
+     * @param aCount 查询数
+     * @param result 返回CSR格式结果，与 getCollideAreaBatch 的结果完全一致
+     */
+    void getCollideAreaBatchParallel(const BoundRect2D* aRectArray, int aCount, XYTreeBatchResult& result) const;
+
+    /**
+     * @brief 冻结整棵树: 冻结后拒绝所有修改(返回false)，保证多线程无锁只读访问
+     */
+    void freeze() { mIsFrozen = true; }
+    void unfreeze() { mIsFrozen = false; }
+    bool isFrozen() const { return mIsFrozen; }
+
+    /**
+     * @brief 搜索和指定矩形区碰撞的器件区域，对每个区域调用访问者(无堆分配)
+     * @param srcRect 搜索区域
+     * @param visitor 访问者: bool(ComponentArea*) 返回false时停止搜索；也可以返回void
+     * @param aTypeMask 器件类型掩码，只访问类型位于掩码中的器件区域(不含这些类型的子树整体跳过)
+     * @return true:搜索完成 ｜ false:被访问者提前停止
+     */
+    template <typename Visitor>
+    bool search(const BoundRect2D& srcRect, Visitor&& visitor, XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const
+    {
+        if (nullptr == mRootNode)
+            return true;
+        return mRootNode->search(srcRect, visitor, aTypeMask);
+    }
+
+    /**
+     * @brief 自连接: 找出树中所有相交的器件区域对，每个无序对只报告一次
+     * 成对地同时遍历子树: 左右子树的area位于分割位置两侧互不相交，只需连接 左-中、中-右 子树
+     * @param visitor 访问者: bool(ComponentArea*, ComponentArea*) 返回false时停止；也可以返回void
+     * @param aClearance 外扩距离(>=0): 其中一个包围盒在各方向外扩 aClearance 后与另一个相交即报告，
+     * 即两个包围盒在X、Y方向上的间距均不超过 aClearance
+     * @return true:连接完成 ｜ false:被访问者提前停止
+     */
+    template <typename Visitor>
+    bool selfJoin(Visitor&& visitor, double aClearance = 0.0) const;
+
+    /**
+     * @brief 并行自连接: 树的上层展开为相互独立的连接任务后在线程池中执行；树未冻结时在调用线程中串行执行
+     * @param callback 回调，会在多个线程中被并发调用，调用者需保证其线程安全
+     * @param aClearance 外扩距离(>=0)，含义同 selfJoin
+     */
+    void selfJoinParallel(const XYTreePairCallback& callback, double aClearance = 0.0) const;
+
+    /**
+     * @brief 两棵树的空间连接: 找出所有相交的器件区域对(a, b)，a属于本树，b属于 otherTree
+     * 同时遍历两棵树，包围盒(外扩后)不相交的子树对直接剪枝
+     * @param otherTree 另一棵树(不同层或不同类别的器件)
+     * @param visitor 访问者: bool(ComponentArea* a, ComponentArea* b) 返回false时停止；也可以返回void
+     * @param aClearance 外扩距离(>=0): 其中一个包围盒在各方向外扩 aClearance 后与另一个相交即报告，
+     * 即两个包围盒在X、Y方向上的间距均不超过 aClearance
+     * @return true:连接完成 ｜ false:被访问者提前停止
+     */
+    template <typename Visitor>
+    bool join(const RXYTree& otherTree, Visitor&& visitor, double aClearance = 0.0) const;
+
+    /**
+     * @brief 并行的两棵树空间连接，使用本树的线程池；任一棵树未冻结时在调用线程中串行执行
+     * @param otherTree 另一棵树
+     * @param callback 回调(a属于本树，b属于 otherTree)，会在多个线程中被并发调用，调用者需保证其线程安全
+     * @param aClearance 外扩距离(>=0)，含义同 join
+     */
+    void joinParallel(const RXYTree& otherTree, const XYTreePairCallback& callback, double aClearance = 0.0) const;
 
 };  //end of class REDALGO_CPP_PUBLIC RXYTree
 
+// 调用访问者，返回值为void的访问者视为总是继续
+template <typename Visitor>
+inline bool xyTreeVisit(Visitor& visitor, ComponentArea* area)
+{
+    if constexpr (std::is_void<decltype(visitor(area))>::value)
+    {
+        visitor(area);
+        return true;
+    }
+    else
+    {
+        return visitor(area);
+    }
+}
+
+// 将访问到的area追加到数组的访问者
+class XYTreeAppendVisitor
+{
+   private:
+    std::vector<ComponentArea*>& mResultArray;
+
+   public:
+    explicit XYTreeAppendVisitor(std::vector<ComponentArea*>& resultArray) : mResultArray(resultArray) {}
+    bool operator()(ComponentArea* area)
+    {
+        mResultArray.push_back(area);
+        return true;
+    }
+};
+
+template <typename Visitor>
+inline bool XYTreeLeaf::visitJointArea(const BoundRect2D& srcRect, Visitor&& visitor,
+                                       XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    if (0 == (mTypeMask & aTypeMask) || srcRect.isDisjoint(&mBoundRect))  // 若不含所需类型或包围盒不相交
+    {
+        return true;
+    }
+    const bool bFilterType = (mTypeMask & ~aTypeMask) != 0;  //树叶中存在需要过滤掉的类型
+
+    // 按块计算相交掩码，仅对命中的area解引用
+    for (int nBlock = 0, nBlockNum = mRectArray.getBlockNum(); nBlock < nBlockNum; ++nBlock)
+    {
+        int nBegin = nBlock * XY_SIMD_BLOCK;
+        unsigned int nMask = xyTreeOverlapMask(mRectArray, nBegin, srcRect);
+        while (nMask)
+        {
+            ComponentArea* area = mAreaArray[nBegin + xyTreeLowestBit(nMask)];
+            assert(area);
+            nMask &= nMask - 1;
+            if (bFilterType && !(aTypeMask & xyTreeTypeBit(area->getTypeId())))
+            {
+                continue;
+            }
+            if (!xyTreeVisit(visitor, area))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+inline bool XYTreeNode::search(const BoundRect2D& srcRect, Visitor&& visitor,
+                               XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    if (0 == (mTypeMask & aTypeMask) || mBBox.isDisjoint(&srcRect))  //子树中不含所需类型或包围盒不相交
+    {
+        return true;
+    }
+
+    // 显式栈遍历: 每个节点筛选出需要遍历的子树(包围盒相交且含所需类型)，第一个直接进入，其余逆序入栈，
+    // 访问顺序与递归遍历相同；测试子树前先预取所有候选子树的包围盒(树节点和树叶的第一个成员)
+    XYTreeSmallStack<XYTreeJoinItem> stack;
+    XYTreeJoinItem item{this, false};
+    while (true)
+    {
+        if (item.mIsLeaf)
+        {
+            if (!((const XYTreeLeaf*)item.mPtr)->visitJointArea(srcRect, visitor, aTypeMask))
+                return false;
+            if (stack.empty())
+                return true;
+            item = stack.pop();
+            continue;
+        }
+
+        // 根据当前树节点的coord，以及给定的区域范围，判别当前区域属于左中右哪个子节点；中子树总是需要遍历
+        const XYTreeNode* node = (const XYTreeNode*)item.mPtr;
+        XYTreeChildType childType = node->getChildType(&srcRect);
+        bool bVisit[XYTREE_CHILD_NUM] = {XYTREE_CHILD_RIGHT != childType, true, XYTREE_CHILD_LEFT != childType};
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            if (bVisit[i] && node->mChild[i])
+                XY_PREFETCH(node->mChild[i]);
+        }
+
+        XYTreeJoinItem childArray[XYTREE_CHILD_NUM];
+        int nChildNum = 0;
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            const void* child = node->mChild[i];
+            if (!bVisit[i] || nullptr == child)
+                continue;
+            if (node->mIsAreaArray[i])
+            {
+                const XYTreeLeaf* leaf = (const XYTreeLeaf*)child;
+                if (0 == (leaf->getTypeMask() & aTypeMask) || srcRect.isDisjoint(leaf->getBoundRect()))
+                    continue;
+            }
+            else
+            {
+                const XYTreeNode* childNode = (const XYTreeNode*)child;
+                if (0 == (childNode->mTypeMask & aTypeMask) || childNode->mBBox.isDisjoint(&srcRect))
+                    continue;
+            }
+            childArray[nChildNum++] = XYTreeJoinItem{child, node->mIsAreaArray[i]};
+        }
+
+        if (0 == nChildNum)
+        {
+            if (stack.empty())
+                return true;
+            item = stack.pop();
+            continue;
+        }
+        for (int i = nChildNum - 1; i > 0; --i)
+        {
+            stack.push(childArray[i]);
+        }
+        item = childArray[0];
+    }
+}
+
+// 调用器件区域对访问者，返回值为void的访问者视为总是继续
+template <typename Visitor>
+inline bool xyTreeVisitPair(Visitor& visitor, ComponentArea* area1, ComponentArea* area2)
+{
+    if constexpr (std::is_void<decltype(visitor(area1, area2))>::value)
+    {
+        visitor(area1, area2);
+        return true;
+    }
+    else
+    {
+        return visitor(area1, area2);
+    }
+}
+
+// 包围盒在各方向外扩 aClearance
+inline BoundRect2D xyTreeInflate(const BoundRect2D& rect, double aClearance)
+{
+    return BoundRect2D(rect.getMinX() - aClearance, rect.getMinY() - aClearance, rect.getMaxX() + aClearance,
+                       rect.getMaxY() + aClearance);
+}
+
+// 获取树节点的指定子树，子树为空时返回false
+inline bool xyTreeGetJoinChild(const XYTreeNode* node, XYTreeChildType aChildType, XYTreeJoinItem& item)
+{
+    if (node->isChildAreaArray(aChildType))
+    {
+        item.mPtr = node->getChildLeaf(aChildType);
+        item.mIsLeaf = true;
+    }
+    else
+    {
+        item.mPtr = node->getChildNode(aChildType);
+        item.mIsLeaf = false;
+    }
+    return nullptr != item.mPtr;
+}
+
+// 树叶内部的所有相交对(i<j)
+template <typename Visitor>
+bool xyTreeJoinLeafSelf(const XYTreeLeaf* leaf, double aClearance, Visitor& visitor)
+{
+    const XYTreeAreaArray& areaArray = leaf->getAreaArray();
+    const XYTreeRectArray& rectArray = leaf->getRectArray();
+    for (int i = 0, nCount = rectArray.size(), nBlockNum = rectArray.getBlockNum(); i < nCount; ++i)
+    {
+        BoundRect2D rect(rectArray.getMinX()[i] - aClearance, rectArray.getMinY()[i] - aClearance,
+                         rectArray.getMaxX()[i] + aClearance, rectArray.getMaxY()[i] + aClearance);
+        for (int nBlock = (i + 1) / XY_SIMD_BLOCK; nBlock < nBlockNum; ++nBlock)
+        {
+            int nBegin = nBlock * XY_SIMD_BLOCK;
+            unsigned int nMask = xyTreeOverlapMask(rectArray, nBegin, rect);
+            if (nBegin <= i)
+            {
+                nMask &= ~((2u << (i - nBegin)) - 1);  //只保留 j>i
+            }
+            while (nMask)
+            {
+                if (!xyTreeVisitPair(visitor, areaArray[i], areaArray[nBegin + xyTreeLowestBit(nMask)]))
+                    return false;
+                nMask &= nMask - 1;
+            }
+        }
+    }
+    return true;
+}
+
+// 两个树叶之间的所有相交对
+template <typename Visitor>
+bool xyTreeJoinLeafCross(const XYTreeLeaf* leaf1, const XYTreeLeaf* leaf2, double aClearance, Visitor& visitor)
+{
+    const XYTreeAreaArray& areaArray1 = leaf1->getAreaArray();
+    const XYTreeRectArray& rectArray1 = leaf1->getRectArray();
+    const XYTreeAreaArray& areaArray2 = leaf2->getAreaArray();
+    const XYTreeRectArray& rectArray2 = leaf2->getRectArray();
+    for (int i = 0, nCount = rectArray1.size(), nBlockNum = rectArray2.getBlockNum(); i < nCount; ++i)
+    {
+        BoundRect2D rect(rectArray1.getMinX()[i] - aClearance, rectArray1.getMinY()[i] - aClearance,
+                         rectArray1.getMaxX()[i] + aClearance, rectArray1.getMaxY()[i] + aClearance);
+        if (rect.isDisjoint(leaf2->getBoundRect()))
+        {
+            continue;
+        }
+        for (int nBlock = 0; nBlock < nBlockNum; ++nBlock)
+        {
+            int nBegin = nBlock * XY_SIMD_BLOCK;
+            unsigned int nMask = xyTreeOverlapMask(rectArray2, nBegin, rect);
+            while (nMask)
+            {
+                if (!xyTreeVisitPair(visitor, areaArray1[i], areaArray2[nBegin + xyTreeLowestBit(nMask)]))
+                    return false;
+                nMask &= nMask - 1;
+            }
+        }
+    }
+    return true;
+}
+
+// 两棵子树之间的连接任务入栈: 包围盒(外扩后)不相交时直接剪枝
+inline void xyTreeJoinPush(XYTreeSmallStack<XYTreeJoinTask>& stack, const XYTreeJoinItem& item1,
+                           const XYTreeJoinItem& item2, double aClearance)
+{
+    const BoundRect2D* bound1 = item1.getBoundRect();
+    const BoundRect2D* bound2 = item2.getBoundRect();
+    if (bound1->isValid() && bound2->isValid() && !xyTreeInflate(*bound1, aClearance).isDisjoint(bound2))
+    {
+        stack.push({item1, item2, false});
+    }
+}
+
+// 用显式栈执行连接任务(递归过深时使用): 自连接展开为各子树的自连接和相邻子树之间的连接，
+// 两棵子树之间的连接展开非树叶的一侧
+template <typename Visitor>
+bool xyTreeJoinRun(const XYTreeJoinTask& aTask, double aClearance, Visitor& visitor)
+{
+    XYTreeSmallStack<XYTreeJoinTask> stack;
+    if (aTask.mIsSelf)
+        stack.push(aTask);
+    else
+        xyTreeJoinPush(stack, aTask.mItem1, aTask.mItem2, aClearance);
+    while (!stack.empty())
+    {
+        XYTreeJoinTask task = stack.pop();
+        const XYTreeJoinItem& item1 = task.mItem1;
+        const XYTreeJoinItem& item2 = task.mItem2;
+        if (task.mIsSelf)
+        {
+            if (item1.mIsLeaf)
+            {
+                if (!xyTreeJoinLeafSelf((const XYTreeLeaf*)item1.mPtr, aClearance, visitor))
+                    return false;
+                continue;
+            }
+
+            const XYTreeNode* node = (const XYTreeNode*)item1.mPtr;
+            XYTreeJoinItem child[XYTREE_CHILD_NUM];
+            bool bChild[XYTREE_CHILD_NUM];
+            for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+            {
+                bChild[i] = xyTreeGetJoinChild(node, (XYTreeChildType)i, child[i]);
+            }
+            if (bChild[XYTREE_CHILD_LEFT] && bChild[XYTREE_CHILD_MIDDLE])
+                xyTreeJoinPush(stack, child[XYTREE_CHILD_LEFT], child[XYTREE_CHILD_MIDDLE], aClearance);
+            if (bChild[XYTREE_CHILD_MIDDLE] && bChild[XYTREE_CHILD_RIGHT])
+                xyTreeJoinPush(stack, child[XYTREE_CHILD_MIDDLE], child[XYTREE_CHILD_RIGHT], aClearance);
+            // 左右子树只有在外扩后才可能相交
+            if (aClearance > 0.0 && bChild[XYTREE_CHILD_LEFT] && bChild[XYTREE_CHILD_RIGHT])
+                xyTreeJoinPush(stack, child[XYTREE_CHILD_LEFT], child[XYTREE_CHILD_RIGHT], aClearance);
+            for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+            {
+                if (bChild[i])
+                    stack.push({child[i], child[i], true});
+            }
+            continue;
+        }
+
+        if (item1.mIsLeaf && item2.mIsLeaf)
+        {
+            if (!xyTreeJoinLeafCross((const XYTreeLeaf*)item1.mPtr, (const XYTreeLeaf*)item2.mPtr, aClearance,
+                                     visitor))
+                return false;
+            continue;
+        }
+
+        // 都为树节点时展开包围盒较大的一侧
+        const BoundRect2D* bound1 = item1.getBoundRect();
+        const BoundRect2D* bound2 = item2.getBoundRect();
+        bool bExpand1 = !item1.mIsLeaf && (item2.mIsLeaf || (bound1->getMaxX() - bound1->getMinX()) *
+                                                                    (bound1->getMaxY() - bound1->getMinY()) >=
+                                                                (bound2->getMaxX() - bound2->getMinX()) *
+                                                                    (bound2->getMaxY() - bound2->getMinY()));
+        const XYTreeNode* node = (const XYTreeNode*)(bExpand1 ? item1.mPtr : item2.mPtr);
+        XYTreeJoinItem child;
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            if (!xyTreeGetJoinChild(node, (XYTreeChildType)i, child))
+                continue;
+            if (bExpand1)
+                xyTreeJoinPush(stack, child, item2, aClearance);
+            else
+                xyTreeJoinPush(stack, item1, child, aClearance);
+        }
+    }
+    return true;
+}
+
+// 两棵子树之间的所有相交对: 包围盒不相交时剪枝，否则展开非树叶的一侧
+template <typename Visitor>
+bool xyTreeJoinCross(const XYTreeJoinItem& item1, const XYTreeJoinItem& item2, double aClearance, Visitor& visitor,
+                     int nDepth = 0)
+{
+    if (nDepth >= XY_SEARCH_STACK_SIZE)  //退化的深树: 改用显式栈，避免递归过深导致栈溢出
+    {
+        return xyTreeJoinRun(XYTreeJoinTask{item1, item2, false}, aClearance, visitor);
+    }
+    const BoundRect2D* bound1 = item1.getBoundRect();
+    const BoundRect2D* bound2 = item2.getBoundRect();
+    if (!bound1->isValid() || !bound2->isValid() || xyTreeInflate(*bound1, aClearance).isDisjoint(bound2))
+    {
+        return true;
+    }
+    if (item1.mIsLeaf && item2.mIsLeaf)
+    {
+        return xyTreeJoinLeafCross((const XYTreeLeaf*)item1.mPtr, (const XYTreeLeaf*)item2.mPtr, aClearance, visitor);
+    }
+
+    // 都为树节点时展开包围盒较大的一侧
+    bool bExpand1 = !item1.mIsLeaf && (item2.mIsLeaf || (bound1->getMaxX() - bound1->getMinX()) *
+                                                                (bound1->getMaxY() - bound1->getMinY()) >=
+                                                            (bound2->getMaxX() - bound2->getMinX()) *
+                                                                (bound2->getMaxY() - bound2->getMinY()));
+    const XYTreeNode* node = (const XYTreeNode*)(bExpand1 ? item1.mPtr : item2.mPtr);
+    XYTreeJoinItem child;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        if (!xyTreeGetJoinChild(node, (XYTreeChildType)i, child))
+            continue;
+        if (!(bExpand1 ? xyTreeJoinCross(child, item2, aClearance, visitor, nDepth + 1)
+                       : xyTreeJoinCross(item1, child, aClearance, visitor, nDepth + 1)))
+            return false;
+    }
+    return true;
+}
+
+// 子树内部的所有相交对
+template <typename Visitor>
+bool xyTreeJoinSelf(const XYTreeJoinItem& item, double aClearance, Visitor& visitor, int nDepth = 0)
+{
+    if (nDepth >= XY_SEARCH_STACK_SIZE)  //退化的深树: 改用显式栈，避免递归过深导致栈溢出
+    {
+        return xyTreeJoinRun(XYTreeJoinTask{item, item, true}, aClearance, visitor);
+    }
+    if (item.mIsLeaf)
+    {
+        return xyTreeJoinLeafSelf((const XYTreeLeaf*)item.mPtr, aClearance, visitor);
+    }
+
+    const XYTreeNode* node = (const XYTreeNode*)item.mPtr;
+    XYTreeJoinItem child[XYTREE_CHILD_NUM];
+    bool bChild[XYTREE_CHILD_NUM];
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        bChild[i] = xyTreeGetJoinChild(node, (XYTreeChildType)i, child[i]);
+        if (bChild[i] && !xyTreeJoinSelf(child[i], aClearance, visitor, nDepth + 1))
+            return false;
+    }
+    if (bChild[XYTREE_CHILD_LEFT] && bChild[XYTREE_CHILD_MIDDLE] &&
+        !xyTreeJoinCross(child[XYTREE_CHILD_LEFT], child[XYTREE_CHILD_MIDDLE], aClearance, visitor, nDepth + 1))
+        return false;
+    if (bChild[XYTREE_CHILD_MIDDLE] && bChild[XYTREE_CHILD_RIGHT] &&
+        !xyTreeJoinCross(child[XYTREE_CHILD_MIDDLE], child[XYTREE_CHILD_RIGHT], aClearance, visitor, nDepth + 1))
+        return false;
+    // 左右子树只有在外扩后才可能相交
+    if (aClearance > 0.0 && bChild[XYTREE_CHILD_LEFT] && bChild[XYTREE_CHILD_RIGHT] &&
+        !xyTreeJoinCross(child[XYTREE_CHILD_LEFT], child[XYTREE_CHILD_RIGHT], aClearance, visitor, nDepth + 1))
+        return false;
+    return true;
+}
+
+template <typename Visitor>
+inline bool RXYTree::selfJoin(Visitor&& visitor, double aClearance /*= 0.0*/) const
+{
+    assert(aClearance >= 0.0);
+    if (nullptr == mRootNode)
+        return true;
+    return xyTreeJoinSelf(XYTreeJoinItem{mRootNode, false}, aClearance, visitor);
+}
+
+template <typename Visitor>
+inline bool RXYTree::join(const RXYTree& otherTree, Visitor&& visitor, double aClearance /*= 0.0*/) const
+{
+    assert(aClearance >= 0.0);
+    if (nullptr == mRootNode || nullptr == otherTree.mRootNode)
+        return true;
+    return xyTreeJoinCross(XYTreeJoinItem{mRootNode, false}, XYTreeJoinItem{otherTree.mRootNode, false}, aClearance,
+                           visitor);
+}
+
 }  // namespace Telos
 
 #endif  // XYTREE_H
\ No newline at end of file
@@ -0,0 +1,684 @@
+/**
+ * @file xytree.hpp
+ * @brief 模板化的XYTree(仅头文件): 坐标类型和负载类型可定制
+ *
+ * 与 RXYTree 使用相同的左中右划分规则和最优值(figure of merit)分割策略，区别在于:
+ *  - 坐标类型 Coord 可以是 int32_t(数据库单位)、float 或 double，整数坐标使每个矩形只占16字节，且比较为整数比较
+ *  - 负载 Payload 直接存放在树叶中(不通过 void* 间接访问)
+ *  - 节点和树叶按下标存放在连续数组中，所有查询热点路径均为内联函数
+ */
+
+#ifndef XYTREE_HPP
+#define XYTREE_HPP
+
+#include "Telos/xytree/xytree_common.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace Telos
+{
+
+/**
+ * @brief 轴对齐矩形(闭区间，边界接触视为相交)
+ * @tparam Coord 坐标类型
+ */
+template <typename Coord>
+struct XYTreeRect
+{
+    Coord mMinX;
+    Coord mMinY;
+    Coord mMaxX;
+    Coord mMaxY;
+
+    // 空矩形: 与任何矩形都不相交，扩展任何矩形后即为该矩形
+    static XYTreeRect empty()
+    {
+        return XYTreeRect{std::numeric_limits<Coord>::max(), std::numeric_limits<Coord>::max(),
+                          std::numeric_limits<Coord>::lowest(), std::numeric_limits<Coord>::lowest()};
+    }
+
+    bool isValid() const { return mMinX <= mMaxX && mMinY <= mMaxY; }
+
+    bool isDisjoint(const XYTreeRect& other) const
+    {
+        return other.mMinX > mMaxX || other.mMaxX < mMinX || other.mMinY > mMaxY || other.mMaxY < mMinY;
+    }
+
+    bool isEqual(const XYTreeRect& other) const
+    {
+        return mMinX == other.mMinX && mMinY == other.mMinY && mMaxX == other.mMaxX && mMaxY == other.mMaxY;
+    }
+
+    void expand(const XYTreeRect& other)
+    {
+        mMinX = std::min(mMinX, other.mMinX);
+        mMinY = std::min(mMinY, other.mMinY);
+        mMaxX = std::max(mMaxX, other.mMaxX);
+        mMaxY = std::max(mMaxY, other.mMaxY);
+    }
+};
+
+/**
+ * @brief 模板化的XYTree
+ * @tparam Coord 坐标类型(int32_t/float/double等算术类型)
+ * @tparam Payload 负载类型(按值存放在树叶中，remove 时需要支持 operator==)
+ */
+template <typename Coord, typename Payload>
+class XYTree
+{
+    static_assert(std::is_arithmetic<Coord>::value, "XYTree coordinate must be an arithmetic type");
+
+   public:
+    typedef XYTreeRect<Coord> Rect;
+
+    // 树中的一项: 包围盒及其负载
+    struct Entry
+    {
+        Rect mRect;
+        Payload mPayload;
+    };
+
+   private:
+    struct Node
+    {
+        Rect mBBox;                        // 包围盒
+        Coord mSplitPos;                   // 分割位置
+        XYTreeSplitDirection mSplitDir;    // 分割方向
+        int mParent;                       // 父节点下标(树根为-1)
+        int mChild[XYTREE_CHILD_NUM];      // 左中右子树下标(树节点或树叶下标)，空子树为-1
+        bool mIsLeaf[XYTREE_CHILD_NUM];    // 子树是否为树叶
+    };
+
+    struct Leaf
+    {
+        Rect mBBox;                      // 包围盒
+        int mParent;                     // 父节点下标
+        int mSplitLimit;                 // 插入时的分裂门限(分裂失败时加倍)
+        std::vector<Entry> mEntryArray;  // 树叶中的项
+    };
+
+    std::vector<Node> mNodeArray;     // 树节点，[0]为树根
+    std::vector<Leaf> mLeafArray;     // 树叶
+    std::vector<int> mFreeNodeArray;  // 可复用的树节点下标
+    std::vector<int> mFreeLeafArray;  // 可复用的树叶下标
+    size_t mSize;                     // 项数
+    int mRebuildDepthFactor;          // 插入时重建失衡子树的高度倍数(0表示不重建)
+
+   private:
+    // 判别 aRect 属于分割位置的哪一侧
+    static XYTreeChildType getChildType(const Node& node, const Rect& aRect)
+    {
+        if (XYTREE_SPLIT_X == node.mSplitDir)
+        {
+            if (aRect.mMaxX < node.mSplitPos)
+                return XYTREE_CHILD_LEFT;
+            return aRect.mMinX > node.mSplitPos ? XYTREE_CHILD_RIGHT : XYTREE_CHILD_MIDDLE;
+        }
+        if (aRect.mMaxY < node.mSplitPos)
+            return XYTREE_CHILD_LEFT;
+        return aRect.mMinY > node.mSplitPos ? XYTREE_CHILD_RIGHT : XYTREE_CHILD_MIDDLE;
+    }
+
+    const Rect& getChildBound(const Node& node, int i) const
+    {
+        return node.mIsLeaf[i] ? mLeafArray[node.mChild[i]].mBBox : mNodeArray[node.mChild[i]].mBBox;
+    }
+
+    int allocNode(Coord aSplitPos, XYTreeSplitDirection aSplitDir, int aParent)
+    {
+        int nNode = (int)mNodeArray.size();
+        if (!mFreeNodeArray.empty())
+        {
+            nNode = mFreeNodeArray.back();
+            mFreeNodeArray.pop_back();
+        }
+        else
+        {
+            mNodeArray.emplace_back();
+        }
+        Node& node = mNodeArray[nNode];
+        node.mBBox = Rect::empty();
+        node.mSplitPos = aSplitPos;
+        node.mSplitDir = aSplitDir;
+        node.mParent = aParent;
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            node.mChild[i] = -1;
+            node.mIsLeaf[i] = true;
+        }
+        return nNode;
+    }
+
+    int allocLeaf(int aParent)
+    {
+        int nLeaf = (int)mLeafArray.size();
+        if (!mFreeLeafArray.empty())
+        {
+            nLeaf = mFreeLeafArray.back();
+            mFreeLeafArray.pop_back();
+        }
+        else
+        {
+            mLeafArray.emplace_back();
+        }
+        Leaf& leaf = mLeafArray[nLeaf];
+        leaf.mBBox = Rect::empty();
+        leaf.mParent = aParent;
+        leaf.mSplitLimit = 0;
+        leaf.mEntryArray.clear();
+        return nLeaf;
+    }
+
+    // 区间中点: 整数坐标按64位求差后取半，既不溢出也不会因分别取半而偏离中点；浮点坐标分别取半后相加
+    static Coord getMidPos(Coord aMin, Coord aMax)
+    {
+        if constexpr (std::is_integral<Coord>::value)
+            return aMin + (Coord)(((int64_t)aMax - aMin) / 2);
+        else
+            return aMin / 2 + aMax / 2;
+    }
+
+    // 计算包围盒，并按X/Y方向最优值选择分割方向和分割位置，返回false表示应作为树叶
+    static bool chooseSplit(const Entry* aEntryArray, int aEntryNum, Rect& aBound, XYTreeSplitDirection& aSplitDir,
+                            Coord& aSplitPos)
+    {
+        aBound = Rect::empty();
+        for (int i = 0; i < aEntryNum; ++i)
+        {
+            aBound.expand(aEntryArray[i].mRect);
+        }
+        if (aEntryNum < XY_THRESHOLD)
+        {
+            return false;
+        }
+
+        Coord midX = getMidPos(aBound.mMinX, aBound.mMaxX);
+        Coord midY = getMidPos(aBound.mMinY, aBound.mMaxY);
+        int nLeftX = 0, nRightX = 0, nLeftY = 0, nRightY = 0;
+        for (int i = 0; i < aEntryNum; ++i)
+        {
+            const Rect& rect = aEntryArray[i].mRect;
+            nLeftX += rect.mMaxX < midX;
+            nRightX += rect.mMinX > midX;
+            nLeftY += rect.mMaxY < midY;
+            nRightY += rect.mMinY > midY;
+        }
+
+        aSplitDir = xyTreeChooseSplitDir(aEntryNum, nLeftX, nRightX, nLeftY, nRightY);
+        if (XYTREE_SPLIT_INVALID == aSplitDir)
+        {
+            return false;
+        }
+        aSplitPos = XYTREE_SPLIT_X == aSplitDir ? midX : midY;
+        return true;
+    }
+
+    // 在项数组上构建平衡子树(数组会被原地重排)，返回子树下标
+    int buildSubTree(Entry* aEntryArray, int aEntryNum, int aParent, bool& bLeaf)
+    {
+        Rect bound;
+        XYTreeSplitDirection splitDir = XYTREE_SPLIT_X;
+        Coord splitPos = 0;
+        bLeaf = !chooseSplit(aEntryArray, aEntryNum, bound, splitDir, splitPos);
+        if (bLeaf)
+        {
+            int nLeaf = allocLeaf(aParent);
+            Leaf& leaf = mLeafArray[nLeaf];
+            leaf.mBBox = bound;
+            leaf.mEntryArray.assign(aEntryArray, aEntryArray + aEntryNum);
+            return nLeaf;
+        }
+
+        int nNode = allocNode(splitPos, splitDir, aParent);
+        mNodeArray[nNode].mBBox = bound;
+        const Node& node = mNodeArray[nNode];
+        Entry* first = aEntryArray;
+        Entry* last = aEntryArray + aEntryNum;
+        Entry* midFirst = std::partition(first, last, [&node](const Entry& entry)
+                                         { return XYTREE_CHILD_LEFT == getChildType(node, entry.mRect); });
+        Entry* rightFirst = std::partition(midFirst, last, [&node](const Entry& entry)
+                                           { return XYTREE_CHILD_MIDDLE == getChildType(node, entry.mRect); });
+        Entry* childFirst[XYTREE_CHILD_NUM] = {first, midFirst, rightFirst};
+        int childNum[XYTREE_CHILD_NUM] = {(int)(midFirst - first), (int)(rightFirst - midFirst),
+                                          (int)(last - rightFirst)};
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            if (0 == childNum[i])  //中子树可能为空
+                continue;
+            bool bChildLeaf = true;
+            int nChild = buildSubTree(childFirst[i], childNum[i], nNode, bChildLeaf);  //递归会使数组扩容，重新取下标
+            mNodeArray[nNode].mChild[i] = nChild;
+            mNodeArray[nNode].mIsLeaf[i] = bChildLeaf;
+        }
+        return nNode;
+    }
+
+    // 从指定节点开始逐层向上重新计算包围盒，直到某一层不再变化
+    void adjustBoundToRoot(int nNode)
+    {
+        while (nNode >= 0)
+        {
+            Node& node = mNodeArray[nNode];
+            Rect bound = Rect::empty();
+            for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+            {
+                if (node.mChild[i] >= 0)
+                    bound.expand(getChildBound(node, i));
+            }
+            if (bound.isEqual(node.mBBox))
+                break;
+            node.mBBox = bound;
+            nNode = node.mParent;
+        }
+    }
+
+    // 释放子树中的树节点(树叶中的项已被取出)
+    void freeSubTree(int nChild, bool bLeaf)
+    {
+        if (bLeaf)
+        {
+            mLeafArray[nChild].mEntryArray.clear();
+            mFreeLeafArray.push_back(nChild);
+            return;
+        }
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            if (mNodeArray[nChild].mChild[i] >= 0)
+                freeSubTree(mNodeArray[nChild].mChild[i], mNodeArray[nChild].mIsLeaf[i]);
+        }
+        mFreeNodeArray.push_back(nChild);
+    }
+
+    // 子树高度(树节点层数)
+    int getSubTreeHeight(int nNode) const
+    {
+        int nHeight = 0;
+        const Node& node = mNodeArray[nNode];
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            if (node.mChild[i] >= 0 && !node.mIsLeaf[i])
+                nHeight = std::max(nHeight, getSubTreeHeight(node.mChild[i]));
+        }
+        return nHeight + 1;
+    }
+
+    // 子树中的项数
+    int getSubTreeSize(int nChild, bool bLeaf) const
+    {
+        if (bLeaf)
+            return (int)mLeafArray[nChild].mEntryArray.size();
+        int nSize = 0;
+        const Node& node = mNodeArray[nChild];
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            if (node.mChild[i] >= 0)
+                nSize += getSubTreeSize(node.mChild[i], node.mIsLeaf[i]);
+        }
+        return nSize;
+    }
+
+    // 将子树中的项移动到数组中
+    void moveSubTreeEntry(int nChild, bool bLeaf, std::vector<Entry>& entryArray)
+    {
+        if (bLeaf)
+        {
+            std::vector<Entry>& leafEntryArray = mLeafArray[nChild].mEntryArray;
+            std::move(leafEntryArray.begin(), leafEntryArray.end(), std::back_inserter(entryArray));
+            leafEntryArray.clear();
+            return;
+        }
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            if (mNodeArray[nChild].mChild[i] >= 0)
+                moveSubTreeEntry(mNodeArray[nChild].mChild[i], mNodeArray[nChild].mIsLeaf[i], entryArray);
+        }
+    }
+
+    // 重建树节点子树(包围盒不变)
+    void rebuildSubTree(int nNode)
+    {
+        int nParent = mNodeArray[nNode].mParent;
+        assert(nParent >= 0);
+        int nChildType = XYTREE_CHILD_LEFT;
+        while (mNodeArray[nParent].mIsLeaf[nChildType] || mNodeArray[nParent].mChild[nChildType] != nNode)
+        {
+            ++nChildType;
+            assert(nChildType < XYTREE_CHILD_NUM);
+        }
+
+        std::vector<Entry> entryArray;
+        moveSubTreeEntry(nNode, false, entryArray);
+        freeSubTree(nNode, false);
+        bool bLeaf = true;
+        int nChild = buildSubTree(entryArray.data(), (int)entryArray.size(), nParent, bLeaf);
+        mNodeArray[nParent].mChild[nChildType] = nChild;
+        mNodeArray[nParent].mIsLeaf[nChildType] = bLeaf;
+    }
+
+    // 树叶分裂使树过深时，重建 nNode 最低的失衡祖先子树(scapegoat)，插入代价均摊为对数级
+    void rebuildUnbalancedAncestor(int nNode)
+    {
+        if (mRebuildDepthFactor <= 0)
+            return;
+        int nHeight = getSubTreeHeight(nNode);
+        int nDepth = 0;
+        for (int nAncestor = mNodeArray[nNode].mParent; nAncestor >= 0; nAncestor = mNodeArray[nAncestor].mParent)
+        {
+            ++nDepth;
+        }
+        if (nDepth + nHeight <= xyTreeHeightLimit((int)mSize, mRebuildDepthFactor))
+            return;
+
+        int nSize = getSubTreeSize(nNode, false);
+        int nChild = nNode;
+        for (int nAncestor = mNodeArray[nNode].mParent; nAncestor >= 0; nAncestor = mNodeArray[nAncestor].mParent)
+        {
+            ++nHeight;
+            const Node& node = mNodeArray[nAncestor];
+            for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)  //累加兄弟子树的项数
+            {
+                if (node.mChild[i] >= 0 && (node.mIsLeaf[i] || node.mChild[i] != nChild))
+                    nSize += getSubTreeSize(node.mChild[i], node.mIsLeaf[i]);
+            }
+            if (nHeight > xyTreeHeightLimit(nSize, mRebuildDepthFactor))
+            {
+                if (node.mParent < 0)  //重建整棵树
+                    rebalance();
+                else
+                    rebuildSubTree(nAncestor);
+                return;
+            }
+            nChild = nAncestor;
+        }
+    }
+
+    // 对节点的树叶子树原地执行分裂，返回是否分裂成功
+    bool splitLeaf(int nNode, XYTreeChildType aChildType)
+    {
+        int nLeaf = mNodeArray[nNode].mChild[aChildType];
+        std::vector<Entry> entryArray = std::move(mLeafArray[nLeaf].mEntryArray);
+        Rect bound;
+        XYTreeSplitDirection splitDir = XYTREE_SPLIT_X;
+        Coord splitPos = 0;
+        if (!chooseSplit(entryArray.data(), (int)entryArray.size(), bound, splitDir, splitPos))
+        {
+            mLeafArray[nLeaf].mEntryArray = std::move(entryArray);
+            return false;
+        }
+        mLeafArray[nLeaf].mEntryArray.clear();
+        mFreeLeafArray.push_back(nLeaf);
+        bool bLeaf = true;
+        int nChild = buildSubTree(entryArray.data(), (int)entryArray.size(), nNode, bLeaf);
+        mNodeArray[nNode].mChild[aChildType] = nChild;
+        mNodeArray[nNode].mIsLeaf[aChildType] = bLeaf;
+        return true;
+    }
+
+    template <typename Visitor>
+    bool searchLeaf(const Leaf& leaf, const Rect& srcRect, Visitor& visitor) const
+    {
+        for (const Entry& entry : leaf.mEntryArray)
+        {
+            if (entry.mRect.isDisjoint(srcRect))
+                continue;
+            if constexpr (std::is_void<decltype(visitor(entry))>::value)
+                visitor(entry);
+            else if (!visitor(entry))
+                return false;
+        }
+        return true;
+    }
+
+    // 与 XYTreeNode::search 相同的显式栈遍历: 第一个需要遍历的子树直接进入，其余逆序入栈
+    template <typename Visitor>
+    bool searchTree(const Rect& srcRect, Visitor& visitor) const
+    {
+        if (mNodeArray[0].mBBox.isDisjoint(srcRect))
+            return true;
+        XYTreeSmallStack<XYTreeIndexItem> stack;
+        XYTreeIndexItem item = {0, false};
+        while (true)
+        {
+            XYTreeIndexItem childArray[XYTREE_CHILD_NUM];
+            int nChildNum = 0;
+            if (item.mIsLeaf)
+            {
+                if (!searchLeaf(mLeafArray[item.mIndex], srcRect, visitor))
+                    return false;
+            }
+            else
+            {
+                // 查询区域在分割位置左侧时跳过右子树，在右侧时跳过左子树，总是遍历中子树
+                const Node& node = mNodeArray[item.mIndex];
+                XYTreeChildType childType = getChildType(node, srcRect);
+                for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+                {
+                    if (node.mChild[i] < 0 || (XYTREE_CHILD_LEFT == i && XYTREE_CHILD_RIGHT == childType) ||
+                        (XYTREE_CHILD_RIGHT == i && XYTREE_CHILD_LEFT == childType))
+                        continue;
+                    if (getChildBound(node, i).isDisjoint(srcRect))
+                        continue;
+                    childArray[nChildNum++] = XYTreeIndexItem{node.mChild[i], node.mIsLeaf[i]};
+                }
+            }
+
+            if (0 == nChildNum)
+            {
+                if (stack.empty())
+                    return true;
+                item = stack.pop();
+                continue;
+            }
+            for (int i = nChildNum - 1; i > 0; --i)
+            {
+                stack.push(childArray[i]);
+            }
+            item = childArray[0];
+        }
+    }
+
+   public:
+    XYTree() : mSize(0), mRebuildDepthFactor(XY_REBUILD_DEPTH_FACTOR) {}
+
+    // 批量构建
+    explicit XYTree(std::vector<Entry> entryArray) : mSize(0), mRebuildDepthFactor(XY_REBUILD_DEPTH_FACTOR)
+    {
+        bulkLoad(std::move(entryArray));
+    }
+
+    size_t size() const { return mSize; }
+    bool empty() const { return 0 == mSize; }
+
+    // 树的高度(树节点层数，空树为0)
+    int getHeight() const { return mNodeArray.empty() ? 0 : getSubTreeHeight(0); }
+
+    /**
+     * @brief 设置插入时重建失衡子树的高度倍数(scapegoat)，含义与 RXYTree::setRebuildDepthFactor 相同
+     * @param aRebuildDepthFactor 高度倍数，0表示不重建
+     */
+    void setRebuildDepthFactor(int aRebuildDepthFactor) { mRebuildDepthFactor = aRebuildDepthFactor; }
+
+    // 树的包围盒(空树为空矩形)
+    Rect getBound() const { return mNodeArray.empty() ? Rect::empty() : mNodeArray[0].mBBox; }
+
+    void clear()
+    {
+        mNodeArray.clear();
+        mLeafArray.clear();
+        mFreeNodeArray.clear();
+        mFreeLeafArray.clear();
+        mSize = 0;
+    }
+
+    /**
+     * @brief 批量构建: 清空当前树，并一次性构建平衡树，复杂度O(nlogn)
+     * @param entryArray 所有项
+     */
+    void bulkLoad(std::vector<Entry> entryArray)
+    {
+        clear();
+        mSize = entryArray.size();
+
+        // 树根的分割位置为坐标最小值: 所有项位于右子树(与 RXYTree 的未平衡树根相同)
+        int nRoot = allocNode(std::numeric_limits<Coord>::lowest(), XYTREE_SPLIT_X, -1);
+        if (entryArray.empty())
+            return;
+
+        bool bLeaf = true;
+        int nChild = buildSubTree(entryArray.data(), (int)entryArray.size(), nRoot, bLeaf);
+        if (!bLeaf)  //子树根节点直接作为树根
+        {
+            mNodeArray[nRoot] = mNodeArray[nChild];
+            mNodeArray[nRoot].mParent = -1;
+            mFreeNodeArray.push_back(nChild);
+            const Node& root = mNodeArray[nRoot];
+            for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+            {
+                if (root.mChild[i] < 0)
+                    continue;
+                if (root.mIsLeaf[i])
+                    mLeafArray[root.mChild[i]].mParent = nRoot;
+                else
+                    mNodeArray[root.mChild[i]].mParent = nRoot;
+            }
+            return;
+        }
+        mNodeArray[nRoot].mChild[XYTREE_CHILD_RIGHT] = nChild;
+        mNodeArray[nRoot].mBBox = mLeafArray[nChild].mBBox;
+    }
+
+    // 重新平衡化整棵树
+    void rebalance()
+    {
+        std::vector<Entry> entryArray;
+        entryArray.reserve(mSize);
+        for (int i = 0, nLeafNum = (int)mLeafArray.size(); i < nLeafNum; ++i)
+        {
+            entryArray.insert(entryArray.end(), mLeafArray[i].mEntryArray.begin(), mLeafArray[i].mEntryArray.end());
+        }
+        bulkLoad(std::move(entryArray));
+    }
+
+    /**
+     * @brief 插入一项: 沿分割位置向下找到树叶，超过分裂门限的树叶原地分裂
+     * @param aRect 包围盒(必须有效)
+     * @param aPayload 负载
+     */
+    void insert(const Rect& aRect, const Payload& aPayload)
+    {
+        assert(aRect.isValid());
+        if (mNodeArray.empty())
+        {
+            allocNode(std::numeric_limits<Coord>::lowest(), XYTREE_SPLIT_X, -1);
+        }
+
+        int nNode = 0;
+        XYTreeChildType childType = XYTREE_CHILD_NUM;
+        while (true)
+        {
+            Node& node = mNodeArray[nNode];
+            node.mBBox.expand(aRect);
+            childType = getChildType(node, aRect);
+            if (node.mIsLeaf[childType])
+                break;
+            nNode = node.mChild[childType];
+        }
+        if (mNodeArray[nNode].mChild[childType] < 0)
+        {
+            int nLeaf = allocLeaf(nNode);
+            mNodeArray[nNode].mChild[childType] = nLeaf;
+        }
+        Leaf& leaf = mLeafArray[mNodeArray[nNode].mChild[childType]];
+        leaf.mBBox.expand(aRect);
+        leaf.mEntryArray.push_back(Entry{aRect, aPayload});
+        ++mSize;
+
+        int nEntryNum = (int)leaf.mEntryArray.size();
+        if (nEntryNum > std::max(XY_THRESHOLD * XY_LEAF_SPLIT_FACTOR, leaf.mSplitLimit))
+        {
+            if (splitLeaf(nNode, childType))
+                rebuildUnbalancedAncestor(mNodeArray[nNode].mChild[childType]);
+            else
+                mLeafArray[mNodeArray[nNode].mChild[childType]].mSplitLimit = nEntryNum * 2;
+        }
+    }
+
+    /**
+     * @brief 删除包围盒和负载均相同的一项
+     * @return true:删除成功 ｜ false:未找到
+     */
+    bool remove(const Rect& aRect, const Payload& aPayload)
+    {
+        if (mNodeArray.empty() || !aRect.isValid())
+            return false;
+        int nNode = 0;
+        XYTreeChildType childType = getChildType(mNodeArray[0], aRect);
+        while (!mNodeArray[nNode].mIsLeaf[childType])
+        {
+            nNode = mNodeArray[nNode].mChild[childType];
+            childType = getChildType(mNodeArray[nNode], aRect);
+        }
+        int nLeaf = mNodeArray[nNode].mChild[childType];
+        if (nLeaf < 0)
+            return false;
+
+        Leaf& leaf = mLeafArray[nLeaf];
+        auto iter = std::find_if(leaf.mEntryArray.begin(), leaf.mEntryArray.end(), [&](const Entry& entry)
+                                 { return entry.mRect.isEqual(aRect) && entry.mPayload == aPayload; });
+        if (iter == leaf.mEntryArray.end())
+            return false;
+        *iter = std::move(leaf.mEntryArray.back());
+        leaf.mEntryArray.pop_back();
+        --mSize;
+
+        if (leaf.mEntryArray.empty())  //摘除空树叶
+        {
+            mNodeArray[nNode].mChild[childType] = -1;
+            mFreeLeafArray.push_back(nLeaf);
+        }
+        else
+        {
+            leaf.mBBox = Rect::empty();
+            for (const Entry& entry : leaf.mEntryArray)
+            {
+                leaf.mBBox.expand(entry.mRect);
+            }
+        }
+        adjustBoundToRoot(nNode);
+        return true;
+    }
+
+    /**
+     * @brief 搜索与 srcRect 相交的项，对每一项调用访问者
+     * @param visitor 访问者: bool(const Entry&) 返回false时停止搜索；也可以返回void
+     * @return true:搜索完成 ｜ false:被访问者提前停止
+     */
+    template <typename Visitor>
+    bool search(const Rect& srcRect, Visitor&& visitor) const
+    {
+        if (mNodeArray.empty())
+            return true;
+        return searchTree(srcRect, visitor);
+    }
+
+    /**
+     * @brief 将与 srcRect 相交的项的负载追加到数组中
+     * @return int 追加的项数
+     */
+    int query(const Rect& srcRect, std::vector<Payload>& resultArray) const
+    {
+        size_t nOldSize = resultArray.size();
+        search(srcRect, [&resultArray](const Entry& entry) { resultArray.push_back(entry.mPayload); });
+        return (int)(resultArray.size() - nOldSize);
+    }
+};
+
+}  // namespace Telos
+
+#endif  // XYTREE_HPP
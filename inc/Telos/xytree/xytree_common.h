@@ -0,0 +1,138 @@
+#ifndef XYTREE_COMMON_H
+#define XYTREE_COMMON_H
+
+#include <assert.h>
+#include <vector>
+
+namespace Telos
+{
+
+#define XY_THRESHOLD 16            // 树叶中area列表的最大长度(推荐4-25，默认16)
+#define XY_LEAF_SPLIT_FACTOR 4     // 插入时树叶中area数超过 XY_THRESHOLD 的该倍数后原地分裂树叶(0表示不分裂)
+#define XY_REBUILD_DEPTH_FACTOR 3  // 插入后子树高度超过 该倍数*log2(area数/XY_THRESHOLD) 时重建该子树(0表示不重建)
+#define XY_SEARCH_STACK_SIZE 64    // 迭代搜索的固定栈容量(子树数)，超出后使用堆内存
+
+// XYTree子节点类型
+enum XYTreeChildType
+{
+    XYTREE_CHILD_LEFT = 0,  // 左节点
+    XYTREE_CHILD_MIDDLE,    // 中节点
+    XYTREE_CHILD_RIGHT,     // 右节点
+    XYTREE_CHILD_NUM,       // 表示数字3
+    XYTREE_CHILD_INVALID    // 无效的子节点类型
+};
+
+// XYTree分割方向
+enum XYTreeSplitDirection
+{
+    XYTREE_SPLIT_X = 0,  // X轴向分割
+    XYTREE_SPLIT_Y,      // Y轴向分割
+    XYTREE_SPLIT_NUM,
+    XYTREE_SPLIT_INVALID  // 无效的分割方向
+};
+
+// 以下为 RXYTree(xytree.h) 与模板化的 XYTree(xytree.hpp) 共用的分割策略，均为内联函数
+
+// 返回在树中搜索一颗n层树的大致时间log(n):返回值>=1，即使树的层树为0
+inline int xyTreeLogTime(int n)
+{
+    int i = 0;
+    do
+    {
+        ++i;
+        n >>= 1;
+    } while (n > 0);
+    return i;
+}
+
+// 子树高度上限: 高度(树节点层数)超过该值的子树视为失衡，插入时需要重建
+inline int xyTreeHeightLimit(int nAreaNum, int nFactor)
+{
+    return nFactor * xyTreeLogTime(nAreaNum / XY_THRESHOLD);
+}
+
+/**
+ * @brief 按X/Y方向最优值(figure of merit)选择分割方向
+ * @param nNum 项数
+ * @param nLeftX,nRightX 完全位于X方向中点左侧/右侧的项数
+ * @param nLeftY,nRightY 完全位于Y方向中点下侧/上侧的项数
+ * @return 分割方向 | XYTREE_SPLIT_INVALID: 两侧的项数小于门限或所有项分布在单侧，无需分割
+ */
+inline XYTreeSplitDirection xyTreeChooseSplitDir(int nNum, int nLeftX, int nRightX, int nLeftY, int nRightY)
+{
+    bool bSplitDirX = true;
+    if (nLeftX && nRightX && nLeftY && nRightY)
+    {
+        double fom_x = (double)nLeftX * (double)xyTreeLogTime(nLeftX) +
+                       (double)nNum * (double)xyTreeLogTime(nNum - nLeftX - nRightX) +
+                       (double)nRightX * (double)xyTreeLogTime(nRightX);  //X方向最优值
+        double fom_y = (double)nLeftY * (double)xyTreeLogTime(nLeftY) +
+                       (double)nNum * (double)xyTreeLogTime(nNum - nLeftY - nRightY) +
+                       (double)nRightY * (double)xyTreeLogTime(nRightY);  //Y方向最优值
+        bSplitDirX = (fom_x <= fom_y);                                    //沿着最优值更小的方向分割
+    }
+    else
+    {
+        bSplitDirX = nLeftX && nRightX;
+    }
+
+    if (bSplitDirX)
+    {
+        return nLeftX + nRightX < XY_THRESHOLD ? XYTREE_SPLIT_INVALID : XYTREE_SPLIT_X;
+    }
+    if (!nLeftY || !nRightY || nLeftY + nRightY < XY_THRESHOLD)
+    {
+        return XYTREE_SPLIT_INVALID;
+    }
+    return XYTREE_SPLIT_Y;
+}
+
+/**
+ * @brief 遍历用的小栈: 前 XY_SEARCH_STACK_SIZE 项存放在对象内部(通常位于调用者的栈上)，超出部分转用堆内存
+ * 常见深度的树遍历不分配内存，退化的深树也不会因递归过深而栈溢出
+ */
+template <typename T>
+class XYTreeSmallStack
+{
+   private:
+    T mFixed[XY_SEARCH_STACK_SIZE];  // 栈底的固定容量部分
+    std::vector<T> mOverflow;        // 超出固定容量的部分
+    int mSize;                       // 总项数
+
+   public:
+    XYTreeSmallStack() : mSize(0) {}
+
+    bool empty() const { return 0 == mSize; }
+    int size() const { return mSize; }
+
+    void push(const T& item)
+    {
+        if (mSize < XY_SEARCH_STACK_SIZE)
+            mFixed[mSize] = item;
+        else
+            mOverflow.push_back(item);
+        ++mSize;
+    }
+
+    T pop()
+    {
+        assert(mSize > 0);
+        --mSize;
+        if (mSize < XY_SEARCH_STACK_SIZE)
+            return mFixed[mSize];
+        T item = mOverflow.back();
+        mOverflow.pop_back();
+        return item;
+    }
+};
+
+// 按下标存放的树(XYTreeSnapshot、模板化的 XYTree)中的子树: 树节点或树叶下标
+struct XYTreeIndexItem
+{
+    int mIndex;    // 树节点或树叶下标
+    bool mIsLeaf;  // 是否为树叶
+};
+
+}  // namespace Telos
+
+#endif  // XYTREE_COMMON_H
@@ -0,0 +1,274 @@
+#ifndef XYTREE_COMPILED_H
+#define XYTREE_COMPILED_H
+
+#include "Telos/macros.h"
+#include "Telos/xytree/xytree.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Telos
+{
+
+#define XYTREE_COMPILED_LEAF_BIT 0x80000000u    // 子树下标的最高位: 1表示树叶下标，0表示树节点下标
+#define XYTREE_COMPILED_NULL_CHILD 0xFFFFFFFFu  // 空子树
+
+// 编译后的树节点(64字节，按缓存行对齐): 一次内存访问即可完成包围盒、类型掩码和分割位置的判断
+struct alignas(64) XYTreeCompiledNode
+{
+    double mBound[4];                   // 包围盒: minX, minY, maxX, maxY
+    double mSplitPos;                   // 分割位置
+    XYTreeTypeMask mTypeMask;           // 子树的类型掩码
+    uint32_t mChild[XYTREE_CHILD_NUM];  // 左中右子树下标(树叶带 XYTREE_COMPILED_LEAF_BIT)，空子树为 NULL_CHILD
+    uint8_t mSplitDir;                  // 分割方向(XYTreeSplitDirection)
+};
+
+// 编译后的树叶(48字节)
+struct XYTreeCompiledLeaf
+{
+    double mBound[4];          // 包围盒: minX, minY, maxX, maxY
+    XYTreeTypeMask mTypeMask;  // 树叶的类型掩码
+    uint32_t mSlotBegin;       // 起始槽位(XY_SIMD_BLOCK的整数倍)
+    uint32_t mAreaNum;         // area数
+};
+
+// 紧凑模式的树节点(32字节): 包围盒向外取整为float，只用于剪枝；类型掩码存放在单独的数组中
+struct alignas(32) XYTreeCompactNode
+{
+    float mBound[4];                    // 保守包围盒(包含精确包围盒): minX, minY, maxX, maxY
+    uint32_t mChild[XYTREE_CHILD_NUM];  // 左中右子树下标(树叶带 XYTREE_COMPILED_LEAF_BIT)，空子树为 NULL_CHILD
+};
+
+// 紧凑模式的树叶(24字节)
+struct XYTreeCompactLeaf
+{
+    float mBound[4];      // 保守包围盒: minX, minY, maxX, maxY
+    uint32_t mSlotBegin;  // 起始槽位(XY_SIMD_BLOCK的整数倍)
+    uint32_t mAreaNum;    // area数
+};
+
+/**
+ * @brief RXYTree 的只读编译形式: 在 rebalance 之后由树生成，用于高吞吐量查询
+ * 所有树节点按先序存放在一个64字节对齐的连续数组中(父节点之后紧跟第一个子节点)，子树以带标记的32位下标引用；
+ * 所有area的包围盒按SoA存放，每个树叶占据一段按 XY_SIMD_BLOCK 对齐的连续槽位。
+ * 紧凑模式下树节点和树叶的包围盒向外取整为float，节点记录减半；float包围盒只用于剪枝，area包围盒仍按double
+ * 精确比较，查询结果与精确模式完全相同。紧凑模式不按分割位置剪枝，只按子树包围盒剪枝。
+ * 编译形式不随树更新，树被修改后需要重新 compile；查询结果中的 ComponentArea* 指向原树中的area。
+ * 编译后可以在任意多个线程中无锁并发查询。
+ */
+class TELOS_PUBLIC XYTreeCompiled
+{
+   private:
+    std::vector<XYTreeCompiledNode> mNodeArray;  // 树节点，[0]为树根
+    std::vector<XYTreeCompiledLeaf> mLeafArray;  // 树叶
+    std::vector<XYTreeCompactNode> mCompactNodeArray;  // 紧凑模式的树节点，[0]为树根
+    std::vector<XYTreeCompactLeaf> mCompactLeafArray;  // 紧凑模式的树叶
+    std::vector<XYTreeTypeMask> mNodeTypeMaskArray;    // 紧凑模式的树节点类型掩码
+    std::vector<XYTreeTypeMask> mLeafTypeMaskArray;    // 紧凑模式的树叶类型掩码
+    bool mIsCompact = false;                           // 是否为紧凑模式
+    std::vector<double> mMinX;                   // area包围盒(SoA)，与 mAreaArray 一一对应
+    std::vector<double> mMinY;
+    std::vector<double> mMaxX;
+    std::vector<double> mMaxY;
+    std::vector<ComponentArea*> mAreaArray;      // 槽位中的area(对齐填充的空槽位为nullptr)
+
+   private:
+    template <typename T>
+    static bool isDisjoint(const T* aBound, const BoundRect2D& srcRect)
+    {
+        return srcRect.getMinX() > aBound[2] || srcRect.getMaxX() < aBound[0] || srcRect.getMinY() > aBound[3] ||
+               srcRect.getMaxY() < aBound[1];
+    }
+
+    // 将精确模式的树节点和树叶转换为紧凑模式(转换后释放精确模式的记录)
+    void buildCompact();
+
+    template <typename Visitor>
+    bool searchLeaf(uint32_t nSlotBegin, uint32_t nAreaNum, XYTreeTypeMask aLeafTypeMask, const BoundRect2D& srcRect,
+                    Visitor& visitor, XYTreeTypeMask aTypeMask) const;
+
+    // 子树是否可以剪掉(类型不符或包围盒不相交)
+    template <bool bCompact>
+    bool isPruned(uint32_t nItem, const BoundRect2D& srcRect, XYTreeTypeMask aTypeMask) const;
+
+    template <bool bCompact, typename Visitor>
+    bool searchTree(const BoundRect2D& srcRect, Visitor& visitor, XYTreeTypeMask aTypeMask) const;
+
+   public:
+    XYTreeCompiled() = default;
+
+    /**
+     * @brief 由树生成编译形式(替换原有内容)，建议先调用 rebalance
+     * @param tree 树
+     * @param bCompact 是否使用紧凑模式(树节点和树叶使用float保守包围盒)
+     */
+    void compile(const RXYTree& tree, bool bCompact = false);
+
+    void clear();
+
+    bool isCompact() const { return mIsCompact; }
+    int getNodeNum() const { return (int)(mIsCompact ? mCompactNodeArray.size() : mNodeArray.size()); }
+    int getLeafNum() const { return (int)(mIsCompact ? mCompactLeafArray.size() : mLeafArray.size()); }
+    int getAreaNum() const;
+
+    // 树节点和树叶记录(含类型掩码)占用的字节数，不含area包围盒
+    size_t getNodeBytes() const;
+
+    /**
+     * @brief 搜索与 srcRect 相交的area，对每个area调用访问者，访问顺序与 RXYTree::search 相同
+     * @param srcRect 搜索区域
+     * @param visitor 访问者: bool(ComponentArea*) 返回false时停止搜索；也可以返回void
+     * @param aTypeMask 器件类型掩码，只访问类型位于掩码中的area
+     * @return true:搜索完成 ｜ false:被访问者提前停止
+     */
+    template <typename Visitor>
+    bool search(const BoundRect2D& srcRect, Visitor&& visitor, XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
+    /**
+     * @brief 将和指定矩形区碰撞的area追加到数组中
+     * @param resultArray 结果数组(不清空，结果追加在末尾)
+     * @return int 追加的area数
+     */
+    int getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                            std::vector<ComponentArea*>& resultArray,
+                            XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+};
+
+template <typename Visitor>
+inline bool XYTreeCompiled::searchLeaf(uint32_t nSlotBegin, uint32_t nAreaNum, XYTreeTypeMask aLeafTypeMask,
+                                       const BoundRect2D& srcRect, Visitor& visitor, XYTreeTypeMask aTypeMask) const
+{
+    const bool bFilterType = (aLeafTypeMask & ~aTypeMask) != 0;  //树叶中存在需要过滤掉的类型
+    for (uint32_t nBegin = nSlotBegin, nEnd = nSlotBegin + nAreaNum; nBegin < nEnd; nBegin += XY_SIMD_BLOCK)
+    {
+        unsigned int nMask = xyTreeOverlapMask(mMinX.data() + nBegin, mMinY.data() + nBegin, mMaxX.data() + nBegin,
+                                               mMaxY.data() + nBegin, srcRect);
+        while (nMask)
+        {
+            ComponentArea* area = mAreaArray[nBegin + xyTreeLowestBit(nMask)];
+            assert(area);
+            nMask &= nMask - 1;
+            if (bFilterType && !(aTypeMask & xyTreeTypeBit(area->getTypeId())))
+            {
+                continue;
+            }
+            if (!xyTreeVisit(visitor, area))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <bool bCompact>
+inline bool XYTreeCompiled::isPruned(uint32_t nItem, const BoundRect2D& srcRect, XYTreeTypeMask aTypeMask) const
+{
+    bool bLeaf = (nItem & XYTREE_COMPILED_LEAF_BIT) != 0;
+    uint32_t nIndex = nItem & ~XYTREE_COMPILED_LEAF_BIT;
+    if constexpr (bCompact)
+    {
+        // 不过滤类型时不读取类型掩码数组，只访问32字节的节点记录
+        if (XYTREE_TYPE_MASK_ALL != aTypeMask &&
+            0 == ((bLeaf ? mLeafTypeMaskArray[nIndex] : mNodeTypeMaskArray[nIndex]) & aTypeMask))
+            return true;
+        return isDisjoint(bLeaf ? mCompactLeafArray[nIndex].mBound : mCompactNodeArray[nIndex].mBound, srcRect);
+    }
+    else
+    {
+        if (0 == ((bLeaf ? mLeafArray[nIndex].mTypeMask : mNodeArray[nIndex].mTypeMask) & aTypeMask))
+            return true;
+        return isDisjoint(bLeaf ? mLeafArray[nIndex].mBound : mNodeArray[nIndex].mBound, srcRect);
+    }
+}
+
+template <bool bCompact, typename Visitor>
+inline bool XYTreeCompiled::searchTree(const BoundRect2D& srcRect, Visitor& visitor, XYTreeTypeMask aTypeMask) const
+{
+    if (isPruned<bCompact>(0, srcRect, aTypeMask))
+    {
+        return true;
+    }
+
+    // 与 XYTreeNode::search 相同的显式栈遍历: 第一个需要遍历的子树直接进入，其余逆序入栈
+    XYTreeSmallStack<uint32_t> stack;
+    uint32_t nItem = 0;
+    while (true)
+    {
+        uint32_t childArray[XYTREE_CHILD_NUM];
+        int nChildNum = 0;
+        if (nItem & XYTREE_COMPILED_LEAF_BIT)
+        {
+            uint32_t nLeaf = nItem & ~XYTREE_COMPILED_LEAF_BIT;
+            bool bContinue;
+            if constexpr (bCompact)
+            {
+                const XYTreeCompactLeaf& leaf = mCompactLeafArray[nLeaf];
+                XYTreeTypeMask leafTypeMask = XYTREE_TYPE_MASK_ALL == aTypeMask ? 0 : mLeafTypeMaskArray[nLeaf];
+                bContinue = searchLeaf(leaf.mSlotBegin, leaf.mAreaNum, leafTypeMask, srcRect, visitor, aTypeMask);
+            }
+            else
+            {
+                const XYTreeCompiledLeaf& leaf = mLeafArray[nLeaf];
+                bContinue = searchLeaf(leaf.mSlotBegin, leaf.mAreaNum, leaf.mTypeMask, srcRect, visitor, aTypeMask);
+            }
+            if (!bContinue)
+                return false;
+        }
+        else
+        {
+            // 紧凑模式没有分割位置，三个子树都只按包围盒剪枝
+            bool bVisit[XYTREE_CHILD_NUM] = {true, true, true};
+            const uint32_t* nodeChild;
+            if constexpr (bCompact)
+            {
+                nodeChild = mCompactNodeArray[nItem].mChild;
+            }
+            else
+            {
+                const XYTreeCompiledNode& node = mNodeArray[nItem];
+                bool bSplitX = XYTREE_SPLIT_X == node.mSplitDir;
+                bVisit[XYTREE_CHILD_LEFT] = (bSplitX ? srcRect.getMinX() : srcRect.getMinY()) <= node.mSplitPos;
+                bVisit[XYTREE_CHILD_RIGHT] = (bSplitX ? srcRect.getMaxX() : srcRect.getMaxY()) >= node.mSplitPos;
+                nodeChild = node.mChild;
+            }
+            for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+            {
+                uint32_t nChild = nodeChild[i];
+                if (!bVisit[i] || XYTREE_COMPILED_NULL_CHILD == nChild)
+                    continue;
+                if (isPruned<bCompact>(nChild, srcRect, aTypeMask))
+                    continue;
+                childArray[nChildNum++] = nChild;
+            }
+        }
+
+        if (0 == nChildNum)
+        {
+            if (stack.empty())
+                return true;
+            nItem = stack.pop();
+            continue;
+        }
+        for (int i = nChildNum - 1; i > 0; --i)
+        {
+            stack.push(childArray[i]);
+        }
+        nItem = childArray[0];
+    }
+}
+
+template <typename Visitor>
+inline bool XYTreeCompiled::search(const BoundRect2D& srcRect, Visitor&& visitor,
+                                   XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    if (0 == getNodeNum())
+    {
+        return true;
+    }
+    return mIsCompact ? searchTree<true>(srcRect, visitor, aTypeMask) : searchTree<false>(srcRect, visitor, aTypeMask);
+}
+
+}  // namespace Telos
+
+#endif  // XYTREE_COMPILED_H
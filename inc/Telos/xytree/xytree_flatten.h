@@ -0,0 +1,58 @@
+#ifndef XYTREE_FLATTEN_H
+#define XYTREE_FLATTEN_H
+
+#include "Telos/xytree/xytree.h"
+
+#include <cfloat>
+#include <stdint.h>
+
+namespace Telos
+{
+
+/**
+ * @brief 树展平: 先序遍历树(父节点之后紧跟第一个子节点)，把树节点、树叶和area依次交给 sink
+ * 每个树叶占据一段按 XY_SIMD_BLOCK 对齐的连续槽位，尾部用空矩形(与任何矩形都不相交)填充。
+ * XYTreeSnapshot 和 XYTreeCompiled 共用这一遍展平，只是记录格式不同。Sink 需要提供:
+ *   uint32_t addNode(const XYTreeNode* node)                        追加树节点记录(子树为空)，返回下标
+ *   void setChild(uint32_t nNode, int nChild, uint32_t nItem, bool bLeaf)  写回子树下标
+ *   uint32_t addLeaf(const XYTreeLeaf* leaf, uint32_t nSlotBegin)    追加树叶记录，返回下标
+ *   void addSlot(double aMinX, double aMinY, double aMaxX, double aMaxY, ComponentArea* area)
+ *                                                                   追加槽位，填充槽位的area为nullptr
+ *   uint32_t getSlotNum() const                                     已追加的槽位数
+ * @return 树节点的下标
+ */
+template <typename Sink>
+uint32_t flattenXYTree(const XYTreeNode* node, Sink& sink)
+{
+    uint32_t nNode = sink.addNode(node);
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        XYTreeChildType childType = (XYTreeChildType)i;
+        if (node->isChildAreaArray(childType))
+        {
+            const XYTreeLeaf* leaf = node->getChildLeaf(childType);
+            if (nullptr == leaf)
+                continue;
+            uint32_t nLeaf = sink.addLeaf(leaf, sink.getSlotNum());
+            for (ComponentArea* area : leaf->getAreaArray())
+            {
+                const BoundRect2D* rect = area->getBoundRect();
+                sink.addSlot(rect->getMinX(), rect->getMinY(), rect->getMaxX(), rect->getMaxY(), area);
+            }
+            while (sink.getSlotNum() % XY_SIMD_BLOCK)  //填充空矩形，使下一个树叶的起始槽位按块对齐
+            {
+                sink.addSlot(DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX, nullptr);
+            }
+            sink.setChild(nNode, i, nLeaf, true);
+        }
+        else
+        {
+            sink.setChild(nNode, i, flattenXYTree(node->getChildNode(childType), sink), false);
+        }
+    }
+    return nNode;
+}
+
+}  // namespace Telos
+
+#endif  // XYTREE_FLATTEN_H
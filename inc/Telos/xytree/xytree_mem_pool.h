@@ -0,0 +1,166 @@
+#ifndef XYTREE_MEM_POOL_H
+#define XYTREE_MEM_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Telos
+{
+
+#define XY_MEMPOOL_BLOCK_SIZE (64 * 1024)  // 内存池每次向系统申请的内存块大小(字节)
+#define XY_MEMPOOL_ALIGN 16                // 内存池分配的对齐字节数
+#define XY_MEMPOOL_SMALL_CLASS_NUM 16      // 小对象尺寸档位数: 16, 32, ..., 256字节
+#define XY_MEMPOOL_CLASS_NUM 64            // 尺寸档位总数: 小对象档位 + 2的幂次档位
+
+/**
+ * @brief XYTree内存池(slab/arena)
+ * 树节点、树叶、器件区域以及树叶中的数组均从内存池中分配；
+ * 释放的内存按尺寸档位挂入空闲链表复用，整棵树销毁时只需一次 release() 归还所有内存块，
+ * 无需递归析构各个节点。
+ * 内存池本身不是线程安全的，多线程构建时每个任务使用独立的子内存池，再由 adopt() 接管。
+ */
+class XYTreeMemPool
+{
+   private:
+    struct Block
+    {
+        Block* mNext;  // 下一个内存块
+        size_t mSize;  // 内存块总大小(含块头)
+    };
+
+    struct FreeNode
+    {
+        FreeNode* mNext;  // 下一个空闲内存
+    };
+
+    Block* mBlockList;                            // 内存块链表
+    char* mCurPtr;                                // 当前内存块中未分配区域的起始地址
+    char* mEndPtr;                                // 当前内存块的结束地址
+    FreeNode* mFreeList[XY_MEMPOOL_CLASS_NUM];    // 各尺寸档位的空闲链表
+    size_t mBlockBytes;                           // 已向系统申请的总字节数
+    std::vector<XYTreeMemPool*> mChildPoolArray;  // 接管的子内存池
+
+   private:
+    // 计算尺寸对应的档位，并返回该档位的实际分配尺寸
+    static int getSizeClass(size_t size, size_t& classSize);
+
+    // 申请一个新的内存块，保证至少可以容纳 size 字节
+    void allocateBlock(size_t size);
+
+   public:
+    XYTreeMemPool();
+    ~XYTreeMemPool();
+
+    XYTreeMemPool(const XYTreeMemPool&) = delete;
+    XYTreeMemPool& operator=(const XYTreeMemPool&) = delete;
+
+    /**
+     * @brief 从内存池中分配内存(按 XY_MEMPOOL_ALIGN 对齐)
+     * @param size 字节数
+     * @return void* 内存地址
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief 将内存归还到内存池的空闲链表
+     * @param ptr 内存地址
+     * @param size 分配时的字节数
+     */
+    void deallocate(void* ptr, size_t size);
+
+    /**
+     * @brief 一次性释放内存池中的所有内存块(不调用任何析构函数)
+     */
+    void release();
+
+    /**
+     * @brief 接管子内存池的所有权: 子内存池及其分配出的对象继续有效(对象内部保存的内存池指针无需修改)，
+     * 并随当前内存池的 release() 一起释放
+     * @param childPool 通过 new 创建的子内存池
+     */
+    void adopt(XYTreeMemPool* childPool);
+
+    /**
+     * @brief 获取已向系统申请的总字节数(含子内存池)
+     * @return size_t 字节数
+     */
+    size_t getBlockBytes() const;
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        void* ptr = allocate(sizeof(T));
+        return new (ptr) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void destroy(T* ptr)
+    {
+        if (nullptr == ptr)
+            return;
+        ptr->~T();
+        deallocate(ptr, sizeof(T));
+    }
+};
+
+/**
+ * @brief 从 XYTreeMemPool 中分配内存的STL分配器，内存池为空时退化为全局堆分配
+ */
+template <typename T>
+class XYTreeAllocator
+{
+   private:
+    XYTreeMemPool* mMemPool;
+
+    template <typename U>
+    friend class XYTreeAllocator;
+
+   public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    XYTreeAllocator(XYTreeMemPool* memPool = nullptr) : mMemPool(memPool) {}
+
+    template <typename U>
+    XYTreeAllocator(const XYTreeAllocator<U>& other) : mMemPool(other.mMemPool)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (mMemPool)
+            return (T*)mMemPool->allocate(n * sizeof(T));
+        return (T*)::operator new(n * sizeof(T));
+    }
+
+    void deallocate(T* ptr, size_t n)
+    {
+        if (mMemPool)
+            mMemPool->deallocate(ptr, n * sizeof(T));
+        else
+            ::operator delete(ptr);
+    }
+
+    XYTreeMemPool* getMemPool() const { return mMemPool; }
+
+    template <typename U>
+    bool operator==(const XYTreeAllocator<U>& other) const
+    {
+        return mMemPool == other.mMemPool;
+    }
+
+    template <typename U>
+    bool operator!=(const XYTreeAllocator<U>& other) const
+    {
+        return mMemPool != other.mMemPool;
+    }
+};
+
+}  // namespace Telos
+
+#endif  // XYTREE_MEM_POOL_H
@@ -0,0 +1,244 @@
+#ifndef XYTREE_SIMD_H
+#define XYTREE_SIMD_H
+
+#include "Telos/xytree/bound_rect2d.h"
+#include "Telos/xytree/xytree_mem_pool.h"
+
+#include <assert.h>
+#include <cfloat>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define XY_SIMD_AVX 1  // AVX: 一条指令比较4个double
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XY_SIMD_SSE2 1  // SSE2: 一条指令比较2个double
+#endif
+
+namespace Telos
+{
+
+#define XY_SIMD_BLOCK 4  // 矩形过滤的分块大小: 每次计算4个矩形的相交掩码
+
+// 预取地址所在的缓存行(只读)
+#if defined(__GNUC__) || defined(__clang__)
+#define XY_PREFETCH(p) __builtin_prefetch((p), 0, 3)
+#elif defined(XY_SIMD_AVX) || defined(XY_SIMD_SSE2)
+#define XY_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define XY_PREFETCH(p) ((void)0)
+#endif
+
+/**
+ * @brief 按结构数组(SoA)存放的矩形数组: minX/minY/maxX/maxY 各自连续存放
+ * 四个坐标数组共用一次分配，容量按 XY_SIMD_BLOCK 对齐，尾部空位填充为空矩形(与任何矩形都不相交)，
+ * 以便SIMD内核按整块读取。
+ */
+class XYTreeRectArray
+{
+   private:
+    double* mCoord;           // [minX... | minY... | maxX... | maxY...]，每段长度为 mCapacity
+    int mSize;                // 矩形数
+    int mCapacity;            // 容量(XY_SIMD_BLOCK的整数倍)
+    XYTreeMemPool* mMemPool;  // 内存池(为空时使用全局堆)
+
+   private:
+    void setEmpty(int nIndex)
+    {
+        mCoord[nIndex] = DBL_MAX;
+        mCoord[mCapacity + nIndex] = DBL_MAX;
+        mCoord[2 * mCapacity + nIndex] = -DBL_MAX;
+        mCoord[3 * mCapacity + nIndex] = -DBL_MAX;
+    }
+
+    void reserve(int nCapacity)
+    {
+        nCapacity = (nCapacity + XY_SIMD_BLOCK - 1) / XY_SIMD_BLOCK * XY_SIMD_BLOCK;
+        if (nCapacity <= mCapacity)
+            return;
+
+        size_t nBytes = sizeof(double) * 4 * nCapacity;
+        double* coord = (double*)(mMemPool ? mMemPool->allocate(nBytes) : ::operator new(nBytes));
+        for (int k = 0; k < 4; ++k)
+        {
+            for (int i = 0; i < mSize; ++i)
+            {
+                coord[k * nCapacity + i] = mCoord[k * mCapacity + i];
+            }
+        }
+        release();
+        mCoord = coord;
+        mCapacity = nCapacity;
+        for (int i = mSize; i < mCapacity; ++i)
+        {
+            setEmpty(i);
+        }
+    }
+
+    void release()
+    {
+        if (nullptr == mCoord)
+            return;
+        if (mMemPool)
+            mMemPool->deallocate(mCoord, sizeof(double) * 4 * mCapacity);
+        else
+            ::operator delete(mCoord);
+        mCoord = nullptr;
+        mCapacity = 0;
+    }
+
+   public:
+    explicit XYTreeRectArray(XYTreeMemPool* aMemPool = nullptr)
+        : mCoord(nullptr), mSize(0), mCapacity(0), mMemPool(aMemPool)
+    {
+    }
+    ~XYTreeRectArray() { release(); }
+
+    XYTreeRectArray(const XYTreeRectArray&) = delete;
+    XYTreeRectArray& operator=(const XYTreeRectArray&) = delete;
+
+    int size() const { return mSize; }
+    int getBlockNum() const { return (mSize + XY_SIMD_BLOCK - 1) / XY_SIMD_BLOCK; }
+
+    const double* getMinX() const { return mCoord; }
+    const double* getMinY() const { return mCoord + mCapacity; }
+    const double* getMaxX() const { return mCoord + 2 * mCapacity; }
+    const double* getMaxY() const { return mCoord + 3 * mCapacity; }
+
+    void set(int nIndex, const BoundRect2D& rect)
+    {
+        assert(nIndex >= 0 && nIndex < mSize);
+        mCoord[nIndex] = rect.getMinX();
+        mCoord[mCapacity + nIndex] = rect.getMinY();
+        mCoord[2 * mCapacity + nIndex] = rect.getMaxX();
+        mCoord[3 * mCapacity + nIndex] = rect.getMaxY();
+    }
+
+    void push(const BoundRect2D& rect)
+    {
+        if (mSize == mCapacity)
+        {
+            reserve(mCapacity > 0 ? mCapacity * 2 : XY_SIMD_BLOCK);
+        }
+        ++mSize;
+        set(mSize - 1, rect);
+    }
+
+    // 删除指定位置的矩形，后续矩形依次前移(保持顺序)
+    void erase(int nIndex)
+    {
+        assert(nIndex >= 0 && nIndex < mSize);
+        for (int k = 0; k < 4; ++k)
+        {
+            double* coord = mCoord + k * mCapacity;
+            for (int i = nIndex + 1; i < mSize; ++i)
+            {
+                coord[i - 1] = coord[i];
+            }
+        }
+        --mSize;
+        setEmpty(mSize);
+    }
+
+    // 删除指定位置的矩形，最后一个矩形移入该位置(O(1)，不保持顺序)
+    void eraseSwap(int nIndex)
+    {
+        assert(nIndex >= 0 && nIndex < mSize);
+        --mSize;
+        for (int k = 0; k < 4; ++k)
+        {
+            mCoord[k * mCapacity + nIndex] = mCoord[k * mCapacity + mSize];
+        }
+        setEmpty(mSize);
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < mSize; ++i)
+        {
+            setEmpty(i);
+        }
+        mSize = 0;
+    }
+
+    // 用area数组(元素需提供 getBoundRect())中的包围盒替换全部矩形
+    template <typename AREA_T>
+    void assign(AREA_T* const* aAreaArray, int nCount)
+    {
+        clear();
+        reserve(nCount);
+        mSize = nCount;
+        for (int i = 0; i < nCount; ++i)
+        {
+            set(i, *aAreaArray[i]->getBoundRect());
+        }
+    }
+};
+
+/**
+ * @brief 计算从给定位置开始的 XY_SIMD_BLOCK 个矩形(SoA坐标数组)与查询矩形是否相交，返回位掩码(第i位对应第i个矩形)
+ * 相交判定与 BoundRect2D::isDisjoint 取反完全一致(边界接触视为相交)
+ */
+inline unsigned int xyTreeOverlapMask(const double* minX, const double* minY, const double* maxX, const double* maxY,
+                                      const BoundRect2D& srcRect)
+{
+#if defined(XY_SIMD_AVX)
+    __m256d cmp = _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(maxX), _mm256_set1_pd(srcRect.getMinX()), _CMP_GE_OQ),
+                                _mm256_cmp_pd(_mm256_loadu_pd(minX), _mm256_set1_pd(srcRect.getMaxX()), _CMP_LE_OQ));
+    cmp = _mm256_and_pd(cmp, _mm256_cmp_pd(_mm256_loadu_pd(maxY), _mm256_set1_pd(srcRect.getMinY()), _CMP_GE_OQ));
+    cmp = _mm256_and_pd(cmp, _mm256_cmp_pd(_mm256_loadu_pd(minY), _mm256_set1_pd(srcRect.getMaxY()), _CMP_LE_OQ));
+    return (unsigned int)_mm256_movemask_pd(cmp);
+#elif defined(XY_SIMD_SSE2)
+    const __m128d qMinX = _mm_set1_pd(srcRect.getMinX());
+    const __m128d qMaxX = _mm_set1_pd(srcRect.getMaxX());
+    const __m128d qMinY = _mm_set1_pd(srcRect.getMinY());
+    const __m128d qMaxY = _mm_set1_pd(srcRect.getMaxY());
+    unsigned int nMask = 0;
+    for (int i = 0; i < XY_SIMD_BLOCK; i += 2)
+    {
+        __m128d cmp =
+            _mm_and_pd(_mm_cmpge_pd(_mm_loadu_pd(maxX + i), qMinX), _mm_cmple_pd(_mm_loadu_pd(minX + i), qMaxX));
+        cmp = _mm_and_pd(cmp, _mm_cmpge_pd(_mm_loadu_pd(maxY + i), qMinY));
+        cmp = _mm_and_pd(cmp, _mm_cmple_pd(_mm_loadu_pd(minY + i), qMaxY));
+        nMask |= (unsigned int)_mm_movemask_pd(cmp) << i;
+    }
+    return nMask;
+#else
+    unsigned int nMask = 0;
+    for (int i = 0; i < XY_SIMD_BLOCK; ++i)
+    {
+        bool bJoint = maxX[i] >= srcRect.getMinX() && minX[i] <= srcRect.getMaxX() && maxY[i] >= srcRect.getMinY() &&
+                      minY[i] <= srcRect.getMaxY();
+        nMask |= (unsigned int)bJoint << i;
+    }
+    return nMask;
+#endif
+}
+
+// 计算 [nBegin, nBegin+XY_SIMD_BLOCK) 中各矩形与查询矩形是否相交，返回位掩码(第i位对应第nBegin+i个矩形)
+inline unsigned int xyTreeOverlapMask(const XYTreeRectArray& rectArray, int nBegin, const BoundRect2D& srcRect)
+{
+    return xyTreeOverlapMask(rectArray.getMinX() + nBegin, rectArray.getMinY() + nBegin, rectArray.getMaxX() + nBegin,
+                             rectArray.getMaxY() + nBegin, srcRect);
+}
+
+// 返回掩码中最低位1的位置
+inline int xyTreeLowestBit(unsigned int nMask)
+{
+    assert(nMask);
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(nMask);
+#else
+    int nBit = 0;
+    while (0 == (nMask & 1u))
+    {
+        nMask >>= 1;
+        ++nBit;
+    }
+    return nBit;
+#endif
+}
+
+}  // namespace Telos
+
+#endif  // XYTREE_SIMD_H
@@ -0,0 +1,293 @@
+#ifndef XYTREE_SNAPSHOT_H
+#define XYTREE_SNAPSHOT_H
+
+#include "Telos/macros.h"
+#include "Telos/xytree/xytree.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+namespace Telos
+{
+
+#define XYTREE_SNAPSHOT_MAGIC "TLXYSNAP"   // 文件标识(8字节)
+#define XYTREE_SNAPSHOT_VERSION 1          // 文件格式版本: 格式不兼容的修改必须递增
+#define XYTREE_SNAPSHOT_BYTE_ORDER 0x01020304u  // 字节序标记: 与读取端不一致时拒绝加载
+#define XYTREE_SNAPSHOT_ALIGN 64           // 各数据段在文件中的对齐字节数
+#define XYTREE_SNAPSHOT_NULL_CHILD -1      // 空子树
+
+/*
+ * 快照文件布局(所有数据段均为定长记录数组，按 XYTREE_SNAPSHOT_ALIGN 对齐，段之间只通过下标引用，不含指针):
+ *   XYTreeSnapshotHeader
+ *   XYTreeSnapshotNode[mNodeNum]   树节点，第0个为树根(先序)
+ *   XYTreeSnapshotLeaf[mLeafNum]   树叶
+ *   double[4][mSlotNum]            area包围盒(SoA): minX... | minY... | maxX... | maxY...
+ *   XYTreeSnapshotArea[mSlotNum]   area用户数据
+ * 每个树叶的area占据连续槽位，起始槽位按 XY_SIMD_BLOCK 对齐，尾部空槽位填充为空矩形，可直接按块做SIMD过滤。
+ */
+
+// 文件头
+struct XYTreeSnapshotHeader
+{
+    char mMagic[8];        // XYTREE_SNAPSHOT_MAGIC
+    uint32_t mVersion;     // XYTREE_SNAPSHOT_VERSION
+    uint32_t mByteOrder;   // XYTREE_SNAPSHOT_BYTE_ORDER
+    uint32_t mNodeNum;     // 树节点数
+    uint32_t mLeafNum;     // 树叶数
+    uint32_t mSlotNum;     // 槽位数(含对齐填充)
+    uint32_t mAreaNum;     // area数
+    uint64_t mNodeOffset;  // 树节点段的文件偏移
+    uint64_t mLeafOffset;  // 树叶段的文件偏移
+    uint64_t mRectOffset;  // 包围盒段的文件偏移
+    uint64_t mAreaOffset;  // 用户数据段的文件偏移
+    uint64_t mFileSize;    // 文件总字节数
+};
+
+// 树节点记录(64字节)
+struct XYTreeSnapshotNode
+{
+    double mBound[4];                   // 包围盒: minX, minY, maxX, maxY
+    double mSplitPos;                   // 分割位置
+    XYTreeTypeMask mTypeMask;           // 子树的类型掩码(为0表示空子树)
+    int32_t mChild[XYTREE_CHILD_NUM];   // 左中右子树下标(树节点或树叶下标)，空子树为 XYTREE_SNAPSHOT_NULL_CHILD
+    uint8_t mIsLeaf[XYTREE_CHILD_NUM];  // 子树是否为树叶
+    uint8_t mSplitDir;                  // 分割方向(XYTreeSplitDirection)
+};
+
+// 树叶记录(48字节)
+struct XYTreeSnapshotLeaf
+{
+    double mBound[4];          // 包围盒: minX, minY, maxX, maxY
+    XYTreeTypeMask mTypeMask;  // 树叶的类型掩码
+    uint32_t mSlotBegin;       // 起始槽位(XY_SIMD_BLOCK的整数倍)
+    uint32_t mAreaNum;         // area数
+};
+
+// 写入快照时为area指定用户ID
+typedef std::function<uint64_t(const ComponentArea*)> XYTreeSnapshotIdFunc;
+
+// area用户数据记录(16字节)
+struct XYTreeSnapshotArea
+{
+    uint64_t mUserData;  // 用户ID: 写入时由调用者指定，默认为 ComponentArea::getAddr() 的整数值
+    int32_t mTypeId;     // 器件类型
+    int32_t mHandle;     // 写入时的器件区域句柄
+};
+
+/**
+ * @brief RXYTree 的只读快照: 将树写为扁平、无指针、基于下标的二进制文件，加载时直接内存映射(mmap)，
+ * 无需反序列化即可查询；多个进程映射同一个文件时通过页缓存共享同一份物理内存。
+ * 快照以槽位(slot)标识area，通过 getAreaRect/getAreaTypeId/getAreaUserData/getAreaHandle 访问area信息。
+ * 快照不可修改，可以在任意多个线程中无锁并发查询。
+ */
+class TELOS_PUBLIC XYTreeSnapshot
+{
+   private:
+    const char* mData;   // 文件数据(映射地址或堆内存)
+    size_t mSize;        // 文件数据字节数
+    bool mIsMapped;      // 数据是否为内存映射
+    const XYTreeSnapshotHeader* mHeader;
+    const XYTreeSnapshotNode* mNodeArray;
+    const XYTreeSnapshotLeaf* mLeafArray;
+    const double* mMinX;
+    const double* mMinY;
+    const double* mMaxX;
+    const double* mMaxY;
+    const XYTreeSnapshotArea* mAreaArray;
+
+   private:
+    // 校验文件头和各数据段并建立段指针，失败时返回false
+    bool attach();
+
+    static bool isDisjoint(const double* aBound, const BoundRect2D& srcRect)
+    {
+        return srcRect.getMinX() > aBound[2] || srcRect.getMaxX() < aBound[0] || srcRect.getMinY() > aBound[3] ||
+               srcRect.getMaxY() < aBound[1];
+    }
+
+    template <typename Visitor>
+    bool searchLeaf(int nLeaf, const BoundRect2D& srcRect, Visitor& visitor, XYTreeTypeMask aTypeMask) const;
+
+    // 子树是否可以剪掉(类型不符或包围盒不相交)
+    bool isPruned(const XYTreeIndexItem& item, const BoundRect2D& srcRect, XYTreeTypeMask aTypeMask) const
+    {
+        XYTreeTypeMask typeMask = item.mIsLeaf ? mLeafArray[item.mIndex].mTypeMask : mNodeArray[item.mIndex].mTypeMask;
+        return 0 == (typeMask & aTypeMask) ||
+               isDisjoint(item.mIsLeaf ? mLeafArray[item.mIndex].mBound : mNodeArray[item.mIndex].mBound, srcRect);
+    }
+
+    template <typename Visitor>
+    bool searchTree(const BoundRect2D& srcRect, Visitor& visitor, XYTreeTypeMask aTypeMask) const;
+
+   public:
+    XYTreeSnapshot();
+    ~XYTreeSnapshot();
+
+    XYTreeSnapshot(const XYTreeSnapshot&) = delete;
+    XYTreeSnapshot& operator=(const XYTreeSnapshot&) = delete;
+
+    /**
+     * @brief 将树写入快照文件(建议先调用 rebalance)
+     * 快照会被其他进程加载，指针在其他进程中无意义: 需要跨进程使用的用户数据必须是整数ID。
+     * 未指定 aIdFunc 时写入 ComponentArea::getAddr() 的整数值，此时调用者应在 addr 中保存整数ID而不是指针
+     * @param tree 树
+     * @param aFileName 文件名
+     * @param aIdFunc 为每个area返回写入快照的用户ID(可为空)，加载后通过 getAreaUserData 获取
+     * @return true:写入成功 ｜ false:文件无法写入
+     */
+    static bool write(const RXYTree& tree, const char* aFileName, const XYTreeSnapshotIdFunc& aIdFunc = nullptr);
+
+    /**
+     * @brief 打开快照文件: 映射到内存并校验文件头，不读取或转换任何树数据(Windows下整体读入内存)
+     * @param aFileName 文件名
+     * @return true:打开成功 ｜ false:文件不存在、版本不一致或数据损坏
+     */
+    bool open(const char* aFileName);
+
+    // 关闭快照(解除映射)
+    void close();
+
+    bool isOpen() const { return nullptr != mHeader; }
+
+    int getNodeNum() const { return mHeader ? (int)mHeader->mNodeNum : 0; }
+    int getLeafNum() const { return mHeader ? (int)mHeader->mLeafNum : 0; }
+    int getAreaNum() const { return mHeader ? (int)mHeader->mAreaNum : 0; }
+
+    BoundRect2D getAreaRect(int aSlot) const
+    {
+        return BoundRect2D(mMinX[aSlot], mMinY[aSlot], mMaxX[aSlot], mMaxY[aSlot]);
+    }
+    int getAreaTypeId(int aSlot) const { return mAreaArray[aSlot].mTypeId; }
+    uint64_t getAreaUserData(int aSlot) const { return mAreaArray[aSlot].mUserData; }
+    XYTreeHandle getAreaHandle(int aSlot) const { return mAreaArray[aSlot].mHandle; }
+
+    /**
+     * @brief 搜索与 srcRect 相交的area，对每个area的槽位调用访问者
+     * @param srcRect 搜索区域
+     * @param visitor 访问者: bool(int aSlot) 返回false时停止搜索；也可以返回void
+     * @param aTypeMask 器件类型掩码，只访问类型位于掩码中的area
+     * @return true:搜索完成 ｜ false:被访问者提前停止
+     */
+    template <typename Visitor>
+    bool search(const BoundRect2D& srcRect, Visitor&& visitor, XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+
+    /**
+     * @brief 将和指定矩形区碰撞的area槽位追加到数组中
+     * @param slotArray 结果数组(不清空，结果追加在末尾)
+     * @return int 追加的area数
+     */
+    int getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY, std::vector<int>& slotArray,
+                            XYTreeTypeMask aTypeMask = XYTREE_TYPE_MASK_ALL) const;
+};
+
+// 调用槽位访问者，返回值为void的访问者视为总是继续
+template <typename Visitor>
+inline bool xyTreeVisitSlot(Visitor& visitor, int aSlot)
+{
+    if constexpr (std::is_void<decltype(visitor(aSlot))>::value)
+    {
+        visitor(aSlot);
+        return true;
+    }
+    else
+    {
+        return visitor(aSlot);
+    }
+}
+
+template <typename Visitor>
+inline bool XYTreeSnapshot::searchLeaf(int nLeaf, const BoundRect2D& srcRect, Visitor& visitor,
+                                       XYTreeTypeMask aTypeMask) const
+{
+    const XYTreeSnapshotLeaf& leaf = mLeafArray[nLeaf];  //调用者已按类型掩码和包围盒剪枝
+    const bool bFilterType = (leaf.mTypeMask & ~aTypeMask) != 0;  //树叶中存在需要过滤掉的类型
+    for (uint32_t nBegin = leaf.mSlotBegin, nEnd = leaf.mSlotBegin + leaf.mAreaNum; nBegin < nEnd;
+         nBegin += XY_SIMD_BLOCK)
+    {
+        unsigned int nMask =
+            xyTreeOverlapMask(mMinX + nBegin, mMinY + nBegin, mMaxX + nBegin, mMaxY + nBegin, srcRect);
+        while (nMask)
+        {
+            int nSlot = (int)nBegin + xyTreeLowestBit(nMask);
+            nMask &= nMask - 1;
+            if (bFilterType && !(aTypeMask & xyTreeTypeBit(mAreaArray[nSlot].mTypeId)))
+            {
+                continue;
+            }
+            if (!xyTreeVisitSlot(visitor, nSlot))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+inline bool XYTreeSnapshot::searchTree(const BoundRect2D& srcRect, Visitor& visitor, XYTreeTypeMask aTypeMask) const
+{
+    XYTreeIndexItem item = {0, false};
+    if (isPruned(item, srcRect, aTypeMask))
+    {
+        return true;
+    }
+
+    // 与 XYTreeNode::search 相同的显式栈遍历: 第一个需要遍历的子树直接进入，其余逆序入栈
+    XYTreeSmallStack<XYTreeIndexItem> stack;
+    while (true)
+    {
+        XYTreeIndexItem childArray[XYTREE_CHILD_NUM];
+        int nChildNum = 0;
+        if (item.mIsLeaf)
+        {
+            if (!searchLeaf(item.mIndex, srcRect, visitor, aTypeMask))
+                return false;
+        }
+        else
+        {
+            // 查询区域在分割位置左侧时跳过右子树，在右侧时跳过左子树，总是遍历中子树
+            const XYTreeSnapshotNode& node = mNodeArray[item.mIndex];
+            bool bSplitX = XYTREE_SPLIT_X == node.mSplitDir;
+            bool bVisit[XYTREE_CHILD_NUM] = {(bSplitX ? srcRect.getMinX() : srcRect.getMinY()) <= node.mSplitPos,
+                                             true,
+                                             (bSplitX ? srcRect.getMaxX() : srcRect.getMaxY()) >= node.mSplitPos};
+            for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+            {
+                XYTreeIndexItem child = {node.mChild[i], node.mIsLeaf[i] != 0};
+                if (!bVisit[i] || XYTREE_SNAPSHOT_NULL_CHILD == child.mIndex)
+                    continue;
+                if (isPruned(child, srcRect, aTypeMask))
+                    continue;
+                childArray[nChildNum++] = child;
+            }
+        }
+
+        if (0 == nChildNum)
+        {
+            if (stack.empty())
+                return true;
+            item = stack.pop();
+            continue;
+        }
+        for (int i = nChildNum - 1; i > 0; --i)
+        {
+            stack.push(childArray[i]);
+        }
+        item = childArray[0];
+    }
+}
+
+template <typename Visitor>
+inline bool XYTreeSnapshot::search(const BoundRect2D& srcRect, Visitor&& visitor,
+                                   XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    if (nullptr == mHeader || 0 == mHeader->mNodeNum)
+        return true;
+    return searchTree(srcRect, visitor, aTypeMask);
+}
+
+}  // namespace Telos
+
+#endif  // XYTREE_SNAPSHOT_H
@@ -0,0 +1,100 @@
+#ifndef XYTREE_THREAD_POOL_H
+#define XYTREE_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Telos
+{
+
+/**
+ * @brief 任务组: 记录一组已提交但尚未完成的任务，供 XYTreeThreadPool::wait 等待
+ */
+class XYTreeTaskGroup
+{
+   private:
+    std::atomic<int> mPendingNum{0};  // 未完成的任务数
+
+    friend class XYTreeThreadPool;
+
+   public:
+    bool isFinished() const { return 0 == mPendingNum.load(std::memory_order_acquire); }
+};
+
+/**
+ * @brief 工作窃取(work-stealing)线程池
+ * 每个工作线程拥有独立的任务队列：本线程提交的任务压入自身队列尾部并从尾部取出(LIFO，利于缓存局部性)，
+ * 空闲线程从其他队列头部窃取任务。调用 wait() 的线程在等待期间也会执行任务，因此任务内部可以嵌套提交和等待。
+ * 线程总数包含调用线程：nThreadNum 个线程中有 nThreadNum-1 个后台工作线程。
+ */
+class XYTreeThreadPool
+{
+   private:
+    struct WorkQueue
+    {
+        std::mutex mMutex;
+        std::deque<std::pair<std::function<void()>, XYTreeTaskGroup*>> mTaskList;
+    };
+
+    std::vector<std::thread> mThreadArray;  // 后台工作线程
+    std::vector<WorkQueue*> mQueueArray;    // 任务队列: [0]为外部线程共享队列，[i]为第i个工作线程的队列
+    std::mutex mSleepMutex;                 // 工作线程休眠锁
+    std::condition_variable mSleepCond;     // 工作线程休眠条件
+    std::atomic<int> mQueuedNum{0};         // 排队中的任务数
+    std::atomic<bool> mIsStop{false};       // 是否停止线程池
+
+   private:
+    // 获取当前线程在本线程池中的队列索引，非工作线程返回0
+    int getQueueIndex() const;
+
+    // 取出一个任务并执行，返回是否执行了任务
+    bool runOneTask(int nQueueIndex);
+
+    void workerLoop(int nQueueIndex);
+
+   public:
+    /**
+     * @brief 创建线程池
+     * @param nThreadNum 线程总数(含调用线程)，<=0 时使用硬件线程数
+     */
+    explicit XYTreeThreadPool(int nThreadNum);
+    ~XYTreeThreadPool();
+
+    XYTreeThreadPool(const XYTreeThreadPool&) = delete;
+    XYTreeThreadPool& operator=(const XYTreeThreadPool&) = delete;
+
+    /**
+     * @brief 获取线程总数(含调用线程)
+     * @return int 线程数
+     */
+    int getThreadNum() const { return (int)mThreadArray.size() + 1; }
+
+    /**
+     * @brief 提交一个任务到任务组
+     * @param group 任务组
+     * @param task 任务
+     */
+    void submit(XYTreeTaskGroup& group, std::function<void()> task);
+
+    /**
+     * @brief 等待任务组中的所有任务完成，等待期间当前线程会协助执行任务
+     * @param group 任务组
+     */
+    void wait(XYTreeTaskGroup& group);
+
+    /**
+     * @brief 并行执行 nTaskNum 个任务 func(0) ... func(nTaskNum-1)，返回时所有任务均已完成
+     * @param nTaskNum 任务数
+     * @param func 任务函数，参数为任务索引
+     */
+    void parallelFor(int nTaskNum, const std::function<void(int)>& func);
+};
+
+}  // namespace Telos
+
+#endif  // XYTREE_THREAD_POOL_H
@@ -41,12 +41,6 @@ void BoundRect2D::expandBound(const BoundRect2D* aSrcBound)
     assert(isValid());
 }
 
-bool BoundRect2D::isDisjoint(const BoundRect2D* aSrcBound) const
-{
-    assert(aSrcBound && aSrcBound->isValid());
-    return aSrcBound->mMinX > this->mMaxX || aSrcBound->mMaxX < this->mMinX || aSrcBound->mMinY > this->mMaxY ||
-           aSrcBound->mMaxY < this->mMinY;
-}
 bool BoundRect2D::isContains(const BoundRect2D* aSrcBound) const
 {
     assert(aSrcBound && aSrcBound->isValid());
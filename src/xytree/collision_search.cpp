@@ -0,0 +1,125 @@
+#include "Telos/xytree/collision_search.h"
+
+namespace Telos
+{
+
+RXYTreeSearchBox::RXYTreeSearchBox() : mTypeMask(XYTREE_TYPE_MASK_ALL) {}
+
+RXYTreeSearchBox::~RXYTreeSearchBox() {}
+
+void RXYTreeSearchBox::pushChild(const XYTreeNode* node, XYTreeChildType aChildType)
+{
+    if (node->isChildAreaArray(aChildType))
+    {
+        const XYTreeLeaf* leaf = node->getChildLeaf(aChildType);
+        if (leaf && (leaf->getTypeMask() & mTypeMask) && !mBoundRect.isDisjoint(leaf->getBoundRect()))
+        {
+            mSearchStack.emplace_back(leaf, true);
+        }
+        return;
+    }
+    const XYTreeNode* child = node->getChildNode(aChildType);
+    if ((child->getTypeMask() & mTypeMask) && !mBoundRect.isDisjoint(child->getBoundRect()))
+    {
+        mSearchStack.emplace_back(child, false);
+    }
+}
+
+ComponentArea* RXYTreeSearchBox::nextInLeaf()
+{
+    const XYTreeAreaArray& areaArray = mCurLeaf->getAreaArray();
+    const XYTreeRectArray& rectArray = mCurLeaf->getRectArray();
+    while (true)
+    {
+        // 当前块的相交掩码取完后，计算下一块的相交掩码
+        while (0 == mCurMask)
+        {
+            mCurSearchIndex += XY_SIMD_BLOCK;
+            if (mCurSearchIndex >= rectArray.size())
+                return nullptr;
+            mCurMask = xyTreeOverlapMask(rectArray, mCurSearchIndex, mBoundRect);
+        }
+        ComponentArea* area = areaArray[mCurSearchIndex + xyTreeLowestBit(mCurMask)];
+        assert(area);
+        mCurMask &= mCurMask - 1;
+        if (mFilterType && !(mTypeMask & xyTreeTypeBit(area->getTypeId())))
+        {
+            continue;
+        }
+        return area;
+    }
+}
+
+void RXYTreeSearchBox::begin(const RXYTree& tree, const BoundRect2D& srcRect,
+                             XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/)
+{
+    reset();
+    mBoundRect = srcRect;
+    mTypeMask = aTypeMask;
+    const XYTreeNode* root = tree.getRootNode();
+    if (root && (root->getTypeMask() & mTypeMask) && !mBoundRect.isDisjoint(root->getBoundRect()))
+    {
+        mSearchStack.emplace_back(root, false);
+    }
+}
+
+ComponentArea* RXYTreeSearchBox::next()
+{
+    while (true)
+    {
+        if (mCurLeaf)
+        {
+            ComponentArea* area = nextInLeaf();
+            if (area)
+                return area;
+            mCurLeaf = nullptr;
+        }
+        if (mSearchStack.empty())
+            return nullptr;
+
+        RXYTreeSearchItem item = mSearchStack.back();
+        mSearchStack.pop_back();
+        if (item.isAreaArray())
+        {
+            mCurLeaf = item.getLeaf();
+            mCurSearchIndex = -XY_SIMD_BLOCK;
+            mCurMask = 0;
+            mFilterType = (mCurLeaf->getTypeMask() & ~mTypeMask) != 0;
+            continue;
+        }
+
+        // 与 XYTreeNode::search 相同的剪枝规则，逆序压栈使左子树先被搜索
+        const XYTreeNode* node = item.getNode();
+        XYTreeChildType childType = node->getChildType(&mBoundRect);
+        if (XYTREE_CHILD_MIDDLE == childType || XYTREE_CHILD_RIGHT == childType)
+            pushChild(node, XYTREE_CHILD_RIGHT);
+        pushChild(node, XYTREE_CHILD_MIDDLE);
+        if (XYTREE_CHILD_LEFT == childType || XYTREE_CHILD_MIDDLE == childType)
+            pushChild(node, XYTREE_CHILD_LEFT);
+    }
+}
+
+int RXYTreeSearchBox::next(int aCount, std::vector<ComponentArea*>& resultArray)
+{
+    int nCount = 0;
+    while (nCount < aCount)
+    {
+        ComponentArea* area = next();
+        if (nullptr == area)
+            break;
+        resultArray.push_back(area);
+        ++nCount;
+    }
+    return nCount;
+}
+
+void RXYTreeSearchBox::reset()
+{
+    mSearchStack.clear();
+    mCurLeaf = nullptr;
+    mCurSearchIndex = 0;
+    mCurMask = 0;
+    mFilterType = false;
+}
+
+}  // namespace Telos
@@ -1,7 +1,10 @@
 #include "Telos/xytree/xytree.h"
 #include "Telos/xytree/bound_rect2d.h"
 
+#include <math.h>
 #include <stdio.h>
+#include <algorithm>
+#include <functional>
 #include <string>
 
 namespace Telos
@@ -11,28 +14,33 @@ void ComponentArea::setUserData(int typeId, void* addr)
     mTypeId = typeId;
     mAddr = addr;
 }
-ComponentArea::ComponentArea() : mCompGeoData(nullptr), mCompId(0), mBoundRect(new BoundRect2D()), mTypeId(-1), mAddr(nullptr)
+ComponentArea::ComponentArea()
+    : mCompGeoData(nullptr), mCompId(0), mBoundRect(), mTypeId(-1), mAddr(nullptr), mHandle(XYTREE_INVALID_HANDLE)
 {
-    assert(mBoundRect);
-}
-ComponentArea::~ComponentArea()
-{
-    if (mBoundRect)
-    {
-        delete mBoundRect;
-        mBoundRect = nullptr;
-    }
 }
 ComponentArea* ComponentArea::createComponentArea(double minX, double minY, double maxX, double maxY, int typeId,
                                                   void* userDef)
 {
     ComponentArea* area = new ComponentArea();
     assert(area);
-    area->mBoundRect->setBound(minX, minY, maxX, maxY);
+    area->mBoundRect.setBound(minX, minY, maxX, maxY);
+    area->setUserData(typeId, userDef);
+    return area;
+}
+ComponentArea* ComponentArea::createComponentArea(XYTreeMemPool* memPool, double minX, double minY, double maxX,
+                                                  double maxY, int typeId, void* userDef)
+{
+    if (nullptr == memPool)
+    {
+        return createComponentArea(minX, minY, maxX, maxY, typeId, userDef);
+    }
+    ComponentArea* area = memPool->create<ComponentArea>();
+    assert(area);
+    area->mBoundRect.setBound(minX, minY, maxX, maxY);
     area->setUserData(typeId, userDef);
     return area;
 }
-BoundRect2D ComponentArea::calcAreaArrayBound(const std::vector<ComponentArea*>& areaArray)
+BoundRect2D ComponentArea::calcAreaArrayBound(const XYTreeAreaArray& areaArray)
 {
     assert(areaArray.size() > 0);
     BoundRect2D bounRect;
@@ -42,7 +50,7 @@ BoundRect2D ComponentArea::calcAreaArrayBound(const std::vector<ComponentArea*>&
     }
     return bounRect;
 }
-void ComponentArea::print(const std::vector<ComponentArea*>& areaArray, const char* prefixInfo)
+void ComponentArea::print(const XYTreeAreaArray& areaArray, const char* prefixInfo)
 {
     for (auto* area : areaArray)
     {
@@ -79,11 +87,11 @@ const void* ComponentArea::getCompGeoData() const
 }
 BoundRect2D* ComponentArea::getBoundRect()
 {
-    return mBoundRect;
+    return &mBoundRect;
 }
 const BoundRect2D* ComponentArea::getBoundRect() const
 {
-    return mBoundRect;
+    return &mBoundRect;
 }
 int ComponentArea::getTypeId() const
 {
@@ -100,7 +108,7 @@ const void* ComponentArea::getAddr() const
 
 bool ComponentArea::isEqual(const ComponentArea* otherArea) const
 {
-    return mBoundRect->isEqual(otherArea->getBoundRect()) && mTypeId == otherArea->mTypeId && mAddr == otherArea->mAddr;
+    return mBoundRect.isEqual(otherArea->getBoundRect()) && mTypeId == otherArea->mTypeId && mAddr == otherArea->mAddr;
 }
 
 void XYTreeNode::isValid() const
@@ -113,27 +121,6 @@ void XYTreeNode::isValid() const
         }
     }
 }
-void XYTreeNode::searchChild(XYTreeChildType childIndex, const BoundRect2D& srcRect,
-                              std::vector<ComponentArea*>& resultArray) const
-{
-    if (nullptr == mChild[childIndex])
-    {
-        //assert(false);
-        return;
-    }
-
-    if (mIsAreaArray[childIndex])  //左子树为树叶
-    {
-        const XYTreeLeaf* leaf = (const XYTreeLeaf*)mChild[childIndex];
-        leaf->getJointArea(srcRect, resultArray);
-    }
-    else
-    {
-        XYTreeNode* node = (XYTreeNode*)mChild[childIndex];
-        assert(node);
-        node->search(srcRect, resultArray);  //递归：继续向下遍历左子树
-    }
-}
 void XYTreeNode::printChild(const char* pSpan, const char* pChildStr, XYTreeChildType childIndex, int nLevel)
 {
     if (mChild[childIndex])
@@ -172,9 +159,8 @@ void XYTreeNode::printChild(const char* pSpan, const char* pChildStr, XYTreeChil
         assert(mIsAreaArray[childIndex]);
     }
 }
-XYTreeNode::XYTreeNode() : mBBox(new BoundRect2D()), mParent(nullptr), mSplitDir(XYTREE_SPLIT_X), mSplitPos(-1)
+XYTreeNode::XYTreeNode() : mBBox(), mParent(nullptr), mSplitDir(XYTREE_SPLIT_X), mSplitPos(-1), mTypeMask(0)
 {
-    assert(mBBox);
     for (auto& child : mChild)
     {
         child = nullptr;
@@ -187,49 +173,19 @@ XYTreeNode::XYTreeNode() : mBBox(new BoundRect2D()), mParent(nullptr), mSplitDir
 
     isValid();
 }
-XYTreeNode::~XYTreeNode()
-{
-    if (mBBox)
-    {
-        delete mBBox;
-        mBBox = nullptr;
-    }
-
-    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
-    {
-        if (mChild[i])
-        {
-            if (mIsAreaArray[i])  // If the current child is a leaf node
-            {
-                XYTreeLeaf* leaf = (XYTreeLeaf*)mChild[i];
-                delete leaf;
-                leaf = nullptr;
-            }
-            else
-            {
-                XYTreeNode* node = (XYTreeNode*)mChild[i];
-                delete node;
-                node = nullptr;
-            }
-            mChild[i] = nullptr;
-        }
-        else
-        {
-            assert(mIsAreaArray[i]);
-        }
-    }
-}
-XYTreeNode* XYTreeNode::createTreeNode(double aSplitPos, XYTreeSplitDirection aSplitDir /* = XYTREE_SPLIT_X*/)
+XYTreeNode* XYTreeNode::createTreeNode(XYTreeMemPool* aMemPool, double aSplitPos,
+                                       XYTreeSplitDirection aSplitDir /* = XYTREE_SPLIT_X*/)
 {
-    XYTreeNode* node = new XYTreeNode();
+    assert(aMemPool);
+    XYTreeNode* node = aMemPool->create<XYTreeNode>();
     assert(node);
     node->mSplitPos = aSplitPos;
     node->mSplitDir = aSplitDir;
     return node;
 }
-void XYTreeNode::freeNodesWithoutArea(XYTreeNode** aNode, bool bFreeRoot)
+void XYTreeNode::freeNodesWithoutArea(XYTreeMemPool* aMemPool, XYTreeNode** aNode, bool bFreeRoot)
 {
-    assert(aNode && *aNode);
+    assert(aMemPool && aNode && *aNode);
     for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)  // 遍历左中右3个子树，释放子节点（但不释放树叶）
     {
         if ((*aNode)->mChild[i])
@@ -237,13 +193,13 @@ void XYTreeNode::freeNodesWithoutArea(XYTreeNode** aNode, bool bFreeRoot)
             if (!(*aNode)->mIsAreaArray[i])
             {
                 XYTreeNode* node = (XYTreeNode*)((*aNode)->mChild[i]);
-                freeNodesWithoutArea(&node, true);
+                freeNodesWithoutArea(aMemPool, &node, true);
             }
             else
             {
                 XYTreeLeaf* leaf = (XYTreeLeaf*)((*aNode)->mChild[i]);
-
-                delete leaf;
+                leaf->removeAreaArray(false);
+                aMemPool->destroy(leaf);
             }
             (*aNode)->mChild[i] = nullptr;
         }
@@ -251,44 +207,34 @@ void XYTreeNode::freeNodesWithoutArea(XYTreeNode** aNode, bool bFreeRoot)
 
     if (bFreeRoot)  // 释放子节点自身
     {
-        delete (*aNode);
+        aMemPool->destroy(*aNode);
         *aNode = nullptr;
     }
 }
-int XYTreeNode::getLogTime(int n)
+bool XYTreeNode::chooseSplit(ComponentArea* const* aAreaArray, int aAreaNum, BoundRect2D& aBound,
+                             XYTreeSplitDirection& aSplitDir, double& aSplitPos)
 {
-    int i = 0;
-    do
+    if (aAreaNum <= 0)
     {
-        ++i;
-        n >>= 1;
-    } while (n > 0);
-    return i;
-}
-void* XYTreeNode::rebalance(const XYTreeLeaf* aLeaf, bool& bOriginArray)
-{
-    if (nullptr == aLeaf)
+        return false;
+    }
+    aBound = BoundRect2D();
+    for (int i = 0; i < aAreaNum; ++i)
     {
-        bOriginArray = true;
-        return (void*)aLeaf;
+        aBound.expandBound(aAreaArray[i]->getBoundRect());
     }
-    const std::vector<ComponentArea*>* areaArray = &aLeaf->getAreaArray();
-    int areaNum = areaArray->size();
-    if (areaNum < XY_THRESHOLD)
+    if (aAreaNum < XY_THRESHOLD)
     {
-        bOriginArray = true;
-        return (void*)aLeaf;
+        return false;
     }
-    assert(areaNum < 10);
 
-    BoundRect2D resultRect = ComponentArea::calcAreaArrayBound(*areaArray);
-    double midX = (resultRect.getMinX() + resultRect.getMaxX()) / 2.0;
-    double midY = (resultRect.getMinY() + resultRect.getMaxY()) / 2.0;
+    double midX = (aBound.getMinX() + aBound.getMaxX()) / 2.0;
+    double midY = (aBound.getMinY() + aBound.getMaxY()) / 2.0;
 
     int nLeftX = 0, nRightX = 0, nLeftY = 0, nRightY = 0;
-    for (const ComponentArea* area : *areaArray)
+    for (int i = 0; i < aAreaNum; ++i)
     {
-        const BoundRect2D* rect = area->getBoundRect();
+        const BoundRect2D* rect = aAreaArray[i]->getBoundRect();
         if (rect->getMaxX() < midX)
             ++nLeftX;
         if (rect->getMinX() > midX)
@@ -298,110 +244,130 @@ void* XYTreeNode::rebalance(const XYTreeLeaf* aLeaf, bool& bOriginArray)
         if (rect->getMinY() > midY)
             ++nRightY;
     }
-    bool bSplitDirX = true;
-    double fom_x = 0.0, fom_y = 0.0;
-    if (nLeftX && nRightX && nLeftY && nRightY)
-    {
-        fom_x = (double)nLeftX * (double)XYTreeNode::getLogTime(nLeftX) +
-                (double)areaNum * (double)XYTreeNode::getLogTime(areaNum - nLeftX - nRightX) +
-                (double)nRightX * (double)XYTreeNode::getLogTime(nRightX);  //X方向最优值
-        fom_y = (double)nLeftY * (double)XYTreeNode::getLogTime(nLeftY) +
-                (double)areaNum * (double)XYTreeNode::getLogTime(areaNum - nLeftY - nRightY) +
-                (double)nRightY * (double)XYTreeNode::getLogTime(nRightY);  //Y方向最优值
-        bSplitDirX = (fom_x <= fom_y);                                       //沿着最优值更小的方向分割
-    }
-    else if (nLeftX && nRightX)
-    {
-        bSplitDirX = true;  //X方向分割
-    }
-    else
+    aSplitDir = xyTreeChooseSplitDir(aAreaNum, nLeftX, nRightX, nLeftY, nRightY);
+    if (XYTREE_SPLIT_INVALID == aSplitDir)  //若左右两侧的尺寸小于门限，或所有area分布在单侧，无需继续平衡化
     {
-        bSplitDirX = false;  //Y方向分割
+        return false;
     }
+    aSplitPos = XYTREE_SPLIT_X == aSplitDir ? midX : midY;
+    return true;
+}
+XYTreeNode* XYTreeNode::splitAreaArray(XYTreeMemPool* aMemPool, ComponentArea** aAreaArray, int aAreaNum,
+                                       const BoundRect2D& aBound, XYTreeSplitDirection aSplitDir, double aSplitPos,
+                                       XYTreeThreadPool* aThreadPool, int aParallelCutoff)
+{
+    XYTreeNode* tree = XYTreeNode::createTreeNode(aMemPool, aSplitPos, aSplitDir);  //创建一个子节点
+    tree->mBBox = aBound;
 
-    XYTreeNode* tree = nullptr;
-    if (bSplitDirX)
+    // 原地划分area数组：完全在分割点左侧的area放在最前，完全在右侧的area放在最后，其余的放在中间
+    ComponentArea** first = aAreaArray;
+    ComponentArea** last = aAreaArray + aAreaNum;
+    ComponentArea** midFirst =
+        std::partition(first, last, [tree](const ComponentArea* area)
+                       { return XYTREE_CHILD_LEFT == tree->getChildType(area->getBoundRect()); });
+    ComponentArea** rightFirst =
+        std::partition(midFirst, last, [tree](const ComponentArea* area)
+                       { return XYTREE_CHILD_MIDDLE == tree->getChildType(area->getBoundRect()); });
+
+    ComponentArea** childFirst[XYTREE_CHILD_NUM] = {first, midFirst, rightFirst};
+    int childNum[XYTREE_CHILD_NUM] = {(int)(midFirst - first), (int)(rightFirst - midFirst), (int)(last - rightFirst)};
+
+    // 左中右子树相互独立: 尺寸超过门限的子树作为任务并行构建，每个任务使用独立的内存池，完成后由当前线程合并
+    XYTreeTaskGroup group;
+    XYTreeMemPool* childPool[XYTREE_CHILD_NUM] = {nullptr, nullptr, nullptr};
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
     {
-        if (nLeftX + nRightX < XY_THRESHOLD)  //若左右两侧的尺寸小于门限，
+        if (0 == childNum[i])  //中子树可能为空
         {
-            bOriginArray = true;
-            return (void*)aLeaf;  //返回树叶area链表头指针11，无需继续平衡化
+            continue;
         }
-
-        tree = XYTreeNode::createTreeNode(
-            midX, XYTREE_SPLIT_X);  //创建一个子节点（近邻树叶）：坐标初值xmid，默认X方向垂直分割，且存放树叶
-        for (
-            ComponentArea* area :
-            *areaArray)  //从当前树叶area列表头开始，遍历每个area，将完全在xmid左侧的area加入到左子树页头，完全在xmid右侧的area加入右子树页头，其余的加入中子树页头
+        if (aThreadPool && childNum[i] >= aParallelCutoff)
         {
-            assert(area);
-            if (area->getBoundRect()->getMaxX() < midX)  //若当前area在中点左侧，则将当前area加入到新节点的左子树叶头
-            {
-                tree->addLeafArea(XYTREE_CHILD_LEFT, area);
-            }
-            else if (area->getBoundRect()->getMinX() >
-                     midX)  //若当前area在中点右侧，则将当前area加入到新节点的右子树叶头
-            {
-                tree->addLeafArea(XYTREE_CHILD_RIGHT, area);
-            }
-            else
-            {
-                tree->addLeafArea(XYTREE_CHILD_MIDDLE, area);  //否则，则将当前area加入到新节点的中子树叶头
-            }
+            XYTreeMemPool* pool = new XYTreeMemPool();
+            childPool[i] = pool;
+            ComponentArea** areaArray = childFirst[i];
+            int areaNum = childNum[i];
+            aThreadPool->submit(group,
+                                [=]
+                                {
+                                    tree->mChild[i] = buildSubTree(pool, areaArray, areaNum, tree->mIsAreaArray[i],
+                                                                   aThreadPool, aParallelCutoff);
+                                });
+        }
+        else
+        {
+            tree->mChild[i] = buildSubTree(aMemPool, childFirst[i], childNum[i], tree->mIsAreaArray[i], aThreadPool,
+                                           aParallelCutoff);
         }
     }
-    else
+    if (aThreadPool)
+    {
+        aThreadPool->wait(group);
+    }
+
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
     {
-        if (!nLeftY || !nRightY || nLeftY + nRightY < XY_THRESHOLD)  //若左右两侧的尺寸小于门限，或所有area分布在单侧
+        if (childPool[i])
         {
-            bOriginArray = true;
-            return (void*)aLeaf;  //返回树叶area链表头指针11，无需继续平衡化
+            aMemPool->adopt(childPool[i]);  //子树中的对象仍引用子内存池，由当前内存池接管其所有权
         }
-
-        tree = XYTreeNode::createTreeNode(midY, XYTREE_SPLIT_Y);  //创建一个子节点（近邻树叶）：Y方向分割，坐标改为yMid
-        for (
-            ComponentArea* area :
-            *areaArray)  //从当前树叶area列表头开始，遍历每个area，将完全在yMid左侧的area加入到左子树页头，完全在yMid右侧的area加入右子树页头，其余的加入中子树页头
+        if (nullptr == tree->mChild[i])
         {
-            assert(area);
-            if (area->getBoundRect()->getMaxY() < midY)  //若当前area在中点左侧，则将当前area加入到新节点的左子树叶头
-            {
-                tree->addLeafArea(XYTREE_CHILD_LEFT, area);
-            }
-            else if (area->getBoundRect()->getMinY() >
-                     midY)  //若当前area在中点右侧，则将当前area加入到新节点的右子树叶头
-            {
-                tree->addLeafArea(XYTREE_CHILD_RIGHT, area);
-            }
-            else
-            {
-                tree->addLeafArea(XYTREE_CHILD_MIDDLE, area);  //否则，则将当前area加入到新节点的中子树叶头
-            }
+            continue;
         }
-    }
-    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
-    {
-        assert(tree->mIsAreaArray[i] && tree->mChild[i]);
-        XYTreeLeaf* oldLeaf = (XYTreeLeaf*)tree->mChild[i];
-
-        void* pAddr = rebalance(oldLeaf, tree->mIsAreaArray[i]);
         if (tree->mIsAreaArray[i])
         {
-            assert(pAddr == oldLeaf && tree->mChild[i] == pAddr);
+            ((XYTreeLeaf*)tree->mChild[i])->setParent(tree);
         }
         else
         {
-            assert(pAddr != oldLeaf && tree->mChild[i] == pAddr);
-            oldLeaf->removeAreaArray(false);
-            delete oldLeaf;
-
-            tree->mChild[i] = pAddr;
+            ((XYTreeNode*)tree->mChild[i])->mParent = tree;
         }
+        tree->mTypeMask |= tree->getChildTypeMask((XYTreeChildType)i);
     }
-    bOriginArray = false;
     return tree;
 }
-void XYTreeNode::TreeAreaToArray(std::vector<ComponentArea*>& dstAreaArray) const
+void* XYTreeNode::buildSubTree(XYTreeMemPool* aMemPool, ComponentArea** aAreaArray, int aAreaNum, bool& bAreaArray,
+                               XYTreeThreadPool* aThreadPool /*= nullptr*/,
+                               int aParallelCutoff /*= XY_PARALLEL_CUTOFF*/)
+{
+    assert(aMemPool && aAreaNum > 0);
+    BoundRect2D bound;
+    XYTreeSplitDirection splitDir = XYTREE_SPLIT_X;
+    double splitPos = 0.0;
+    if (!chooseSplit(aAreaArray, aAreaNum, bound, splitDir, splitPos))  //无需继续分割，直接生成树叶
+    {
+        XYTreeLeaf* leaf = aMemPool->create<XYTreeLeaf>(nullptr, aMemPool);
+        leaf->setAreaArray(aAreaArray, aAreaNum, bound);
+        bAreaArray = true;
+        return leaf;
+    }
+    bAreaArray = false;
+    return splitAreaArray(aMemPool, aAreaArray, aAreaNum, bound, splitDir, splitPos, aThreadPool, aParallelCutoff);
+}
+void* XYTreeNode::rebalance(XYTreeMemPool* aMemPool, const XYTreeLeaf* aLeaf, bool& bOriginArray)
+{
+    bOriginArray = true;
+    if (nullptr == aLeaf)
+    {
+        return (void*)aLeaf;
+    }
+    const XYTreeAreaArray* areaArray = &aLeaf->getAreaArray();
+    int areaNum = areaArray->size();
+    BoundRect2D bound;
+    XYTreeSplitDirection splitDir = XYTREE_SPLIT_X;
+    double splitPos = 0.0;
+    if (!chooseSplit(areaArray->data(), areaNum, bound, splitDir, splitPos))
+    {
+        return (void*)aLeaf;  //返回原树叶，无需继续平衡化
+    }
+
+    // 划分会重排area顺序，在副本上进行，原树叶由调用者释放
+    std::vector<ComponentArea*> areaCopy(areaArray->begin(), areaArray->end());
+    bOriginArray = false;
+    return splitAreaArray(aMemPool, areaCopy.data(), areaNum, bound, splitDir, splitPos, nullptr, XY_PARALLEL_CUTOFF);
+}
+void XYTreeNode::TreeAreaToArray(XYTreeAreaArray& dstAreaArray) const
 {
     for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
     {
@@ -424,23 +390,49 @@ void XYTreeNode::TreeAreaToArray(std::vector<ComponentArea*>& dstAreaArray) cons
         }
     }
 }
+int XYTreeNode::getAreaNum() const
+{
+    int nAreaNum = 0;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        if (nullptr == mChild[i])
+            continue;
+        nAreaNum += mIsAreaArray[i] ? (int)((const XYTreeLeaf*)mChild[i])->getAreaArray().size()
+                                    : ((const XYTreeNode*)mChild[i])->getAreaNum();
+    }
+    return nAreaNum;
+}
+int XYTreeNode::getHeight() const
+{
+    int nHeight = 0;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        if (mChild[i] && !mIsAreaArray[i])
+            nHeight = std::max(nHeight, ((const XYTreeNode*)mChild[i])->getHeight());
+    }
+    return nHeight + 1;
+}
+XYTreeTypeMask XYTreeNode::getChildTypeMask(XYTreeChildType aChildType) const
+{
+    if (nullptr == mChild[aChildType])
+        return 0;
+    return mIsAreaArray[aChildType] ? ((const XYTreeLeaf*)mChild[aChildType])->getTypeMask()
+                                    : ((const XYTreeNode*)mChild[aChildType])->getTypeMask();
+}
 bool XYTreeNode::adjustBoundBox()
 {
     BoundRect2D resultRect;
+    XYTreeTypeMask typeMask = 0;
     for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
     {
+        typeMask |= getChildTypeMask((XYTreeChildType)i);
         if (mChild[i])
         {
-            if (mIsAreaArray[i])  //若当前子树是树叶area列表
-            {
-                XYTreeLeaf* leaf = (XYTreeLeaf*)mChild[i];
-                resultRect.expandBound(leaf->getBoundRect() /*leaf->adjustBoundBox()*/);
-            }
-            else  //中间层节点
+            const BoundRect2D* childRect = mIsAreaArray[i] ? ((XYTreeLeaf*)mChild[i])->getBoundRect()
+                                                           : ((XYTreeNode*)mChild[i])->getBoundRect();
+            if (childRect->isValid())  //删除area后子树可能为空
             {
-                XYTreeNode* node = (XYTreeNode*)mChild[i];
-                //node->adjustBoundBox(); //递归调整包围盒
-                resultRect.expandBound(node->getBoundRect());
+                resultRect.expandBound(childRect);
             }
         }
         else
@@ -449,14 +441,39 @@ bool XYTreeNode::adjustBoundBox()
         }
     }
 
-    bool bEqual = mBBox->isEqual(&resultRect);
-    if (bEqual)
+    bool bEqual = resultRect.isValid() ? mBBox.isEqual(&resultRect) : !mBBox.isValid();
+    if (!bEqual)
+    {
+        mBBox = resultRect;
+    }
+    if (typeMask != mTypeMask)
     {
-        mBBox->setBound(&resultRect);
+        mTypeMask = typeMask;
+        bEqual = false;
     }
     return !bEqual;
 }
-XYTreeNode* XYTreeNode::expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTreeChildType& childType)
+void XYTreeNode::adjustBoundToRoot()
+{
+    XYTreeNode* node = this;
+    while (node && node->adjustBoundBox())
+    {
+        node = node->mParent;
+    }
+}
+XYTreeChildType XYTreeNode::getChildIndex(const void* aChild) const
+{
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        if (aChild == mChild[i])
+        {
+            return (XYTreeChildType)i;
+        }
+    }
+    return XYTREE_CHILD_INVALID;
+}
+XYTreeNode* XYTreeNode::expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTreeTypeMask aTypeMask,
+                                          XYTreeChildType& childType)
 {
     assert(nullptr == mParent);    //当前节点为根节点
     XYTreeNode* curNode = this;   // rootNode;
@@ -465,6 +482,7 @@ XYTreeNode* XYTreeNode::expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTre
     {
         BoundRect2D* treeNodeBound = curNode->getBoundRect();
         treeNodeBound->expandBound(srcBoundRect);
+        curNode->mTypeMask |= aTypeMask;
         childType = curNode->getChildType(srcBoundRect);
         assert(childType < XYTREE_CHILD_NUM);
         if (curNode->isChildAreaArray(childType))
@@ -472,7 +490,7 @@ XYTreeNode* XYTreeNode::expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTre
             XYTreeLeaf* leaf = (XYTreeLeaf*)curNode->mChild[childType];
             if (leaf)
             {
-                leaf->expandBoundToLeaf(srcBoundRect);
+                leaf->expandBoundToLeaf(srcBoundRect, aTypeMask);
             }
             break;
         }
@@ -488,6 +506,10 @@ XYTreeLeaf* XYTreeNode::getLeafWithBound(const BoundRect2D* srcBoundRect, XYTree
     childType = XYTREE_CHILD_NUM;       //子节点类型
     do
     {
+        if (!curNode->mBBox.isValid())  //删除area后子树可能为空，空子树中没有任何area
+        {
+            return nullptr;
+        }
         childType = curNode->getChildType(srcBoundRect);
         assert(childType < XYTREE_CHILD_NUM);
         if (curNode->isChildAreaArray(childType))
@@ -499,43 +521,83 @@ XYTreeLeaf* XYTreeNode::getLeafWithBound(const BoundRect2D* srcBoundRect, XYTree
     } while (true);
     return curNode ? (XYTreeLeaf*)(curNode->mChild[childType]) : nullptr;
 }
-XYTreeChildType XYTreeNode::getChildType(const BoundRect2D* aSrcBound) const
+const BoundRect2D* XYTreeNode::addLeafArea(XYTreeMemPool* aMemPool, XYTreeChildType aChildType, ComponentArea* area)
 {
-    assert(aSrcBound && aSrcBound->isValid());
-    assert(mBBox && mBBox->isValid());
-    switch (mSplitDir)
+    assert(aMemPool && mIsAreaArray[aChildType]);
+    if (nullptr == mChild[aChildType])
     {
-        case XYTREE_SPLIT_X:  //X轴向分割
-            if (aSrcBound->getMaxX() < mSplitPos)
-                return XYTREE_CHILD_LEFT;
-            else if (aSrcBound->getMinX() > mSplitPos)
-                return XYTREE_CHILD_RIGHT;
-            else
-                return XYTREE_CHILD_MIDDLE;
-            break;
-        case XYTREE_SPLIT_Y:  //Y轴向分割
-            if (aSrcBound->getMaxY() < mSplitPos)
-                return XYTREE_CHILD_LEFT;
-            else if (aSrcBound->getMinY() > mSplitPos)
-                return XYTREE_CHILD_RIGHT;
-            else
-                return XYTREE_CHILD_MIDDLE;
-            break;
-        default:
-            assert(false);
+        mChild[aChildType] = aMemPool->create<XYTreeLeaf>(this, aMemPool);
     }
-    return XYTREE_CHILD_INVALID;
+    XYTreeLeaf* leaf = (XYTreeLeaf*)mChild[aChildType];
+    mBBox.expandBound(leaf->addArea(area));
+    mTypeMask |= leaf->getTypeMask();
+    return &mBBox;
 }
-const BoundRect2D* XYTreeNode::addLeafArea(XYTreeChildType aChildType, ComponentArea* area)
+void XYTreeNode::attachLeaf(XYTreeChildType aChildType, XYTreeLeaf* aLeaf)
 {
-    assert(mIsAreaArray[aChildType]);
-    if (nullptr == mChild[aChildType])
+    assert(aLeaf && mIsAreaArray[aChildType] && nullptr == mChild[aChildType]);
+    aLeaf->setParent(this);
+    mChild[aChildType] = aLeaf;
+    if (aLeaf->getBoundRect()->isValid())  //批量插入时先挂接空树叶
+    {
+        mBBox.expandBound(aLeaf->getBoundRect());
+    }
+    mTypeMask |= aLeaf->getTypeMask();
+}
+bool XYTreeNode::splitLeaf(XYTreeMemPool* aMemPool, XYTreeChildType aChildType)
+{
+    assert(aMemPool && mIsAreaArray[aChildType]);
+    XYTreeLeaf* leaf = (XYTreeLeaf*)mChild[aChildType];
+    if (nullptr == leaf)
     {
-        mChild[aChildType] = new XYTreeLeaf(this);
+        return false;
+    }
+
+    bool bOriginArray = true;
+    void* pAddr = rebalance(aMemPool, leaf, bOriginArray);
+    if (bOriginArray)
+    {
+        return false;
+    }
+
+    // 新子树的包围盒和类型掩码与原树叶相同，祖先节点无需调整
+    XYTreeNode* node = (XYTreeNode*)pAddr;
+    node->mParent = this;
+    mChild[aChildType] = node;
+    mIsAreaArray[aChildType] = false;
+    leaf->removeAreaArray(false);
+    aMemPool->destroy(leaf);
+    return true;
+}
+void XYTreeNode::rebuildChild(XYTreeMemPool* aMemPool, XYTreeChildType aChildType, XYTreeThreadPool* aThreadPool,
+                              int aParallelCutoff)
+{
+    assert(aMemPool && !mIsAreaArray[aChildType] && mChild[aChildType]);
+    XYTreeNode* node = (XYTreeNode*)mChild[aChildType];
+    XYTreeAreaArray areaArray{XYTreeAllocator<ComponentArea*>(aMemPool)};
+    node->TreeAreaToArray(areaArray);
+    freeNodesWithoutArea(aMemPool, &node, true);
+
+    mChild[aChildType] = nullptr;
+    mIsAreaArray[aChildType] = true;
+    if (!areaArray.empty())  //删除area后子树可能为空
+    {
+        mChild[aChildType] = buildSubTree(aMemPool, areaArray.data(), (int)areaArray.size(),
+                                          mIsAreaArray[aChildType], aThreadPool, aParallelCutoff);
+        if (mIsAreaArray[aChildType])
+            ((XYTreeLeaf*)mChild[aChildType])->setParent(this);
+        else
+            ((XYTreeNode*)mChild[aChildType])->mParent = this;
     }
+    adjustBoundToRoot();
+}
+void XYTreeNode::removeEmptyLeaf(XYTreeMemPool* aMemPool, XYTreeChildType aChildType)
+{
+    assert(aMemPool && mIsAreaArray[aChildType]);
     XYTreeLeaf* leaf = (XYTreeLeaf*)mChild[aChildType];
-    mBBox->expandBound(leaf->addArea(area));
-    return mBBox;
+    assert(leaf && leaf->getAreaArray().empty());
+    mChild[aChildType] = nullptr;
+    aMemPool->destroy(leaf);
 }
 bool XYTreeNode::deleteArea(const ComponentArea* srcArea)
 {
@@ -548,14 +610,11 @@ bool XYTreeNode::deleteArea(const ComponentArea* srcArea)
     }
     curLeaf->deleteArea(srcArea);
     XYTreeNode* node = curLeaf->getParent();
-    while (node)
+    if (curLeaf->getAreaArray().empty())
     {
-        if (!node->adjustBoundBox())
-        {
-            return true;
-        }
-        node = node->mParent;
+        node->removeEmptyLeaf(curLeaf->getMemPool(), childType);
     }
+    node->adjustBoundToRoot();
     return true;
 }
 bool XYTreeNode::isFindArea(const ComponentArea* srcArea) const
@@ -568,7 +627,7 @@ bool XYTreeNode::isFindArea(const ComponentArea* srcArea) const
         return false;
     }
 
-    const std::vector<ComponentArea*>* areaArray = &curLeaf->getAreaArray();
+    const XYTreeAreaArray* areaArray = &curLeaf->getAreaArray();
     assert(areaArray->size() > 0);
     for (int i = 0, nCount = areaArray->size(); i < nCount; ++i)  //遍历树叶中的area器件列表
     {
@@ -583,25 +642,154 @@ bool XYTreeNode::isFindArea(const ComponentArea* srcArea) const
 }
 void XYTreeNode::search(const BoundRect2D& srcRect, std::vector<ComponentArea*>& resultArray) const
 {
-    assert(mBBox);
-    if (mBBox->isDisjoint(&srcRect))
+    search(srcRect, XYTreeAppendVisitor(resultArray));
+}
+void XYTreeNode::searchBatch(const BoundRect2D* aRectArray, const int* aQueryArray, int aQueryNum, int nDepth,
+                             std::vector<std::vector<int>>& levelArray, std::vector<XYTreeBatchHit>& hitArray) const
+{
+    // 每层复用一个工作数组(同层兄弟节点依次使用，容量只增长到该层的最大值)：
+    // 先存放与当前节点包围盒相交的查询(中子树候选)，随后是左子树候选和右子树候选
+    if ((int)levelArray.size() <= nDepth)
+    {
+        levelArray.resize(nDepth + 1);  //外层数组扩容时移动内层数组，上层工作数组的数据地址不变
+    }
+    std::vector<int>& workArray = levelArray[nDepth];
+    workArray.clear();
+    for (int i = 0; i < aQueryNum; ++i)
+    {
+        int nQuery = aQueryArray[i];
+        if (!mBBox.isDisjoint(&aRectArray[nQuery]))
+            workArray.push_back(nQuery);
+    }
+    int nMidNum = (int)workArray.size();
+    if (0 == nMidNum)
     {
         return;
     }
 
-    XYTreeChildType childType =
-        getChildType(&srcRect);  //根据当前树节点的coord，以及给定的区域范围，判别当前区域属于左中右哪个子节点
-    if (XYTREE_CHILD_LEFT == childType || XYTREE_CHILD_MIDDLE == childType)  //遍历左子树
+    for (int i = 0; i < nMidNum; ++i)
+    {
+        int nQuery = workArray[i];
+        if (XYTREE_CHILD_RIGHT != getChildType(&aRectArray[nQuery]))
+            workArray.push_back(nQuery);
+    }
+    int nRightBegin = (int)workArray.size();
+    for (int i = 0; i < nMidNum; ++i)
+    {
+        int nQuery = workArray[i];
+        if (XYTREE_CHILD_LEFT != getChildType(&aRectArray[nQuery]))
+            workArray.push_back(nQuery);
+    }
+    const int* pWork = workArray.data();  //子节点可能使外层数组扩容，之后只通过数据地址访问
+    const int* childQuery[XYTREE_CHILD_NUM] = {pWork + nMidNum, pWork, pWork + nRightBegin};
+    int nChildNum[XYTREE_CHILD_NUM] = {nRightBegin - nMidNum, nMidNum, (int)workArray.size() - nRightBegin};
+
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)  //与单次查询相同的左中右遍历顺序
+    {
+        if (nullptr == mChild[i] || 0 == nChildNum[i])
+        {
+            continue;
+        }
+        if (mIsAreaArray[i])
+        {
+            const XYTreeLeaf* leaf = (const XYTreeLeaf*)mChild[i];
+            leaf->getJointAreaBatch(aRectArray, childQuery[i], nChildNum[i], hitArray);
+        }
+        else
+        {
+            const XYTreeNode* node = (const XYTreeNode*)mChild[i];
+            node->searchBatch(aRectArray, childQuery[i], nChildNum[i], nDepth + 1, levelArray, hitArray);
+        }
+    }
+}
+void XYTreeNode::searchNearest(const BoundRect2D& srcRect, int aCount, double aMaxDist, XYTreeTypeMask aTypeMask,
+                               std::vector<XYTreeNeighbor>& resultArray) const
+{
+    resultArray.clear();
+    if (aMaxDist < 0.0)
     {
-        searchChild(XYTREE_CHILD_LEFT, srcRect, resultArray);
+        return;
     }
 
-    //遍历中子树（注意：必须总是遍历中子树）
-    searchChild(XYTREE_CHILD_MIDDLE, srcRect, resultArray);
+    // 候选项: 树节点、树叶或area，按到查询矩形的距离平方组成小顶堆
+    enum CandidateType
+    {
+        CANDIDATE_NODE,
+        CANDIDATE_LEAF,
+        CANDIDATE_AREA
+    };
+    struct Candidate
+    {
+        double mSqrDist;
+        CandidateType mType;
+        const void* mPtr;
+        bool operator>(const Candidate& other) const { return mSqrDist > other.mSqrDist; }
+    };
+    const double maxSqrDist = aMaxDist < DBL_MAX ? aMaxDist * aMaxDist : DBL_MAX;
+    std::vector<Candidate> heap;
+    auto pushCandidate = [&](CandidateType type, const void* ptr, const BoundRect2D* bound)
+    {
+        if (!bound->isValid())  //删除area后子树可能为空
+            return;
+        double sqrDist = srcRect.getSqrDistance(bound);
+        if (sqrDist <= maxSqrDist)
+        {
+            heap.push_back(Candidate{sqrDist, type, ptr});
+            std::push_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+        }
+    };
 
-    if (XYTREE_CHILD_MIDDLE == childType || XYTREE_CHILD_RIGHT == childType)  //遍历右子树
+    if (mTypeMask & aTypeMask)
+    {
+        pushCandidate(CANDIDATE_NODE, this, &mBBox);
+    }
+    while (!heap.empty() && (aCount <= 0 || (int)resultArray.size() < aCount))
     {
-        searchChild(XYTREE_CHILD_RIGHT, srcRect, resultArray);
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+        Candidate candidate = heap.back();
+        heap.pop_back();
+
+        switch (candidate.mType)
+        {
+            case CANDIDATE_AREA:  //堆中其余候选的距离均不小于该area，可直接输出
+                resultArray.push_back(XYTreeNeighbor{(ComponentArea*)candidate.mPtr, sqrt(candidate.mSqrDist)});
+                break;
+            case CANDIDATE_LEAF:
+            {
+                const XYTreeLeaf* leaf = (const XYTreeLeaf*)candidate.mPtr;
+                const XYTreeAreaArray& areaArray = leaf->getAreaArray();
+                const XYTreeRectArray& rectArray = leaf->getRectArray();
+                for (int i = 0, nCount = rectArray.size(); i < nCount; ++i)
+                {
+                    if (XYTREE_TYPE_MASK_ALL != aTypeMask && !(aTypeMask & xyTreeTypeBit(areaArray[i]->getTypeId())))
+                        continue;
+                    BoundRect2D rect(rectArray.getMinX()[i], rectArray.getMinY()[i], rectArray.getMaxX()[i],
+                                     rectArray.getMaxY()[i]);
+                    pushCandidate(CANDIDATE_AREA, areaArray[i], &rect);
+                }
+                break;
+            }
+            case CANDIDATE_NODE:
+            {
+                const XYTreeNode* node = (const XYTreeNode*)candidate.mPtr;
+                for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+                {
+                    if (0 == (node->getChildTypeMask((XYTreeChildType)i) & aTypeMask))  //含空子树
+                        continue;
+                    if (node->mIsAreaArray[i])
+                    {
+                        const XYTreeLeaf* leaf = (const XYTreeLeaf*)node->mChild[i];
+                        pushCandidate(CANDIDATE_LEAF, leaf, leaf->getBoundRect());
+                    }
+                    else
+                    {
+                        const XYTreeNode* child = (const XYTreeNode*)node->mChild[i];
+                        pushCandidate(CANDIDATE_NODE, child, child->getBoundRect());
+                    }
+                }
+                break;
+            }
+        }
     }
 }
 void XYTreeNode::print(const char* pSpan, int nLevel)
@@ -614,29 +802,31 @@ void XYTreeNode::print(const char* pSpan, int nLevel)
     printChild(pSpan, "Right", XYTREE_CHILD_RIGHT, nLevel);
 }
 
-XYTreeLeaf::XYTreeLeaf(XYTreeNode* aParent) : mBoundRect(new BoundRect2D()), mParent(aParent), mAreaArray()
+XYTreeLeaf::XYTreeLeaf(XYTreeNode* aParent, XYTreeMemPool* aMemPool /*= nullptr*/)
+    : mBoundRect(),
+      mParent(aParent),
+      mAreaArray(XYTreeAllocator<ComponentArea*>(aMemPool)),
+      mRectArray(aMemPool),
+      mTypeMask(0),
+      mSplitLimit(0)
 {
-    assert(mBoundRect);
 }
 XYTreeLeaf::~XYTreeLeaf()
 {
-    if (mBoundRect)
-    {
-        delete mBoundRect;
-        mBoundRect = nullptr;
-    }
     removeAreaArray(true);
 }
 const BoundRect2D* XYTreeLeaf::addArea(ComponentArea* area)
 {
     assert(mParent);
-    mAreaArray.insert(mAreaArray.begin(), area);
-    mBoundRect->expandBound(area->getBoundRect());
-    return mBoundRect;
+    mAreaArray.push_back(area);
+    mRectArray.push(*area->getBoundRect());
+    mBoundRect.expandBound(area->getBoundRect());
+    mTypeMask |= xyTreeTypeBit(area->getTypeId());
+    return &mBoundRect;
 }
 void XYTreeLeaf::deleteArea(const ComponentArea* srcArea)
 {
-    std::vector<ComponentArea*>* areaArray = &mAreaArray;
+    XYTreeAreaArray* areaArray = &mAreaArray;
     assert(areaArray->size() > 0);
     for (int i = 0, nCount = areaArray->size(); i < nCount; ++i)
     {
@@ -644,39 +834,143 @@ void XYTreeLeaf::deleteArea(const ComponentArea* srcArea)
         assert(area);
         if (area->isEqual(srcArea))
         {
-            delete area;  // 删除当前area
+            if (getMemPool())  // 删除当前area
+                getMemPool()->destroy(area);
+            else
+                delete area;
             areaArray->erase(areaArray->begin() + i);
+            mRectArray.erase(i);
             adjustBoundBox();
             break;
         }
     }
 }
+void XYTreeLeaf::setAreaArray(ComponentArea* const* aAreaArray, int aAreaNum, const BoundRect2D& aBound)
+{
+    mAreaArray.assign(aAreaArray, aAreaArray + aAreaNum);
+    mRectArray.assign(aAreaArray, aAreaNum);
+    mBoundRect = aBound;
+    calcTypeMask();
+}
+void XYTreeLeaf::calcTypeMask()
+{
+    mTypeMask = 0;
+    for (const ComponentArea* area : mAreaArray)
+    {
+        mTypeMask |= xyTreeTypeBit(area->getTypeId());
+    }
+}
+bool XYTreeLeaf::removeArea(int aSlot)
+{
+    assert(aSlot >= 0 && aSlot < (int)mAreaArray.size());
+    ComponentArea* area = mAreaArray[aSlot];
+    mAreaArray[aSlot] = mAreaArray.back();
+    mAreaArray.pop_back();
+    mRectArray.eraseSwap(aSlot);
+
+    XYTreeTypeMask oldTypeMask = mTypeMask;
+    calcTypeMask();
+
+    // 只有位于树叶包围盒边界上的area被移除时，包围盒才可能缩小
+    const BoundRect2D* areaRect = area->getBoundRect();
+    if (areaRect->getMinX() > mBoundRect.getMinX() && areaRect->getMinY() > mBoundRect.getMinY() &&
+        areaRect->getMaxX() < mBoundRect.getMaxX() && areaRect->getMaxY() < mBoundRect.getMaxY())
+    {
+        return mTypeMask != oldTypeMask;
+    }
+    BoundRect2D oldRect = mBoundRect;
+    adjustBoundBox();
+    return !mBoundRect.isValid() || !mBoundRect.isEqual(&oldRect) || mTypeMask != oldTypeMask;
+}
+bool XYTreeLeaf::removeAreaBatch(const int* aSlotArray, int aSlotNum)
+{
+    bool bOnBound = false;  //是否有area位于树叶包围盒边界上
+    for (int i = 0; i < aSlotNum; ++i)
+    {
+        int nSlot = aSlotArray[i];
+        assert(nSlot >= 0 && nSlot < (int)mAreaArray.size() && (i == 0 || nSlot < aSlotArray[i - 1]));
+        const BoundRect2D* areaRect = mAreaArray[nSlot]->getBoundRect();
+        if (!(areaRect->getMinX() > mBoundRect.getMinX() && areaRect->getMinY() > mBoundRect.getMinY() &&
+              areaRect->getMaxX() < mBoundRect.getMaxX() && areaRect->getMaxY() < mBoundRect.getMaxY()))
+        {
+            bOnBound = true;
+        }
+        mAreaArray[nSlot] = mAreaArray.back();
+        mAreaArray.pop_back();
+        mRectArray.eraseSwap(nSlot);
+    }
+
+    XYTreeTypeMask oldTypeMask = mTypeMask;
+    calcTypeMask();
+    if (!bOnBound)
+    {
+        return mTypeMask != oldTypeMask;
+    }
+    BoundRect2D oldRect = mBoundRect;
+    adjustBoundBox();
+    return !mBoundRect.isValid() || !mBoundRect.isEqual(&oldRect) || mTypeMask != oldTypeMask;
+}
+bool XYTreeLeaf::updateArea(int aSlot, const BoundRect2D& aNewRect)
+{
+    assert(aSlot >= 0 && aSlot < (int)mAreaArray.size());
+    mRectArray.set(aSlot, aNewRect);
+    mAreaArray[aSlot]->getBoundRect()->setBound(&aNewRect);
+
+    BoundRect2D oldRect = mBoundRect;
+    adjustBoundBox();
+    return !mBoundRect.isEqual(&oldRect);
+}
+bool XYTreeLeaf::isRouteTo(const BoundRect2D& aSrcBound) const
+{
+    const void* child = this;
+    for (const XYTreeNode* node = mParent; node; node = node->getParent())
+    {
+        if (node->getChildType(&aSrcBound) != node->getChildIndex(child))
+        {
+            return false;
+        }
+        child = node;
+    }
+    return true;
+}
 BoundRect2D* XYTreeLeaf::adjustBoundBox()
 {
+    calcTypeMask();
+    if (mAreaArray.empty())
+    {
+        mBoundRect = BoundRect2D();
+        return &mBoundRect;
+    }
     BoundRect2D resultRect = ComponentArea::calcAreaArrayBound(mAreaArray);
-    mBoundRect->setBound(&resultRect);
-    return mBoundRect;
+    mBoundRect.setBound(&resultRect);
+    return &mBoundRect;
 }
-void XYTreeLeaf::expandBoundToLeaf(const BoundRect2D* srcBoundRect)
+void XYTreeLeaf::expandBoundToLeaf(const BoundRect2D* srcBoundRect, XYTreeTypeMask aTypeMask)
 {
-    mBoundRect->expandBound(srcBoundRect);
+    mBoundRect.expandBound(srcBoundRect);
+    mTypeMask |= aTypeMask;
 }
 void XYTreeLeaf::removeAreaArray(bool bDelete)
 {
     if (bDelete)
     {
+        XYTreeMemPool* memPool = getMemPool();
         for (auto* area : mAreaArray)
         {
-            delete area;
+            if (memPool)
+                memPool->destroy(area);
+            else
+                delete area;
             area = nullptr;
         }
     }
     mAreaArray.clear();
+    mRectArray.clear();
+    mTypeMask = 0;
 }
-void XYTreeLeaf::TreeAreaToArray(std::vector<ComponentArea*>& dstAreaArray, bool bRemove)
+void XYTreeLeaf::TreeAreaToArray(XYTreeAreaArray& dstAreaArray, bool bRemove)
 {
-    const std::vector<ComponentArea*>* areaArray = &mAreaArray;
-    assert(areaArray->size() > 0);
+    const XYTreeAreaArray* areaArray = &mAreaArray;
     for (auto* area : *areaArray)
     {
         assert(area);
@@ -685,93 +979,496 @@ void XYTreeLeaf::TreeAreaToArray(std::vector<ComponentArea*>& dstAreaArray, bool
     if (bRemove)
     {
         mAreaArray.clear();
+        mRectArray.clear();
+        mTypeMask = 0;
     }
 }
 void XYTreeLeaf::getJointArea(const BoundRect2D& srcRect, std::vector<ComponentArea*>& resultArray) const
 {
-    assert(mAreaArray.size() > 0);
-    if (srcRect.isDisjoint(mBoundRect))  // 若包围盒不相交
+    visitJointArea(srcRect, XYTreeAppendVisitor(resultArray));
+}
+void XYTreeLeaf::getJointAreaBatch(const BoundRect2D* aRectArray, const int* aQueryArray, int aQueryNum,
+                                   std::vector<XYTreeBatchHit>& hitArray) const
+{
+    // 外层按块遍历area、内层遍历查询，保证每个查询的命中顺序与单次查询一致
+    for (int nBlock = 0, nBlockNum = mRectArray.getBlockNum(); nBlock < nBlockNum; ++nBlock)
     {
-        return;
-    }
-
-    for (ComponentArea* area : mAreaArray)
-    {
-        assert(area);
-        if (!srcRect.isDisjoint(area->getBoundRect()))  // 若包围盒相交
+        int nBegin = nBlock * XY_SIMD_BLOCK;
+        for (int i = 0; i < aQueryNum; ++i)
         {
-            resultArray.push_back(area);
+            unsigned int nMask = xyTreeOverlapMask(mRectArray, nBegin, aRectArray[aQueryArray[i]]);
+            while (nMask)
+            {
+                hitArray.emplace_back(aQueryArray[i], mAreaArray[nBegin + xyTreeLowestBit(nMask)]);
+                nMask &= nMask - 1;
+            }
         }
     }
 }
 void XYTreeLeaf::print(const char* pszPrefix) const
 {
-    const std::vector<ComponentArea*>* areaArray = &mAreaArray;
+    const XYTreeAreaArray* areaArray = &mAreaArray;
     assert(areaArray->size() > 0);
     ComponentArea::print(*areaArray, pszPrefix);
 }
 
-RXYTree::RXYTree() : mRootNode(nullptr) {}
-RXYTree::~RXYTree() {}
+RXYTree::RXYTree()
+    : mRootNode(nullptr),
+      mMemPool(new XYTreeMemPool()),
+      mAreaPool(new XYTreeMemPool()),
+      mThreadPool(nullptr),
+      mParallelCutoff(XY_PARALLEL_CUTOFF),
+      mLeafSplitFactor(XY_LEAF_SPLIT_FACTOR),
+      mRebuildDepthFactor(XY_REBUILD_DEPTH_FACTOR),
+      mIsFrozen(false),
+      mIsInBatch(false)
+{
+}
+RXYTree::RXYTree(const BoundRect2D* aRectArray, void* const* aAddrArray, int aCount,
+                 const int* aTypeIdArray /*= nullptr*/)
+    : RXYTree()
+{
+    bulkLoad(aRectArray, aAddrArray, aCount, aTypeIdArray);
+}
+RXYTree::~RXYTree()
+{
+    mRootNode = nullptr;
+    delete mMemPool;
+    mMemPool = nullptr;
+    delete mAreaPool;
+    mAreaPool = nullptr;
+    delete mThreadPool;
+    mThreadPool = nullptr;
+}
+void RXYTree::setThreadNum(int aThreadNum)
+{
+    if (aThreadNum == getThreadNum())
+        return;
+    delete mThreadPool;
+    mThreadPool = nullptr;
+    if (aThreadNum != 1)
+    {
+        mThreadPool = new XYTreeThreadPool(aThreadNum);
+    }
+}
+int RXYTree::getThreadNum() const
+{
+    return mThreadPool ? mThreadPool->getThreadNum() : 1;
+}
+void RXYTree::setParallelCutoff(int aParallelCutoff)
+{
+    assert(aParallelCutoff > 0);
+    mParallelCutoff = aParallelCutoff;
+}
+bool RXYTree::clear()
+{
+    if (mIsFrozen || mIsInBatch)  //批量修改中清空会丢弃已登记的修改，且已分配的句柄失效
+        return false;
+    // 节点、树叶、area及树叶数组均分配在内存池中，整体归还即可，无需递归析构
+    mRootNode = nullptr;
+    mMemPool->release();
+    mAreaPool->release();
+    mAreaDirectory.clear();
+    mFreeHandleArray.clear();
+    return true;
+}
 void RXYTree::createTree(double aSplitPos, XYTreeSplitDirection aSplitDir /*= XYTREE_SPLIT_X*/)
 {
-    if (nullptr == mRootNode)
+    if (nullptr == mRootNode && !mIsFrozen)
     {
-        mRootNode = XYTreeNode::createTreeNode(aSplitPos, aSplitDir);
+        mRootNode = XYTreeNode::createTreeNode(mMemPool, aSplitPos, aSplitDir);
     }
     assert(mRootNode);
 }
-bool RXYTree::addComponentArea(double aMinX, double aMinY, double aMaxX, double aMaxY, int aTypeId, void* aAddr)
+XYTreeHandle RXYTree::addComponentArea(double aMinX, double aMinY, double aMaxX, double aMaxY, int aTypeId,
+                                       void* aAddr)
 {
     assert(mRootNode);
-    if (nullptr == mRootNode)
+    if (nullptr == mRootNode || mIsFrozen)
+    {
+        return XYTREE_INVALID_HANDLE;
+    }
+    ComponentArea* area = ComponentArea::createComponentArea(mAreaPool, aMinX, aMinY, aMaxX, aMaxY, aTypeId, aAddr);
+    XYTreeHandle handle = allocHandle(area);
+    if (mIsInBatch)  //批量修改: 只登记，提交时插入
+    {
+        mAreaDirectory[handle].mSlot = (int)mBatchAddArray.size();
+        mBatchAddArray.push_back(area);
+        return handle;
+    }
+    addAreaToTree(area);
+    return handle;
+}
+bool RXYTree::deleteComponentArea(XYTreeHandle aHandle)
+{
+    if (!isIndexed(aHandle) || mIsFrozen)
     {
         return false;
     }
-    ComponentArea* area = ComponentArea::createComponentArea(aMinX, aMinY, aMaxX, aMaxY, aTypeId, aAddr);
+    AreaEntry& entry = mAreaDirectory[aHandle];
+    ComponentArea* area = entry.mArea;
+    if (mIsInBatch)
+    {
+        if (entry.mLeaf)  //树中的area: 只登记，提交时移除并释放
+        {
+            entry.mIsDeleted = true;
+            mBatchDeleteArray.push_back(aHandle);
+            return true;
+        }
+        mBatchAddArray[entry.mSlot] = nullptr;  //尚未插入的area: 直接释放
+    }
+    else
+    {
+        removeAreaFromTree(aHandle);
+    }
+    mAreaDirectory[aHandle] = AreaEntry{nullptr, nullptr, -1, false};
+    mFreeHandleArray.push_back(aHandle);
+    mAreaPool->destroy(area);
+    return true;
+}
+bool RXYTree::updateComponentArea(XYTreeHandle aHandle, double aMinX, double aMinY, double aMaxX, double aMaxY)
+{
+    if (!isIndexed(aHandle) || mIsFrozen)
+    {
+        return false;
+    }
+    BoundRect2D newRect(aMinX, aMinY, aMaxX, aMaxY);
+    const AreaEntry& entry = mAreaDirectory[aHandle];
+    if (nullptr == entry.mLeaf)  //批量修改中尚未插入的area
+    {
+        entry.mArea->getBoundRect()->setBound(&newRect);
+        return true;
+    }
+    if (entry.mLeaf->isRouteTo(newRect))  //仍落在原树叶: 原地更新，树叶包围盒变化时才调整祖先
+    {
+        if (entry.mLeaf->updateArea(entry.mSlot, newRect))
+        {
+            entry.mLeaf->getParent()->adjustBoundToRoot();
+        }
+        return true;
+    }
+
+    ComponentArea* area = entry.mArea;
+    removeAreaFromTree(aHandle);
+    area->getBoundRect()->setBound(&newRect);
     return addAreaToTree(area);
 }
+void RXYTree::removeAreaFromTree(XYTreeHandle aHandle)
+{
+    AreaEntry& entry = mAreaDirectory[aHandle];
+    XYTreeLeaf* leaf = entry.mLeaf;
+    assert(leaf && leaf->getParent() && leaf->getAreaArray()[entry.mSlot] == entry.mArea);
+    XYTreeNode* node = leaf->getParent();
+    bool bChanged = leaf->removeArea(entry.mSlot);
+    if (entry.mSlot < (int)leaf->getAreaArray().size())  //原最后一个area移入了空出的槽位
+    {
+        mAreaDirectory[leaf->getAreaArray()[entry.mSlot]->mHandle].mSlot = entry.mSlot;
+    }
+    entry.mLeaf = nullptr;
+    entry.mSlot = -1;
+
+    if (leaf->getAreaArray().empty())
+    {
+        node->removeEmptyLeaf(mMemPool, node->getChildIndex(leaf));
+    }
+    if (bChanged)
+    {
+        node->adjustBoundToRoot();
+    }
+}
+XYTreeHandle RXYTree::allocHandle(ComponentArea* area)
+{
+    XYTreeHandle handle = XYTREE_INVALID_HANDLE;
+    if (!mFreeHandleArray.empty())
+    {
+        handle = mFreeHandleArray.back();
+        mFreeHandleArray.pop_back();
+    }
+    else
+    {
+        handle = (XYTreeHandle)mAreaDirectory.size();
+        mAreaDirectory.emplace_back();
+    }
+    mAreaDirectory[handle] = AreaEntry{area, nullptr, -1, false};
+    area->mHandle = handle;
+    return handle;
+}
+void RXYTree::updateDirectory(XYTreeLeaf* aLeaf)
+{
+    const XYTreeAreaArray& areaArray = aLeaf->getAreaArray();
+    for (int i = 0, nCount = (int)areaArray.size(); i < nCount; ++i)
+    {
+        AreaEntry& entry = mAreaDirectory[areaArray[i]->mHandle];
+        assert(entry.mArea == areaArray[i]);
+        entry.mLeaf = aLeaf;
+        entry.mSlot = i;
+    }
+}
+void RXYTree::updateDirectory(XYTreeNode* aNode)
+{
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        XYTreeChildType childType = (XYTreeChildType)i;
+        if (aNode->isChildAreaArray(childType))
+        {
+            if (XYTreeLeaf* leaf = aNode->getChildLeaf(childType))
+                updateDirectory(leaf);
+        }
+        else
+        {
+            updateDirectory(aNode->getChildNode(childType));
+        }
+    }
+}
 bool RXYTree::rebalance()
 {
-    if (nullptr == mRootNode)
+    if (nullptr == mRootNode || mIsFrozen)
         return false;
     assert(nullptr == mRootNode->getParent());
 
-    XYTreeLeaf leaf(nullptr);
-    std::vector<ComponentArea*>& areaArray = leaf.getAreaArray();
+    // 树节点和树叶构建在新的内存池中，旧内存池连同上次并行构建接管的子内存池整体释放；area在独立的内存池中，地址不变
+    XYTreeMemPool* memPool = new XYTreeMemPool();
+    XYTreeAreaArray areaArray{XYTreeAllocator<ComponentArea*>(memPool)};
     mRootNode->TreeAreaToArray(areaArray);
-    printf("area num: %d \n", (int)areaArray.size());
 
-#if 0
-    RXYTreeNode::freeNodesWithoutArea(&mRootNode, true);
-#else
-    delete mRootNode;
     mRootNode = nullptr;
-#endif
+    delete mMemPool;
+    mMemPool = memPool;
 
-    // RComponentArea::print(areaArray, ("Array" + std::string("  child").c_str()));
+    return buildRootNode(areaArray.data(), (int)areaArray.size());
+}
+bool RXYTree::bulkLoad(const BoundRect2D* aRectArray, void* const* aAddrArray, int aCount,
+                       const int* aTypeIdArray /*= nullptr*/)
+{
+    assert(aCount >= 0 && (aCount == 0 || aRectArray));
+    if (!clear())
+        return false;
 
+    XYTreeAreaArray areaArray{XYTreeAllocator<ComponentArea*>(mMemPool)};
+    areaArray.reserve(aCount);
+    for (int i = 0; i < aCount; ++i)
+    {
+        const BoundRect2D& rect = aRectArray[i];
+        areaArray.push_back(ComponentArea::createComponentArea(mAreaPool, rect.getMinX(), rect.getMinY(),
+                                                               rect.getMaxX(), rect.getMaxY(),
+                                                               aTypeIdArray ? aTypeIdArray[i] : -1,
+                                                               aAddrArray ? aAddrArray[i] : nullptr));
+        allocHandle(areaArray.back());  //清空后句柄从0开始连续分配
+    }
+    return buildRootNode(areaArray.data(), aCount);
+}
+bool RXYTree::buildRootNode(ComponentArea** aAreaArray, int aAreaNum)
+{
     assert(nullptr == mRootNode);
     bool bArray = true;
-    void* pAddr = XYTreeNode::rebalance(&leaf, bArray);
+    void* pAddr =
+        aAreaNum > 0 ? XYTreeNode::buildSubTree(mMemPool, aAreaArray, aAreaNum, bArray, mThreadPool, mParallelCutoff)
+                     : nullptr;
     if (!bArray)
     {
         mRootNode = (XYTreeNode*)pAddr;
-        // leaf.removeAreaArray(false);
+        updateDirectory(mRootNode);
+        return true;
     }
-    else
+
+    // 创建一个子节点(近邻树叶) : 坐标初值MININT, 默认方向垂直分割，所有area都位于右子树叶
+    createTree(-DBL_MAX, XYTREE_SPLIT_X);
+    if (pAddr)
+    {
+        mRootNode->attachLeaf(XYTREE_CHILD_RIGHT, (XYTreeLeaf*)pAddr);
+        updateDirectory((XYTreeLeaf*)pAddr);
+    }
+    return false;
+}
+bool RXYTree::beginBatch()
+{
+    if (mIsInBatch || mIsFrozen)
+        return false;
+    mIsInBatch = true;
+    return true;
+}
+bool RXYTree::commitBatch()
+{
+    if (!mIsInBatch || mIsFrozen)
+        return false;
+    mIsInBatch = false;
+
+    std::vector<XYTreeNode*> dirtyArray;
+    commitBatchDelete(dirtyArray);
+    commitBatchAdd(dirtyArray);
+    mBatchDeleteArray.clear();
+    mBatchAddArray.clear();
+
+    // 自底向上调整包围盒: 按深度从深到浅处理，每个节点只计算一次，包围盒变化时父节点加入待处理列表
+    std::vector<std::pair<int, XYTreeNode*>> heap;
+    heap.reserve(dirtyArray.size());
+    for (XYTreeNode* node : dirtyArray)
+    {
+        int nDepth = 0;
+        for (const XYTreeNode* parent = node->getParent(); parent; parent = parent->getParent())
+            ++nDepth;
+        heap.emplace_back(nDepth, node);
+    }
+    std::make_heap(heap.begin(), heap.end());
+    XYTreeNode* lastNode = nullptr;
+    while (!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        std::pair<int, XYTreeNode*> item = heap.back();
+        heap.pop_back();
+        if (item.second == lastNode)  //同一节点的重复项在堆中相邻弹出
+            continue;
+        lastNode = item.second;
+        if (item.second->adjustBoundBox() && item.second->getParent())
+        {
+            heap.emplace_back(item.first - 1, item.second->getParent());
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    return true;
+}
+void RXYTree::commitBatchDelete(std::vector<XYTreeNode*>& dirtyArray)
+{
+    // 按(树叶, 槽位降序)分组，每个树叶只移除一次
+    std::vector<std::pair<XYTreeLeaf*, int>> slotArray;
+    slotArray.reserve(mBatchDeleteArray.size());
+    for (XYTreeHandle handle : mBatchDeleteArray)
+    {
+        slotArray.emplace_back(mAreaDirectory[handle].mLeaf, mAreaDirectory[handle].mSlot);
+    }
+    std::sort(slotArray.begin(), slotArray.end(),
+              [](const std::pair<XYTreeLeaf*, int>& a, const std::pair<XYTreeLeaf*, int>& b)
+              {
+                  if (a.first != b.first)
+                      return std::less<XYTreeLeaf*>()(a.first, b.first);
+                  return a.second > b.second;
+              });
+
+    std::vector<int> leafSlotArray;
+    for (size_t nBegin = 0, nEnd = 0; nBegin < slotArray.size(); nBegin = nEnd)
+    {
+        XYTreeLeaf* leaf = slotArray[nBegin].first;
+        leafSlotArray.clear();
+        for (nEnd = nBegin; nEnd < slotArray.size() && slotArray[nEnd].first == leaf; ++nEnd)
+        {
+            leafSlotArray.push_back(slotArray[nEnd].second);
+        }
+        XYTreeNode* node = leaf->getParent();
+        if (leaf->removeAreaBatch(leafSlotArray.data(), (int)leafSlotArray.size()))
+        {
+            dirtyArray.push_back(node);
+        }
+
+        // 只有被移除的槽位中可能移入了其他area
+        const XYTreeAreaArray& areaArray = leaf->getAreaArray();
+        for (int nSlot : leafSlotArray)
+        {
+            if (nSlot < (int)areaArray.size())
+                mAreaDirectory[areaArray[nSlot]->mHandle].mSlot = nSlot;
+        }
+        if (areaArray.empty())
+        {
+            node->removeEmptyLeaf(mMemPool, node->getChildIndex(leaf));
+        }
+    }
+
+    for (XYTreeHandle handle : mBatchDeleteArray)
+    {
+        ComponentArea* area = mAreaDirectory[handle].mArea;
+        mAreaDirectory[handle] = AreaEntry{nullptr, nullptr, -1, false};
+        mFreeHandleArray.push_back(handle);
+        mAreaPool->destroy(area);
+    }
+}
+void RXYTree::commitBatchAdd(std::vector<XYTreeNode*>& dirtyArray)
+{
+    std::vector<ComponentArea*> areaArray;
+    areaArray.reserve(mBatchAddArray.size());
+    for (ComponentArea* area : mBatchAddArray)
+    {
+        if (area)
+            areaArray.push_back(area);
+    }
+    if (areaArray.empty())
+        return;
+    std::vector<ComponentArea*> bufArray(areaArray.size());
+    commitBatchAdd(mRootNode, areaArray.data(), bufArray.data(), (int)areaArray.size(), dirtyArray);
+}
+void RXYTree::commitBatchAdd(XYTreeNode* aNode, ComponentArea** aAreaArray, ComponentArea** aBufArray, int aAreaNum,
+                             std::vector<XYTreeNode*>& dirtyArray)
+{
+    // 按分割位置稳定地划分为左中右三组，保持同一树叶中的插入顺序；各组存放在缓冲区中
+    int countArray[XYTREE_CHILD_NUM] = {0, 0, 0};
+    for (int i = 0; i < aAreaNum; ++i)
+    {
+        ++countArray[aNode->getSplitSide(aAreaArray[i]->getBoundRect())];
+    }
+    int beginArray[XYTREE_CHILD_NUM] = {0, countArray[XYTREE_CHILD_LEFT],
+                                        countArray[XYTREE_CHILD_LEFT] + countArray[XYTREE_CHILD_MIDDLE]};
+    int offsetArray[XYTREE_CHILD_NUM] = {beginArray[0], beginArray[1], beginArray[2]};
+    for (int i = 0; i < aAreaNum; ++i)
+    {
+        aBufArray[offsetArray[aNode->getSplitSide(aAreaArray[i]->getBoundRect())]++] = aAreaArray[i];
+    }
+
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
     {
-        // 创建一个子节点(近邻树叶) : 坐标初值MININT, 默认方向垂直分割，且存放树叶
-        createTree(-DBL_MAX, XYTREE_SPLIT_X);
-        for (auto* area : areaArray)
+        if (0 == countArray[i])
+            continue;
+        XYTreeChildType childType = (XYTreeChildType)i;
+        ComponentArea** childArray = aBufArray + beginArray[i];
+        if (!aNode->isChildAreaArray(childType))
+        {
+            // 子树的划分以原数组的对应段为缓冲区
+            commitBatchAdd(aNode->getChildNode(childType), childArray, aAreaArray + beginArray[i], countArray[i],
+                           dirtyArray);
+            continue;
+        }
+
+        XYTreeLeaf* leaf = aNode->getChildLeaf(childType);
+        if (nullptr == leaf)
         {
-            addAreaToTree(area);
+            leaf = mMemPool->create<XYTreeLeaf>(aNode, mMemPool);
+            aNode->attachLeaf(childType, leaf);
+        }
+        BoundRect2D oldRect = *leaf->getBoundRect();
+        XYTreeTypeMask oldTypeMask = leaf->getTypeMask();
+        for (int j = 0; j < countArray[i]; ++j)
+        {
+            AreaEntry& entry = mAreaDirectory[childArray[j]->mHandle];
+            entry.mLeaf = leaf;
+            entry.mSlot = (int)leaf->getAreaArray().size();
+            leaf->addArea(childArray[j]);  //只扩展树叶包围盒，祖先节点在提交最后统一调整
+        }
+        if (!oldRect.isValid() || !oldRect.isEqual(leaf->getBoundRect()) || oldTypeMask != leaf->getTypeMask())
+        {
+            dirtyArray.push_back(aNode);
+        }
+
+        // 与逐个插入相同的分裂规则，提交中只对每个树叶判断一次
+        int nAreaNum = (int)leaf->getAreaArray().size();
+        if (mLeafSplitFactor > 0 && nAreaNum > std::max(XY_THRESHOLD * mLeafSplitFactor, leaf->getSplitLimit()))
+        {
+            if (aNode->splitLeaf(mMemPool, childType))
+            {
+                updateDirectory(aNode->getChildNode(childType));  //分裂后的area分布到新子树的各树叶中
+            }
+            else
+            {
+                leaf->setSplitLimit(nAreaNum * 2);
+            }
         }
-        // leaf.removeAreaArray(false);
     }
-    leaf.removeAreaArray(false);
-    // print();
-    return mRootNode && !bArray;
+}
+void RXYTree::setLeafSplitFactor(int aLeafSplitFactor)
+{
+    assert(aLeafSplitFactor >= 0);
+    mLeafSplitFactor = aLeafSplitFactor;
+}
+void RXYTree::setRebuildDepthFactor(int aRebuildDepthFactor)
+{
+    assert(aRebuildDepthFactor >= 0);
+    mRebuildDepthFactor = aRebuildDepthFactor;
 }
 void RXYTree::print()
 {
@@ -779,24 +1476,385 @@ void RXYTree::print()
         return;
     mRootNode->print("", 0);
 }
-std::vector<ComponentArea*> RXYTree::getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY)
+std::vector<ComponentArea*> RXYTree::getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                                                         XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
 {
-    assert(mRootNode);
     std::vector<ComponentArea*> resultArray;
-    BoundRect2D srcRect(aMinX, aMinY, aMaxX, aMaxY);
-    mRootNode->search(srcRect, resultArray);
+    getCollideAreaArray(aMinX, aMinY, aMaxX, aMaxY, resultArray, aTypeMask);
     return resultArray;
 }
+int RXYTree::getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                                 std::vector<ComponentArea*>& resultArray,
+                                 XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    assert(mRootNode);
+    size_t nOldSize = resultArray.size();
+    search(BoundRect2D(aMinX, aMinY, aMaxX, aMaxY), XYTreeAppendVisitor(resultArray), aTypeMask);
+    return (int)(resultArray.size() - nOldSize);
+}
+bool RXYTree::isCollide(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                        XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    return nullptr != getFirstCollideArea(aMinX, aMinY, aMaxX, aMaxY, aTypeMask);
+}
+ComponentArea* RXYTree::getFirstCollideArea(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                                            XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    ComponentArea* firstArea = nullptr;
+    search(
+        BoundRect2D(aMinX, aMinY, aMaxX, aMaxY),
+        [&firstArea](ComponentArea* area)
+        {
+            firstArea = area;
+            return false;  //找到第一个即停止
+        },
+        aTypeMask);
+    return firstArea;
+}
+int RXYTree::getNearestAreaArray(const BoundRect2D& srcRect, int aCount, std::vector<XYTreeNeighbor>& resultArray,
+                                 double aMaxDist /*= DBL_MAX*/,
+                                 XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    resultArray.clear();
+    if (nullptr == mRootNode)
+    {
+        return 0;
+    }
+    mRootNode->searchNearest(srcRect, aCount, aMaxDist, aTypeMask, resultArray);
+    return (int)resultArray.size();
+}
+ComponentArea* RXYTree::getNearestArea(const BoundRect2D& srcRect, double* aDistance /*= nullptr*/,
+                                       double aMaxDist /*= DBL_MAX*/,
+                                       XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    std::vector<XYTreeNeighbor> resultArray;
+    if (0 == getNearestAreaArray(srcRect, 1, resultArray, aMaxDist, aTypeMask))
+    {
+        return nullptr;
+    }
+    if (aDistance)
+    {
+        *aDistance = resultArray[0].mDistance;
+    }
+    return resultArray[0].mArea;
+}
+// 将坐标量化为16位后交错，得到查询中心点的Morton码
+static unsigned int calcMortonCode(double x, double y, const BoundRect2D& aBound)
+{
+    double width = aBound.getMaxX() - aBound.getMinX();
+    double height = aBound.getMaxY() - aBound.getMinY();
+    unsigned int nX = width > 0 ? (unsigned int)((x - aBound.getMinX()) / width * 65535.0) : 0;
+    unsigned int nY = height > 0 ? (unsigned int)((y - aBound.getMinY()) / height * 65535.0) : 0;
+    unsigned int nCode = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        nCode |= ((nX >> i) & 1u) << (2 * i);
+        nCode |= ((nY >> i) & 1u) << (2 * i + 1);
+    }
+    return nCode;
+}
+void RXYTree::getCollideAreaBatch(const BoundRect2D* aRectArray, int aCount, XYTreeBatchResult& result) const
+{
+    result.clear();
+    if (aCount <= 0)
+    {
+        return;
+    }
+    result.mOffsetArray.assign(aCount + 1, 0);
+    if (nullptr == mRootNode)
+    {
+        return;
+    }
+
+    // 按查询中心点的Morton码排序，使空间上相邻的查询在遍历时相邻
+    BoundRect2D queryBound;
+    for (int i = 0; i < aCount; ++i)
+    {
+        queryBound.expandBound(&aRectArray[i]);
+    }
+    std::vector<std::pair<unsigned int, int>> codeArray(aCount);
+    for (int i = 0; i < aCount; ++i)
+    {
+        const BoundRect2D& rect = aRectArray[i];
+        codeArray[i].first = calcMortonCode((rect.getMinX() + rect.getMaxX()) / 2.0,
+                                            (rect.getMinY() + rect.getMaxY()) / 2.0, queryBound);
+        codeArray[i].second = i;
+    }
+    std::sort(codeArray.begin(), codeArray.end());
+
+    std::vector<int> queryArray(aCount);
+    for (int i = 0; i < aCount; ++i)
+    {
+        queryArray[i] = codeArray[i].second;
+    }
+    std::vector<std::vector<int>> levelArray;
+    std::vector<XYTreeBatchHit> hitArray;
+    mRootNode->searchBatch(aRectArray, queryArray.data(), aCount, 0, levelArray, hitArray);
+
+    // 按查询索引稳定地计数排序为CSR格式
+    for (const auto& hit : hitArray)
+    {
+        ++result.mOffsetArray[hit.first + 1];
+    }
+    for (int i = 0; i < aCount; ++i)
+    {
+        result.mOffsetArray[i + 1] += result.mOffsetArray[i];
+    }
+    std::vector<int> fillPos(result.mOffsetArray.begin(), result.mOffsetArray.end() - 1);
+    result.mAreaArray.resize(hitArray.size());
+    for (const auto& hit : hitArray)
+    {
+        result.mAreaArray[fillPos[hit.first]++] = hit.second;
+    }
+}
+void RXYTree::getCollideAreaBatchParallel(const BoundRect2D* aRectArray, int aCount, XYTreeBatchResult& result) const
+{
+    if (!mIsFrozen || nullptr == mThreadPool || aCount < XY_THRESHOLD)  //只有冻结的树才能保证并发只读访问
+    {
+        getCollideAreaBatch(aRectArray, aCount, result);
+        return;
+    }
+
+    // 查询列表切分为连续的块，每块在独立的结果中执行批量查询
+    int nChunkNum = std::min(mThreadPool->getThreadNum() * 4, aCount);
+    int nChunkSize = (aCount + nChunkNum - 1) / nChunkNum;
+    nChunkNum = (aCount + nChunkSize - 1) / nChunkSize;
+    std::vector<XYTreeBatchResult> chunkResultArray(nChunkNum);
+    mThreadPool->parallelFor(nChunkNum,
+                             [&](int nChunk)
+                             {
+                                 int nBegin = nChunk * nChunkSize;
+                                 int nEnd = std::min(nBegin + nChunkSize, aCount);
+                                 getCollideAreaBatch(aRectArray + nBegin, nEnd - nBegin, chunkResultArray[nChunk]);
+                             });
+
+    // 计算每块结果在总结果中的起始位置，再并行拷贝(各块写入互不重叠的区间)
+    std::vector<int> areaBaseArray(nChunkNum + 1, 0);
+    for (int i = 0; i < nChunkNum; ++i)
+    {
+        areaBaseArray[i + 1] = areaBaseArray[i] + (int)chunkResultArray[i].mAreaArray.size();
+    }
+    result.mOffsetArray.resize(aCount + 1);
+    result.mAreaArray.resize(areaBaseArray[nChunkNum]);
+    result.mOffsetArray[aCount] = areaBaseArray[nChunkNum];
+    mThreadPool->parallelFor(nChunkNum,
+                             [&](int nChunk)
+                             {
+                                 const XYTreeBatchResult& chunkResult = chunkResultArray[nChunk];
+                                 int nBase = areaBaseArray[nChunk];
+                                 int nQueryBase = nChunk * nChunkSize;
+                                 for (int i = 0, nNum = chunkResult.getQueryNum(); i < nNum; ++i)
+                                 {
+                                     result.mOffsetArray[nQueryBase + i] = nBase + chunkResult.mOffsetArray[i];
+                                 }
+                                 std::copy(chunkResult.mAreaArray.begin(), chunkResult.mAreaArray.end(),
+                                           result.mAreaArray.begin() + nBase);
+                             });
+}
+
+// 展开树的上层连接任务，直到任务数不少于 nMinTaskNum 或无法继续展开；展开后各任务报告的区域对互不重复
+static void expandJoinTask(std::vector<XYTreeJoinTask>& taskArray, int nMinTaskNum, double aClearance)
+{
+    bool bExpanded = true;
+    while (bExpanded && (int)taskArray.size() < nMinTaskNum)
+    {
+        bExpanded = false;
+        std::vector<XYTreeJoinTask> nextTaskArray;
+        for (const XYTreeJoinTask& task : taskArray)
+        {
+            if (task.mIsSelf && !task.mItem1.mIsLeaf)
+            {
+                const XYTreeNode* node = (const XYTreeNode*)task.mItem1.mPtr;
+                XYTreeJoinItem child[XYTREE_CHILD_NUM];
+                bool bChild[XYTREE_CHILD_NUM];
+                for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+                {
+                    bChild[i] = xyTreeGetJoinChild(node, (XYTreeChildType)i, child[i]);
+                    if (bChild[i])
+                        nextTaskArray.push_back({child[i], child[i], true});
+                }
+                if (bChild[XYTREE_CHILD_LEFT] && bChild[XYTREE_CHILD_MIDDLE])
+                    nextTaskArray.push_back({child[XYTREE_CHILD_LEFT], child[XYTREE_CHILD_MIDDLE], false});
+                if (bChild[XYTREE_CHILD_MIDDLE] && bChild[XYTREE_CHILD_RIGHT])
+                    nextTaskArray.push_back({child[XYTREE_CHILD_MIDDLE], child[XYTREE_CHILD_RIGHT], false});
+                if (aClearance > 0.0 && bChild[XYTREE_CHILD_LEFT] && bChild[XYTREE_CHILD_RIGHT])
+                    nextTaskArray.push_back({child[XYTREE_CHILD_LEFT], child[XYTREE_CHILD_RIGHT], false});
+                bExpanded = true;
+            }
+            else if (!task.mIsSelf && !(task.mItem1.mIsLeaf && task.mItem2.mIsLeaf))
+            {
+                // 展开非树叶的一侧，包围盒不相交的子任务直接丢弃
+                bool bExpand1 = !task.mItem1.mIsLeaf;
+                const XYTreeNode* node = (const XYTreeNode*)(bExpand1 ? task.mItem1.mPtr : task.mItem2.mPtr);
+                const XYTreeJoinItem& other = bExpand1 ? task.mItem2 : task.mItem1;
+                BoundRect2D otherRect = xyTreeInflate(*other.getBoundRect(), aClearance);
+                XYTreeJoinItem child;
+                for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+                {
+                    if (!xyTreeGetJoinChild(node, (XYTreeChildType)i, child) || !child.getBoundRect()->isValid() ||
+                        otherRect.isDisjoint(child.getBoundRect()))
+                        continue;
+                    nextTaskArray.push_back(bExpand1 ? XYTreeJoinTask{child, other, false}
+                                                     : XYTreeJoinTask{other, child, false});
+                }
+                bExpanded = true;
+            }
+            else
+            {
+                nextTaskArray.push_back(task);
+            }
+        }
+        taskArray.swap(nextTaskArray);
+    }
+}
+
+// 在线程池中执行连接任务
+static void runJoinTask(XYTreeThreadPool* threadPool, const std::vector<XYTreeJoinTask>& taskArray,
+                        const XYTreePairCallback& callback, double aClearance)
+{
+    auto runTask = [&](int nTask)
+    {
+        const XYTreeJoinTask& task = taskArray[nTask];
+        if (task.mIsSelf)
+            xyTreeJoinSelf(task.mItem1, aClearance, callback);
+        else
+            xyTreeJoinCross(task.mItem1, task.mItem2, aClearance, callback);
+    };
+    if (nullptr == threadPool)
+    {
+        for (int i = 0, nNum = (int)taskArray.size(); i < nNum; ++i)
+        {
+            runTask(i);
+        }
+        return;
+    }
+    threadPool->parallelFor((int)taskArray.size(), runTask);
+}
+
+void RXYTree::selfJoinParallel(const XYTreePairCallback& callback, double aClearance /*= 0.0*/) const
+{
+    assert(aClearance >= 0.0);
+    if (nullptr == mRootNode)
+        return;
+
+    XYTreeThreadPool* threadPool = mIsFrozen ? mThreadPool : nullptr;  //只有冻结的树才能保证并发只读访问
+    std::vector<XYTreeJoinTask> taskArray;
+    taskArray.push_back({XYTreeJoinItem{mRootNode, false}, XYTreeJoinItem{mRootNode, false}, true});
+    if (threadPool)
+    {
+        expandJoinTask(taskArray, threadPool->getThreadNum() * 8, aClearance);
+    }
+    runJoinTask(threadPool, taskArray, callback, aClearance);
+}
+
+void RXYTree::joinParallel(const RXYTree& otherTree, const XYTreePairCallback& callback,
+                           double aClearance /*= 0.0*/) const
+{
+    assert(aClearance >= 0.0);
+    if (nullptr == mRootNode || nullptr == otherTree.mRootNode)
+        return;
+
+    std::vector<XYTreeJoinTask> taskArray;
+    XYTreeJoinItem rootItem{mRootNode, false};
+    XYTreeJoinItem otherRootItem{otherTree.mRootNode, false};
+    if (!rootItem.getBoundRect()->isValid() || !otherRootItem.getBoundRect()->isValid())
+        return;
+    taskArray.push_back({rootItem, otherRootItem, false});
+    XYTreeThreadPool* threadPool =
+        (mIsFrozen && otherTree.mIsFrozen) ? mThreadPool : nullptr;  //只有冻结的树才能保证并发只读访问
+    if (threadPool)
+    {
+        expandJoinTask(taskArray, threadPool->getThreadNum() * 8, aClearance);
+    }
+    runJoinTask(threadPool, taskArray, callback, aClearance);
+}
 bool RXYTree::addAreaToTree(ComponentArea* area)
 {
     assert(mRootNode);
     assert(area);
 
     XYTreeChildType childType = XYTREE_CHILD_NUM;
-    XYTreeNode* curNode = mRootNode->expandBoundToLeaf(area->getBoundRect(), childType);
+    XYTreeNode* curNode =
+        mRootNode->expandBoundToLeaf(area->getBoundRect(), xyTreeTypeBit(area->getTypeId()), childType);
     assert(curNode && curNode->isChildAreaArray(childType));
-    curNode->addLeafArea(childType, area);
+    curNode->addLeafArea(mMemPool, childType, area);
+
+    XYTreeLeaf* leaf = curNode->getChildLeaf(childType);
+    int nAreaNum = (int)leaf->getAreaArray().size();
+    AreaEntry& entry = mAreaDirectory[area->mHandle];
+    entry.mLeaf = leaf;
+    entry.mSlot = nAreaNum - 1;
+
+    // 树叶超过分裂门限时，仅对该树叶原地重新平衡化；分裂失败时加倍该树叶的门限，保证插入代价均摊为对数级
+    if (mLeafSplitFactor > 0 && nAreaNum > std::max(XY_THRESHOLD * mLeafSplitFactor, leaf->getSplitLimit()))
+    {
+        if (curNode->splitLeaf(mMemPool, childType))
+        {
+            updateDirectory(curNode->getChildNode(childType));  //分裂后的area分布到新子树的各树叶中
+            rebuildUnbalancedAncestor(curNode->getChildNode(childType));
+        }
+        else
+        {
+            leaf->setSplitLimit(nAreaNum * 2);
+        }
+    }
     return true;
 }
+void RXYTree::rebuildUnbalancedAncestor(XYTreeNode* aNode)
+{
+    // 树叶只在局部分裂，有序插入时树会退化为链状。树的高度超过对数上限时，按 scapegoat 方式
+    // 从新节点向上找到最低的、高度超过按自身area数计算的上限的祖先，整体重建其子树，插入代价均摊为对数级
+    if (mRebuildDepthFactor <= 0)
+        return;
+    int nHeight = aNode->getHeight();
+    int nDepth = 0;
+    for (const XYTreeNode* node = aNode->getParent(); node; node = node->getParent())
+    {
+        ++nDepth;
+    }
+    int nTreeAreaNum = (int)(mAreaDirectory.size() - mFreeHandleArray.size());
+    if (nDepth + nHeight <= XYTreeNode::getHeightLimit(nTreeAreaNum, mRebuildDepthFactor))
+        return;
+
+    int nAreaNum = aNode->getAreaNum();
+    XYTreeNode* child = aNode;
+    for (XYTreeNode* node = aNode->getParent(); node; node = node->getParent())
+    {
+        ++nHeight;
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)  //累加兄弟子树的area数
+        {
+            XYTreeChildType childType = (XYTreeChildType)i;
+            if (node->isChildAreaArray(childType))
+            {
+                if (const XYTreeLeaf* leaf = node->getChildLeaf(childType))
+                    nAreaNum += (int)leaf->getAreaArray().size();
+            }
+            else if (node->getChildNode(childType) != child)
+            {
+                nAreaNum += node->getChildNode(childType)->getAreaNum();
+            }
+        }
+        if (nHeight > XYTreeNode::getHeightLimit(nAreaNum, mRebuildDepthFactor))
+        {
+            XYTreeNode* parent = node->getParent();
+            if (nullptr == parent)  //重建整棵树
+            {
+                XYTreeAreaArray areaArray{XYTreeAllocator<ComponentArea*>(mMemPool)};
+                mRootNode->TreeAreaToArray(areaArray);
+                XYTreeNode::freeNodesWithoutArea(mMemPool, &mRootNode, true);
+                buildRootNode(areaArray.data(), (int)areaArray.size());
+                return;
+            }
+            XYTreeChildType childType = parent->getChildIndex(node);
+            parent->rebuildChild(mMemPool, childType, mThreadPool, mParallelCutoff);
+            if (XYTreeNode* newNode = parent->getChildNode(childType))
+                updateDirectory(newNode);
+            else if (XYTreeLeaf* leaf = parent->getChildLeaf(childType))
+                updateDirectory(leaf);
+            return;
+        }
+        child = node;
+    }
+}
 
 }  // namespace Telos
\ No newline at end of file
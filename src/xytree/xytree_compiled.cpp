@@ -0,0 +1,201 @@
+#include "Telos/xytree/xytree_compiled.h"
+#include "Telos/xytree/xytree_flatten.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace Telos
+{
+
+// 记录尺寸决定了每个树节点占据的缓存行数
+static_assert(sizeof(XYTreeCompiledNode) == 64, "compiled node must fill exactly one cache line");
+static_assert(sizeof(XYTreeCompiledLeaf) == 48, "compiled leaf layout changed");
+static_assert(sizeof(XYTreeCompactNode) == 32, "compact node must be half of a compiled node");
+static_assert(sizeof(XYTreeCompactLeaf) == 24, "compact leaf layout changed");
+
+static void setCompiledBound(double* aBound, const BoundRect2D* srcRect)
+{
+    aBound[0] = srcRect->getMinX();
+    aBound[1] = srcRect->getMinY();
+    aBound[2] = srcRect->getMaxX();
+    aBound[3] = srcRect->getMaxY();
+}
+
+// double向下取整为float(结果不大于原值)
+static float floatDown(double aValue)
+{
+    float fValue = (float)aValue;
+    return (double)fValue > aValue ? std::nextafter(fValue, -INFINITY) : fValue;
+}
+
+// double向上取整为float(结果不小于原值)
+static float floatUp(double aValue)
+{
+    float fValue = (float)aValue;
+    return (double)fValue < aValue ? std::nextafter(fValue, INFINITY) : fValue;
+}
+
+// 保守包围盒: 包含原包围盒，剪枝时不会漏掉相交的子树
+static void setCompactBound(float* aBound, const double* srcBound)
+{
+    aBound[0] = floatDown(srcBound[0]);
+    aBound[1] = floatDown(srcBound[1]);
+    aBound[2] = floatUp(srcBound[2]);
+    aBound[3] = floatUp(srcBound[3]);
+}
+
+// 编译写入器: 由 flattenXYTree 先序遍历树，把节点、树叶和area依次追加到编译形式的各数组
+struct XYTreeCompiledWriter
+{
+    std::vector<XYTreeCompiledNode>& mNodeArray;
+    std::vector<XYTreeCompiledLeaf>& mLeafArray;
+    std::vector<double>* mRectArray[4];  // minX, minY, maxX, maxY
+    std::vector<ComponentArea*>& mAreaArray;
+
+    XYTreeCompiledWriter(std::vector<XYTreeCompiledNode>& aNodeArray, std::vector<XYTreeCompiledLeaf>& aLeafArray,
+                         std::vector<double>& aMinX, std::vector<double>& aMinY, std::vector<double>& aMaxX,
+                         std::vector<double>& aMaxY, std::vector<ComponentArea*>& aAreaArray)
+        : mNodeArray(aNodeArray), mLeafArray(aLeafArray), mRectArray{&aMinX, &aMinY, &aMaxX, &aMaxY},
+          mAreaArray(aAreaArray)
+    {
+    }
+
+    uint32_t getSlotNum() const { return (uint32_t)mAreaArray.size(); }
+
+    uint32_t addNode(const XYTreeNode* node)
+    {
+        assert(mNodeArray.size() < XYTREE_COMPILED_LEAF_BIT);
+        mNodeArray.emplace_back();
+        XYTreeCompiledNode& nodeRecord = mNodeArray.back();
+        setCompiledBound(nodeRecord.mBound, node->getBoundRect());
+        nodeRecord.mSplitPos = node->getSplitPos();
+        nodeRecord.mTypeMask = node->getTypeMask();
+        nodeRecord.mSplitDir = (uint8_t)node->getSplitDir();
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            nodeRecord.mChild[i] = XYTREE_COMPILED_NULL_CHILD;
+        }
+        return (uint32_t)mNodeArray.size() - 1;
+    }
+
+    void setChild(uint32_t nNode, int nChild, uint32_t nItem, bool bLeaf)
+    {
+        mNodeArray[nNode].mChild[nChild] = bLeaf ? (nItem | XYTREE_COMPILED_LEAF_BIT) : nItem;
+    }
+
+    uint32_t addLeaf(const XYTreeLeaf* leaf, uint32_t nSlotBegin)
+    {
+        XYTreeCompiledLeaf leafRecord;
+        setCompiledBound(leafRecord.mBound, leaf->getBoundRect());
+        leafRecord.mTypeMask = leaf->getTypeMask();
+        leafRecord.mSlotBegin = nSlotBegin;
+        leafRecord.mAreaNum = (uint32_t)leaf->getAreaArray().size();
+        mLeafArray.push_back(leafRecord);
+        return (uint32_t)mLeafArray.size() - 1;
+    }
+
+    void addSlot(double aMinX, double aMinY, double aMaxX, double aMaxY, ComponentArea* area)
+    {
+        mRectArray[0]->push_back(aMinX);
+        mRectArray[1]->push_back(aMinY);
+        mRectArray[2]->push_back(aMaxX);
+        mRectArray[3]->push_back(aMaxY);
+        mAreaArray.push_back(area);
+    }
+};
+
+void XYTreeCompiled::buildCompact()
+{
+    mCompactNodeArray.resize(mNodeArray.size());
+    mNodeTypeMaskArray.resize(mNodeArray.size());
+    for (size_t i = 0; i < mNodeArray.size(); ++i)
+    {
+        setCompactBound(mCompactNodeArray[i].mBound, mNodeArray[i].mBound);
+        for (int j = XYTREE_CHILD_LEFT; j < XYTREE_CHILD_NUM; ++j)
+        {
+            mCompactNodeArray[i].mChild[j] = mNodeArray[i].mChild[j];
+        }
+        mNodeTypeMaskArray[i] = mNodeArray[i].mTypeMask;
+    }
+
+    mCompactLeafArray.resize(mLeafArray.size());
+    mLeafTypeMaskArray.resize(mLeafArray.size());
+    for (size_t i = 0; i < mLeafArray.size(); ++i)
+    {
+        setCompactBound(mCompactLeafArray[i].mBound, mLeafArray[i].mBound);
+        mCompactLeafArray[i].mSlotBegin = mLeafArray[i].mSlotBegin;
+        mCompactLeafArray[i].mAreaNum = mLeafArray[i].mAreaNum;
+        mLeafTypeMaskArray[i] = mLeafArray[i].mTypeMask;
+    }
+
+    std::vector<XYTreeCompiledNode>().swap(mNodeArray);
+    std::vector<XYTreeCompiledLeaf>().swap(mLeafArray);
+}
+
+void XYTreeCompiled::compile(const RXYTree& tree, bool bCompact /*= false*/)
+{
+    clear();
+    if (nullptr == tree.getRootNode())
+    {
+        return;
+    }
+    XYTreeCompiledWriter writer(mNodeArray, mLeafArray, mMinX, mMinY, mMaxX, mMaxY, mAreaArray);
+    flattenXYTree(tree.getRootNode(), writer);
+    if (bCompact)
+    {
+        buildCompact();
+        mIsCompact = true;
+    }
+}
+
+void XYTreeCompiled::clear()
+{
+    mNodeArray.clear();
+    mLeafArray.clear();
+    mCompactNodeArray.clear();
+    mCompactLeafArray.clear();
+    mNodeTypeMaskArray.clear();
+    mLeafTypeMaskArray.clear();
+    mIsCompact = false;
+    mMinX.clear();
+    mMinY.clear();
+    mMaxX.clear();
+    mMaxY.clear();
+    mAreaArray.clear();
+}
+
+int XYTreeCompiled::getAreaNum() const
+{
+    int nAreaNum = 0;
+    for (const XYTreeCompiledLeaf& leaf : mLeafArray)
+    {
+        nAreaNum += (int)leaf.mAreaNum;
+    }
+    for (const XYTreeCompactLeaf& leaf : mCompactLeafArray)
+    {
+        nAreaNum += (int)leaf.mAreaNum;
+    }
+    return nAreaNum;
+}
+
+size_t XYTreeCompiled::getNodeBytes() const
+{
+    if (mIsCompact)
+    {
+        return mCompactNodeArray.size() * sizeof(XYTreeCompactNode) +
+               mCompactLeafArray.size() * sizeof(XYTreeCompactLeaf) +
+               (mNodeTypeMaskArray.size() + mLeafTypeMaskArray.size()) * sizeof(XYTreeTypeMask);
+    }
+    return mNodeArray.size() * sizeof(XYTreeCompiledNode) + mLeafArray.size() * sizeof(XYTreeCompiledLeaf);
+}
+
+int XYTreeCompiled::getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                                        std::vector<ComponentArea*>& resultArray,
+                                        XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    size_t nOldSize = resultArray.size();
+    search(BoundRect2D(aMinX, aMinY, aMaxX, aMaxY), XYTreeAppendVisitor(resultArray), aTypeMask);
+    return (int)(resultArray.size() - nOldSize);
+}
+
+}  // namespace Telos
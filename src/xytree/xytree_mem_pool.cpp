@@ -0,0 +1,144 @@
+#include "Telos/xytree/xytree_mem_pool.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+namespace Telos
+{
+
+static size_t alignSize(size_t size)
+{
+    return (size + XY_MEMPOOL_ALIGN - 1) & ~(size_t)(XY_MEMPOOL_ALIGN - 1);
+}
+
+int XYTreeMemPool::getSizeClass(size_t size, size_t& classSize)
+{
+    if (size <= XY_MEMPOOL_SMALL_CLASS_NUM * XY_MEMPOOL_ALIGN)  // 小对象: 按16字节分档
+    {
+        classSize = alignSize(size > 0 ? size : 1);
+        return (int)(classSize / XY_MEMPOOL_ALIGN) - 1;
+    }
+
+    // 大对象: 按2的幂次分档
+    int nPower = 0;
+    classSize = 1;
+    while (classSize < size)
+    {
+        classSize <<= 1;
+        ++nPower;
+    }
+    int nSmallPower = 0;  // 小对象最大尺寸对应的幂次
+    for (size_t n = XY_MEMPOOL_SMALL_CLASS_NUM * XY_MEMPOOL_ALIGN; n > 1; n >>= 1)
+    {
+        ++nSmallPower;
+    }
+    int nClass = XY_MEMPOOL_SMALL_CLASS_NUM + nPower - nSmallPower - 1;
+    assert(nClass < XY_MEMPOOL_CLASS_NUM);
+    return nClass;
+}
+
+void XYTreeMemPool::allocateBlock(size_t size)
+{
+    size_t headSize = alignSize(sizeof(Block));
+    size_t blockSize = headSize + size;
+    if (blockSize < XY_MEMPOOL_BLOCK_SIZE)
+    {
+        blockSize = XY_MEMPOOL_BLOCK_SIZE;
+    }
+
+    Block* block = (Block*)malloc(blockSize);
+    assert(block);
+    block->mNext = mBlockList;
+    block->mSize = blockSize;
+    mBlockList = block;
+    mBlockBytes += blockSize;
+
+    mCurPtr = (char*)block + headSize;
+    mEndPtr = (char*)block + blockSize;
+}
+
+XYTreeMemPool::XYTreeMemPool() : mBlockList(nullptr), mCurPtr(nullptr), mEndPtr(nullptr), mBlockBytes(0)
+{
+    for (auto& freeList : mFreeList)
+    {
+        freeList = nullptr;
+    }
+}
+
+XYTreeMemPool::~XYTreeMemPool()
+{
+    release();
+}
+
+void* XYTreeMemPool::allocate(size_t size)
+{
+    size_t classSize = 0;
+    int nClass = getSizeClass(size, classSize);
+    FreeNode* node = mFreeList[nClass];
+    if (node)  // 优先复用空闲链表中的内存
+    {
+        mFreeList[nClass] = node->mNext;
+        return node;
+    }
+
+    if ((size_t)(mEndPtr - mCurPtr) < classSize)
+    {
+        allocateBlock(classSize);
+    }
+    void* ptr = mCurPtr;
+    mCurPtr += classSize;
+    return ptr;
+}
+
+void XYTreeMemPool::deallocate(void* ptr, size_t size)
+{
+    if (nullptr == ptr)
+        return;
+    size_t classSize = 0;
+    int nClass = getSizeClass(size, classSize);
+    FreeNode* node = (FreeNode*)ptr;
+    node->mNext = mFreeList[nClass];
+    mFreeList[nClass] = node;
+}
+
+void XYTreeMemPool::release()
+{
+    Block* block = mBlockList;
+    while (block)
+    {
+        Block* next = block->mNext;
+        free(block);
+        block = next;
+    }
+    mBlockList = nullptr;
+    mCurPtr = nullptr;
+    mEndPtr = nullptr;
+    mBlockBytes = 0;
+    for (auto& freeList : mFreeList)
+    {
+        freeList = nullptr;
+    }
+    for (auto* childPool : mChildPoolArray)
+    {
+        delete childPool;
+    }
+    mChildPoolArray.clear();
+}
+
+void XYTreeMemPool::adopt(XYTreeMemPool* childPool)
+{
+    assert(childPool && childPool != this);
+    mChildPoolArray.push_back(childPool);
+}
+
+size_t XYTreeMemPool::getBlockBytes() const
+{
+    size_t nBytes = mBlockBytes;
+    for (const auto* childPool : mChildPoolArray)
+    {
+        nBytes += childPool->getBlockBytes();
+    }
+    return nBytes;
+}
+
+}  // namespace Telos
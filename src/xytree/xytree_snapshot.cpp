@@ -0,0 +1,323 @@
+#include "Telos/xytree/xytree_snapshot.h"
+#include "Telos/xytree/xytree_flatten.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Telos
+{
+
+// 记录尺寸是文件格式的一部分
+static_assert(sizeof(XYTreeSnapshotHeader) == 72, "snapshot header layout changed");
+static_assert(sizeof(XYTreeSnapshotNode) == 64, "snapshot node layout changed");
+static_assert(sizeof(XYTreeSnapshotLeaf) == 48, "snapshot leaf layout changed");
+static_assert(sizeof(XYTreeSnapshotArea) == 16, "snapshot area layout changed");
+
+static uint64_t alignOffset(uint64_t nOffset)
+{
+    return (nOffset + XYTREE_SNAPSHOT_ALIGN - 1) & ~(uint64_t)(XYTREE_SNAPSHOT_ALIGN - 1);
+}
+
+static void setSnapshotBound(double* aBound, const BoundRect2D* srcRect)
+{
+    aBound[0] = srcRect->getMinX();
+    aBound[1] = srcRect->getMinY();
+    aBound[2] = srcRect->getMaxX();
+    aBound[3] = srcRect->getMaxY();
+}
+
+// 快照写入器: 由 flattenXYTree 先序遍历树，把节点、树叶和area依次追加到各数据段
+struct XYTreeSnapshotWriter
+{
+    const XYTreeSnapshotIdFunc& mIdFunc;  // 用户ID(为空时使用 getAddr() 的整数值)
+    std::vector<XYTreeSnapshotNode> mNodeArray;
+    std::vector<XYTreeSnapshotLeaf> mLeafArray;
+    std::vector<double> mRectArray[4];  // minX, minY, maxX, maxY
+    std::vector<XYTreeSnapshotArea> mAreaArray;
+
+    explicit XYTreeSnapshotWriter(const XYTreeSnapshotIdFunc& aIdFunc) : mIdFunc(aIdFunc) {}
+
+    uint32_t getSlotNum() const { return (uint32_t)mAreaArray.size(); }
+
+    uint32_t addNode(const XYTreeNode* node)
+    {
+        XYTreeSnapshotNode nodeRecord;
+        memset(&nodeRecord, 0, sizeof(nodeRecord));
+        setSnapshotBound(nodeRecord.mBound, node->getBoundRect());
+        nodeRecord.mSplitPos = node->getSplitPos();
+        nodeRecord.mSplitDir = (uint8_t)node->getSplitDir();
+        nodeRecord.mTypeMask = node->getTypeMask();
+        for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+        {
+            nodeRecord.mChild[i] = XYTREE_SNAPSHOT_NULL_CHILD;
+            nodeRecord.mIsLeaf[i] = 1;
+        }
+        mNodeArray.push_back(nodeRecord);
+        return (uint32_t)mNodeArray.size() - 1;
+    }
+
+    void setChild(uint32_t nNode, int nChild, uint32_t nItem, bool bLeaf)
+    {
+        mNodeArray[nNode].mChild[nChild] = (int32_t)nItem;
+        mNodeArray[nNode].mIsLeaf[nChild] = bLeaf ? 1 : 0;
+    }
+
+    uint32_t addLeaf(const XYTreeLeaf* leaf, uint32_t nSlotBegin)
+    {
+        XYTreeSnapshotLeaf leafRecord;
+        setSnapshotBound(leafRecord.mBound, leaf->getBoundRect());
+        leafRecord.mTypeMask = leaf->getTypeMask();
+        leafRecord.mSlotBegin = nSlotBegin;
+        leafRecord.mAreaNum = (uint32_t)leaf->getAreaArray().size();
+        mLeafArray.push_back(leafRecord);
+        return (uint32_t)mLeafArray.size() - 1;
+    }
+
+    void addSlot(double aMinX, double aMinY, double aMaxX, double aMaxY, ComponentArea* area)
+    {
+        mRectArray[0].push_back(aMinX);
+        mRectArray[1].push_back(aMinY);
+        mRectArray[2].push_back(aMaxX);
+        mRectArray[3].push_back(aMaxY);
+        if (nullptr == area)
+        {
+            mAreaArray.push_back(XYTreeSnapshotArea{0, -1, XYTREE_INVALID_HANDLE});
+            return;
+        }
+        uint64_t nUserData = mIdFunc ? mIdFunc(area) : (uint64_t)(uintptr_t)area->getAddr();
+        mAreaArray.push_back(XYTreeSnapshotArea{nUserData, (int32_t)area->getTypeId(), (int32_t)area->getHandle()});
+    }
+};
+
+static bool writePadding(FILE* file, uint64_t& nOffset, uint64_t nTarget)
+{
+    static const char zeroArray[XYTREE_SNAPSHOT_ALIGN] = {0};
+    assert(nTarget >= nOffset && nTarget - nOffset < XYTREE_SNAPSHOT_ALIGN);
+    size_t nBytes = (size_t)(nTarget - nOffset);
+    nOffset = nTarget;
+    return nBytes == fwrite(zeroArray, 1, nBytes, file);
+}
+
+static bool writeSection(FILE* file, uint64_t& nOffset, const void* aData, size_t nBytes)
+{
+    if (0 == nBytes)  //空数据段(如空树没有树叶)的数据指针可能为空，不调用fwrite
+    {
+        return true;
+    }
+    nOffset += nBytes;
+    return nBytes == fwrite(aData, 1, nBytes, file);
+}
+
+XYTreeSnapshot::XYTreeSnapshot()
+    : mData(nullptr),
+      mSize(0),
+      mIsMapped(false),
+      mHeader(nullptr),
+      mNodeArray(nullptr),
+      mLeafArray(nullptr),
+      mMinX(nullptr),
+      mMinY(nullptr),
+      mMaxX(nullptr),
+      mMaxY(nullptr),
+      mAreaArray(nullptr)
+{
+}
+XYTreeSnapshot::~XYTreeSnapshot()
+{
+    close();
+}
+bool XYTreeSnapshot::write(const RXYTree& tree, const char* aFileName,
+                           const XYTreeSnapshotIdFunc& aIdFunc /*= nullptr*/)
+{
+    assert(aFileName);
+    XYTreeSnapshotWriter writer(aIdFunc);
+    if (tree.getRootNode())
+    {
+        flattenXYTree(tree.getRootNode(), writer);
+    }
+
+    XYTreeSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.mMagic, XYTREE_SNAPSHOT_MAGIC, sizeof(header.mMagic));
+    header.mVersion = XYTREE_SNAPSHOT_VERSION;
+    header.mByteOrder = XYTREE_SNAPSHOT_BYTE_ORDER;
+    header.mNodeNum = (uint32_t)writer.mNodeArray.size();
+    header.mLeafNum = (uint32_t)writer.mLeafArray.size();
+    header.mSlotNum = (uint32_t)writer.mAreaArray.size();
+    for (const XYTreeSnapshotLeaf& leaf : writer.mLeafArray)
+    {
+        header.mAreaNum += leaf.mAreaNum;
+    }
+    size_t nRectBytes = sizeof(double) * header.mSlotNum;
+    header.mNodeOffset = alignOffset(sizeof(header));
+    header.mLeafOffset = alignOffset(header.mNodeOffset + sizeof(XYTreeSnapshotNode) * header.mNodeNum);
+    header.mRectOffset = alignOffset(header.mLeafOffset + sizeof(XYTreeSnapshotLeaf) * header.mLeafNum);
+    header.mAreaOffset = alignOffset(header.mRectOffset + 4 * nRectBytes);
+    header.mFileSize = header.mAreaOffset + sizeof(XYTreeSnapshotArea) * header.mSlotNum;
+
+    FILE* file = fopen(aFileName, "wb");
+    if (nullptr == file)
+    {
+        return false;
+    }
+    uint64_t nOffset = 0;
+    bool bOk = writeSection(file, nOffset, &header, sizeof(header));
+    bOk = bOk && writePadding(file, nOffset, header.mNodeOffset);
+    bOk = bOk && writeSection(file, nOffset, writer.mNodeArray.data(), sizeof(XYTreeSnapshotNode) * header.mNodeNum);
+    bOk = bOk && writePadding(file, nOffset, header.mLeafOffset);
+    bOk = bOk && writeSection(file, nOffset, writer.mLeafArray.data(), sizeof(XYTreeSnapshotLeaf) * header.mLeafNum);
+    bOk = bOk && writePadding(file, nOffset, header.mRectOffset);
+    for (int k = 0; k < 4; ++k)
+    {
+        bOk = bOk && writeSection(file, nOffset, writer.mRectArray[k].data(), nRectBytes);
+    }
+    bOk = bOk && writePadding(file, nOffset, header.mAreaOffset);
+    bOk = bOk && writeSection(file, nOffset, writer.mAreaArray.data(), sizeof(XYTreeSnapshotArea) * header.mSlotNum);
+    bOk = (0 == fclose(file)) && bOk;
+    assert(!bOk || nOffset == header.mFileSize);
+    return bOk;
+}
+bool XYTreeSnapshot::open(const char* aFileName)
+{
+    assert(aFileName);
+    close();
+#ifdef _WIN32
+    // 无mmap: 整体读入内存(只读取一次，不做任何转换)
+    FILE* file = fopen(aFileName, "rb");
+    if (nullptr == file)
+    {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long nSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = nSize > 0 ? (char*)malloc((size_t)nSize) : nullptr;
+    if (data && (size_t)nSize == fread(data, 1, (size_t)nSize, file))
+    {
+        mData = data;
+        mSize = (size_t)nSize;
+    }
+    else
+    {
+        free(data);
+    }
+    fclose(file);
+#else
+    int fd = ::open(aFileName, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if (0 == fstat(fd, &fileStat) && fileStat.st_size > 0)
+    {
+        void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (MAP_FAILED != data)
+        {
+            mData = (const char*)data;
+            mSize = (size_t)fileStat.st_size;
+            mIsMapped = true;
+        }
+    }
+    ::close(fd);  //映射建立后即可关闭文件
+#endif
+    if (nullptr == mData || !attach())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+void XYTreeSnapshot::close()
+{
+    if (mData)
+    {
+#ifdef _WIN32
+        free((void*)mData);
+#else
+        if (mIsMapped)
+            munmap((void*)mData, mSize);
+#endif
+    }
+    mData = nullptr;
+    mSize = 0;
+    mIsMapped = false;
+    mHeader = nullptr;
+    mNodeArray = nullptr;
+    mLeafArray = nullptr;
+    mMinX = mMinY = mMaxX = mMaxY = nullptr;
+    mAreaArray = nullptr;
+}
+bool XYTreeSnapshot::attach()
+{
+    if (mSize < sizeof(XYTreeSnapshotHeader))
+        return false;
+    const XYTreeSnapshotHeader* header = (const XYTreeSnapshotHeader*)mData;
+    if (0 != memcmp(header->mMagic, XYTREE_SNAPSHOT_MAGIC, sizeof(header->mMagic)) ||
+        XYTREE_SNAPSHOT_VERSION != header->mVersion || XYTREE_SNAPSHOT_BYTE_ORDER != header->mByteOrder ||
+        header->mFileSize != mSize || header->mSlotNum % XY_SIMD_BLOCK)
+        return false;
+
+    // 各数据段必须对齐且位于文件内
+    auto isSectionValid = [this](uint64_t nOffset, uint64_t nBytes)
+    { return 0 == nOffset % XYTREE_SNAPSHOT_ALIGN && nOffset <= mSize && nBytes <= mSize - nOffset; };
+    uint64_t nRectBytes = sizeof(double) * header->mSlotNum;
+    if (!isSectionValid(header->mNodeOffset, sizeof(XYTreeSnapshotNode) * (uint64_t)header->mNodeNum) ||
+        !isSectionValid(header->mLeafOffset, sizeof(XYTreeSnapshotLeaf) * (uint64_t)header->mLeafNum) ||
+        !isSectionValid(header->mRectOffset, 4 * nRectBytes) ||
+        !isSectionValid(header->mAreaOffset, sizeof(XYTreeSnapshotArea) * (uint64_t)header->mSlotNum))
+        return false;
+
+    const XYTreeSnapshotNode* nodeArray = (const XYTreeSnapshotNode*)(mData + header->mNodeOffset);
+    const XYTreeSnapshotLeaf* leafArray = (const XYTreeSnapshotLeaf*)(mData + header->mLeafOffset);
+
+    // 校验节点和树叶中的下标(只访问节点和树叶段，area数据不做任何处理)，保证查询不会越界
+    for (uint32_t i = 0; i < header->mNodeNum; ++i)
+    {
+        for (int k = XYTREE_CHILD_LEFT; k < XYTREE_CHILD_NUM; ++k)
+        {
+            int32_t nChild = nodeArray[i].mChild[k];
+            if (XYTREE_SNAPSHOT_NULL_CHILD == nChild)
+                continue;
+            uint32_t nLimit = nodeArray[i].mIsLeaf[k] ? header->mLeafNum : header->mNodeNum;
+            if (nChild < 0 || (uint32_t)nChild >= nLimit || (!nodeArray[i].mIsLeaf[k] && (uint32_t)nChild <= i))
+                return false;  //子节点在先序中位于父节点之后，保证无环
+        }
+    }
+    for (uint32_t i = 0; i < header->mLeafNum; ++i)
+    {
+        const XYTreeSnapshotLeaf& leaf = leafArray[i];
+        if (leaf.mSlotBegin % XY_SIMD_BLOCK || leaf.mSlotBegin > header->mSlotNum ||
+            leaf.mAreaNum > header->mSlotNum - leaf.mSlotBegin)
+            return false;
+    }
+
+    mHeader = header;
+    mNodeArray = nodeArray;
+    mLeafArray = leafArray;
+    mMinX = (const double*)(mData + header->mRectOffset);
+    mMinY = mMinX + header->mSlotNum;
+    mMaxX = mMinY + header->mSlotNum;
+    mMaxY = mMaxX + header->mSlotNum;
+    mAreaArray = (const XYTreeSnapshotArea*)(mData + header->mAreaOffset);
+    return true;
+}
+int XYTreeSnapshot::getCollideAreaArray(double aMinX, double aMinY, double aMaxX, double aMaxY,
+                                        std::vector<int>& slotArray,
+                                        XYTreeTypeMask aTypeMask /*= XYTREE_TYPE_MASK_ALL*/) const
+{
+    size_t nOldSize = slotArray.size();
+    search(
+        BoundRect2D(aMinX, aMinY, aMaxX, aMaxY), [&slotArray](int aSlot) { slotArray.push_back(aSlot); }, aTypeMask);
+    return (int)(slotArray.size() - nOldSize);
+}
+
+}  // namespace Telos
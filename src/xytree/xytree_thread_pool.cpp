@@ -0,0 +1,158 @@
+#include "Telos/xytree/xytree_thread_pool.h"
+
+#include <assert.h>
+#include <chrono>
+
+namespace Telos
+{
+
+// 当前线程所属的线程池及其队列索引
+static thread_local const XYTreeThreadPool* g_curThreadPool = nullptr;
+static thread_local int g_curQueueIndex = 0;
+
+int XYTreeThreadPool::getQueueIndex() const
+{
+    return g_curThreadPool == this ? g_curQueueIndex : 0;
+}
+
+bool XYTreeThreadPool::runOneTask(int nQueueIndex)
+{
+    std::function<void()> task;
+    XYTreeTaskGroup* group = nullptr;
+
+    // 优先从自身队列尾部取任务
+    {
+        WorkQueue* queue = mQueueArray[nQueueIndex];
+        std::lock_guard<std::mutex> lock(queue->mMutex);
+        if (!queue->mTaskList.empty())
+        {
+            task = std::move(queue->mTaskList.back().first);
+            group = queue->mTaskList.back().second;
+            queue->mTaskList.pop_back();
+        }
+    }
+
+    // 自身队列为空时，从其他队列头部窃取任务
+    int nQueueNum = (int)mQueueArray.size();
+    for (int i = 1; nullptr == group && i < nQueueNum; ++i)
+    {
+        WorkQueue* queue = mQueueArray[(nQueueIndex + i) % nQueueNum];
+        std::lock_guard<std::mutex> lock(queue->mMutex);
+        if (!queue->mTaskList.empty())
+        {
+            task = std::move(queue->mTaskList.front().first);
+            group = queue->mTaskList.front().second;
+            queue->mTaskList.pop_front();
+        }
+    }
+
+    if (nullptr == group)
+    {
+        return false;
+    }
+    mQueuedNum.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    group->mPendingNum.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void XYTreeThreadPool::workerLoop(int nQueueIndex)
+{
+    g_curThreadPool = this;
+    g_curQueueIndex = nQueueIndex;
+    while (!mIsStop.load(std::memory_order_acquire))
+    {
+        if (runOneTask(nQueueIndex))
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleepCond.wait_for(lock, std::chrono::milliseconds(10),
+                            [this]
+                            { return mIsStop.load(std::memory_order_acquire) || mQueuedNum.load() > 0; });
+    }
+}
+
+XYTreeThreadPool::XYTreeThreadPool(int nThreadNum)
+{
+    if (nThreadNum <= 0)
+    {
+        nThreadNum = (int)std::thread::hardware_concurrency();
+        if (nThreadNum <= 0)
+            nThreadNum = 1;
+    }
+    for (int i = 0; i < nThreadNum; ++i)
+    {
+        mQueueArray.push_back(new WorkQueue());
+    }
+    for (int i = 1; i < nThreadNum; ++i)
+    {
+        mThreadArray.emplace_back(&XYTreeThreadPool::workerLoop, this, i);
+    }
+}
+
+XYTreeThreadPool::~XYTreeThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mIsStop.store(true, std::memory_order_release);
+    }
+    mSleepCond.notify_all();
+    for (auto& thread : mThreadArray)
+    {
+        thread.join();
+    }
+    for (auto* queue : mQueueArray)
+    {
+        assert(queue->mTaskList.empty());
+        delete queue;
+    }
+    mQueueArray.clear();
+}
+
+void XYTreeThreadPool::submit(XYTreeTaskGroup& group, std::function<void()> task)
+{
+    group.mPendingNum.fetch_add(1, std::memory_order_acq_rel);
+    if (mThreadArray.empty())  // 单线程: 直接执行
+    {
+        task();
+        group.mPendingNum.fetch_sub(1, std::memory_order_acq_rel);
+        return;
+    }
+
+    WorkQueue* queue = mQueueArray[getQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->mMutex);
+        queue->mTaskList.emplace_back(std::move(task), &group);
+    }
+    mQueuedNum.fetch_add(1, std::memory_order_relaxed);
+    mSleepCond.notify_one();
+}
+
+void XYTreeThreadPool::wait(XYTreeTaskGroup& group)
+{
+    int nQueueIndex = getQueueIndex();
+    while (!group.isFinished())
+    {
+        if (!runOneTask(nQueueIndex))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void XYTreeThreadPool::parallelFor(int nTaskNum, const std::function<void(int)>& func)
+{
+    XYTreeTaskGroup group;
+    for (int i = 1; i < nTaskNum; ++i)
+    {
+        submit(group, [&func, i] { func(i); });
+    }
+    if (nTaskNum > 0)
+    {
+        func(0);  //第0个任务由调用线程执行
+    }
+    wait(group);
+}
+
+}  // namespace Telos
@@ -0,0 +1,157 @@
+/**
+ * @file bench_data.h
+ * @brief 性能测试用的合成数据集
+ */
+
+#ifndef BENCH_DATA_H
+#define BENCH_DATA_H
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace TelosBench
+{
+
+#define BENCH_WORLD_SIZE 100000.0  // 数据集所在的世界范围 [0, BENCH_WORLD_SIZE]
+#define BENCH_SEED 20250312        // 随机种子(保证每次运行的数据一致)
+
+// 数据分布类型
+enum BenchDistribution
+{
+    BENCH_UNIFORM = 0,    // 均匀分布
+    BENCH_CLUSTERED = 1,  // 聚簇分布: 器件集中在若干个热点附近
+    BENCH_PCB = 2,        // 类PCB分布: 大量小器件 + 少量芯片 + 几个覆盖大面积的铺铜平面
+};
+
+inline const char* getDistributionName(int aDist)
+{
+    switch (aDist)
+    {
+        case BENCH_UNIFORM:
+            return "uniform";
+        case BENCH_CLUSTERED:
+            return "clustered";
+        case BENCH_PCB:
+            return "pcb";
+        default:
+            return "unknown";
+    }
+}
+
+struct BenchRect
+{
+    double mMinX, mMinY, mMaxX, mMaxY;
+};
+
+inline BenchRect makeBenchRect(double x, double y, double w, double h)
+{
+    x = std::min(std::max(x, 0.0), BENCH_WORLD_SIZE - w);
+    y = std::min(std::max(y, 0.0), BENCH_WORLD_SIZE - h);
+    return BenchRect{x, y, x + w, y + h};
+}
+
+/**
+ * @brief 生成 aCount 个指定分布的矩形
+ * @param aDist 分布类型
+ * @param aCount 矩形数
+ * @param aSeed 随机种子
+ * @return std::vector<BenchRect> 矩形数组
+ */
+inline std::vector<BenchRect> generateRects(int aDist, int aCount, unsigned int aSeed = BENCH_SEED)
+{
+    std::mt19937 gen(aSeed);
+    std::uniform_real_distribution<double> pos(0.0, BENCH_WORLD_SIZE);
+    std::vector<BenchRect> rectArray;
+    rectArray.reserve(aCount);
+
+    switch (aDist)
+    {
+        case BENCH_UNIFORM:
+        {
+            std::uniform_real_distribution<double> len(10.0, 200.0);
+            for (int i = 0; i < aCount; ++i)
+            {
+                rectArray.push_back(makeBenchRect(pos(gen), pos(gen), len(gen), len(gen)));
+            }
+            break;
+        }
+        case BENCH_CLUSTERED:
+        {
+            const int nClusterNum = 32;
+            std::vector<std::pair<double, double>> centerArray;
+            for (int i = 0; i < nClusterNum; ++i)
+            {
+                centerArray.emplace_back(pos(gen), pos(gen));
+            }
+            std::uniform_int_distribution<int> cluster(0, nClusterNum - 1);
+            std::normal_distribution<double> offset(0.0, BENCH_WORLD_SIZE / 50);
+            std::uniform_real_distribution<double> len(10.0, 200.0);
+            for (int i = 0; i < aCount; ++i)
+            {
+                const auto& center = centerArray[cluster(gen)];
+                rectArray.push_back(
+                    makeBenchRect(center.first + offset(gen), center.second + offset(gen), len(gen), len(gen)));
+            }
+            break;
+        }
+        case BENCH_PCB:
+        {
+            // 几个覆盖大面积的铺铜平面
+            const int nPlaneNum = std::min(8, std::max(1, aCount / 1000));
+            std::uniform_real_distribution<double> planeLen(BENCH_WORLD_SIZE * 0.3, BENCH_WORLD_SIZE);
+            for (int i = 0; i < nPlaneNum; ++i)
+            {
+                rectArray.push_back(makeBenchRect(pos(gen), pos(gen), planeLen(gen), planeLen(gen)));
+            }
+            // 2% 芯片，其余为电阻电容等小器件
+            std::uniform_real_distribution<double> chipLen(500.0, 3000.0);
+            std::uniform_real_distribution<double> partLen(5.0, 80.0);
+            std::uniform_real_distribution<double> prob(0.0, 1.0);
+            for (int i = nPlaneNum; i < aCount; ++i)
+            {
+                if (prob(gen) < 0.02)
+                    rectArray.push_back(makeBenchRect(pos(gen), pos(gen), chipLen(gen), chipLen(gen)));
+                else
+                    rectArray.push_back(makeBenchRect(pos(gen), pos(gen), partLen(gen), partLen(gen)));
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return rectArray;
+}
+
+/**
+ * @brief 生成查询窗口: 窗口面积占世界面积的比例为 aSelectivity(为0时生成点查询)
+ * @param aCount 窗口数
+ * @param aSelectivity 窗口面积比例
+ * @param aSeed 随机种子
+ * @return std::vector<BenchRect> 查询窗口数组
+ */
+inline std::vector<BenchRect> generateWindows(int aCount, double aSelectivity, unsigned int aSeed = BENCH_SEED + 1)
+{
+    std::mt19937 gen(aSeed);
+    std::uniform_real_distribution<double> pos(0.0, BENCH_WORLD_SIZE);
+    double len = BENCH_WORLD_SIZE * sqrt(aSelectivity);
+    std::vector<BenchRect> windowArray;
+    windowArray.reserve(aCount);
+    for (int i = 0; i < aCount; ++i)
+    {
+        windowArray.push_back(makeBenchRect(pos(gen), pos(gen), len, len));
+    }
+    return windowArray;
+}
+
+// 查询窗口面积比例参数以百万分之一为单位传入(Google Benchmark参数只能为整数)
+inline double getSelectivity(long long aPpm)
+{
+    return (double)aPpm / 1e6;
+}
+
+}  // namespace TelosBench
+
+#endif  // BENCH_DATA_H
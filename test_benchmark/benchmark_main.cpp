@@ -1,3 +1,35 @@
 #include <benchmark/benchmark.h>
 
-BENCHMARK_MAIN();
\ No newline at end of file
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#define BENCH_DEFAULT_OUT "telos_benchmark.json"  // 默认的JSON结果文件
+
+// 未指定 --benchmark_out 时，默认将结果以JSON格式写入 BENCH_DEFAULT_OUT，便于跟踪性能回归
+int main(int argc, char** argv)
+{
+    std::vector<char*> argArray(argv, argv + argc);
+    bool bHasOut = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strncmp(argv[i], "--benchmark_out=", strlen("--benchmark_out=")))
+            bHasOut = true;
+    }
+    std::string outArg = "--benchmark_out=" BENCH_DEFAULT_OUT;
+    std::string formatArg = "--benchmark_out_format=json";
+    if (!bHasOut)
+    {
+        argArray.push_back(&outArg[0]);
+        argArray.push_back(&formatArg[0]);
+    }
+
+    int nArgNum = (int)argArray.size();
+    benchmark::Initialize(&nArgNum, argArray.data());
+    if (benchmark::ReportUnrecognizedArguments(nArgNum, argArray.data()))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
\ No newline at end of file
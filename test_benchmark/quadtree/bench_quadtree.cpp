@@ -0,0 +1,310 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+
+#include "Telos/quadtree/flat_quadtree.hpp"
+#include "Telos/quadtree/quadtree.hpp"
+#include "bench_data.h"
+
+using namespace TelosBench;
+
+namespace
+{
+
+#define QUADTREE_BENCH_QUERY_NUM 4096  // 每轮查询使用的窗口数
+#define QUADTREE_BENCH_REMOVE_NUM 256  // 每轮删除的元素数
+
+struct BenchElem
+{
+    BBox<double> mBox;
+};
+
+// 包围盒计算策略(函数对象，调用可内联)
+struct BenchElemBBox
+{
+    BBox<double> operator()(const BenchElem* elem) const { return elem->mBox; }
+};
+
+typedef QuadTree<const BenchElem*, double, BBoxFunc<const BenchElem*, double>> BenchQuadTree;  // std::function 回调
+typedef QuadTree<const BenchElem*, double, BenchElemBBox> BenchPolicyQuadTree;       // 函数对象策略
+typedef QuadTree<const BenchElem*, double, BenchElemBBox, true> BenchCacheQuadTree;  // 函数对象策略+缓存包围盒
+typedef FlatQuadTree<const BenchElem*, double, BenchElemBBox, true> BenchFlatQuadTree;  // 无指针四叉树
+
+std::vector<BenchElem> toElemArray(const std::vector<BenchRect>& rectArray)
+{
+    std::vector<BenchElem> result;
+    result.reserve(rectArray.size());
+    for (const auto& rect : rectArray)
+    {
+        result.push_back(BenchElem{BBox<double>(rect.mMinX, rect.mMinY, rect.mMaxX, rect.mMaxY)});
+    }
+    return result;
+}
+
+BenchQuadTree createTree()
+{
+    return BenchQuadTree(BBox<double>(0.0, 0.0, BENCH_WORLD_SIZE, BENCH_WORLD_SIZE),
+                         [](const BenchElem* elem) -> BBox<double> { return elem->mBox; });
+}
+
+template <typename TREE_T>
+TREE_T createPolicyTree()
+{
+    return TREE_T(BBox<double>(0.0, 0.0, BENCH_WORLD_SIZE, BENCH_WORLD_SIZE));
+}
+
+template <>
+BenchQuadTree createPolicyTree<BenchQuadTree>()
+{
+    return createTree();
+}
+
+template <typename TREE_T>
+void fillTree(TREE_T& tree, const std::vector<BenchElem>& elemArray)
+{
+    for (const auto& elem : elemArray)
+    {
+        tree.insert(&elem);
+    }
+}
+
+BBox<double> toBBox(const BenchRect& rect)
+{
+    return BBox<double>(rect.mMinX, rect.mMinY, rect.mMaxX, rect.mMaxY);
+}
+
+// 逐个插入: TREE_T 为包围盒策略不同的四叉树
+template <typename TREE_T>
+void BM_QuadTreeInsert(benchmark::State& state)
+{
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), (int)state.range(1)));
+    for (auto _ : state)
+    {
+        TREE_T tree = createPolicyTree<TREE_T>();
+        fillTree(tree, elemArray);
+        benchmark::DoNotOptimize(tree);
+    }
+    state.SetItemsProcessed(state.iterations() * elemArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 窗口查询: range(2) 为窗口面积比例(百万分之一)，0表示点查询
+template <typename TREE_T>
+void BM_QuadTreeQuery(benchmark::State& state)
+{
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(QUADTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    TREE_T tree = createPolicyTree<TREE_T>();
+    fillTree(tree, elemArray);
+
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        auto result = tree.query(toBBox(windowArray[nQueryIndex]));
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        nHitNum += result.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 查询结果追加到复用的容器中(不分配内存): range(2) 为窗口面积比例(百万分之一)
+void BM_QuadTreeQueryInto(benchmark::State& state)
+{
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(QUADTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    BenchCacheQuadTree tree = createPolicyTree<BenchCacheQuadTree>();
+    fillTree(tree, elemArray);
+
+    std::vector<const BenchElem*> result;
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        result.clear();
+        tree.query(toBBox(windowArray[nQueryIndex]), result);
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        nHitNum += result.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 统计窗口内的元素数量: range(2) 为窗口面积比例(百万分之一)
+void BM_QuadTreeCount(benchmark::State& state)
+{
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(QUADTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    BenchCacheQuadTree tree = createPolicyTree<BenchCacheQuadTree>();
+    fillTree(tree, elemArray);
+
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        nHitNum += tree.count(toBBox(windowArray[nQueryIndex]));
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+std::vector<const BenchElem*> toPtrArray(const std::vector<BenchElem>& elemArray)
+{
+    std::vector<const BenchElem*> result;
+    result.reserve(elemArray.size());
+    for (const auto& elem : elemArray)
+    {
+        result.push_back(&elem);
+    }
+    return result;
+}
+
+BenchFlatQuadTree createFlatTree(const std::vector<const BenchElem*>& ptrArray)
+{
+    return BenchFlatQuadTree(BBox<double>(0.0, 0.0, BENCH_WORLD_SIZE, BENCH_WORLD_SIZE), ptrArray);
+}
+
+// 无指针四叉树构建
+void BM_FlatQuadTreeBuild(benchmark::State& state)
+{
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<const BenchElem*> ptrArray = toPtrArray(elemArray);
+    for (auto _ : state)
+    {
+        BenchFlatQuadTree tree = createFlatTree(ptrArray);
+        benchmark::DoNotOptimize(tree);
+    }
+    state.SetItemsProcessed(state.iterations() * elemArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 无指针四叉树窗口查询: range(2) 为窗口面积比例(百万分之一)
+void BM_FlatQuadTreeQuery(benchmark::State& state)
+{
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(QUADTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    BenchFlatQuadTree tree = createFlatTree(toPtrArray(elemArray));
+
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        auto result = tree.query(toBBox(windowArray[nQueryIndex]));
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        nHitNum += result.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.counters["nodes"] = (double)tree.nodeCount();
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 删除: 每次迭代删除 QUADTREE_BENCH_REMOVE_NUM 个元素
+void BM_QuadTreeRemove(benchmark::State& state)
+{
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), (int)state.range(1)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        BenchQuadTree tree = createTree();
+        fillTree(tree, elemArray);
+        state.ResumeTiming();
+
+        for (size_t i = 0; i < QUADTREE_BENCH_REMOVE_NUM; ++i)
+        {
+            tree.remove(&elemArray[i * elemArray.size() / QUADTREE_BENCH_REMOVE_NUM]);
+        }
+
+        state.PauseTiming();  // 不统计析构时间
+        tree = BenchQuadTree();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * QUADTREE_BENCH_REMOVE_NUM);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 读写混合: 每次迭代执行1次插入和 range(2) 次窗口查询(窗口面积比例为万分之一)
+void BM_QuadTreeMixed(benchmark::State& state)
+{
+    int nCount = (int)state.range(1);
+    std::vector<BenchElem> elemArray = toElemArray(generateRects((int)state.range(0), nCount));
+    std::vector<BenchElem> insertArray = toElemArray(generateRects((int)state.range(0), nCount, BENCH_SEED + 2));
+    std::vector<BenchRect> windowArray = generateWindows(QUADTREE_BENCH_QUERY_NUM, 1e-4);
+    int nReadNum = (int)state.range(2);
+
+    BenchQuadTree tree;
+    size_t nInsertIndex = insertArray.size();
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        if (nInsertIndex == insertArray.size())  // 插入数据用完后重建树，保持树的规模稳定
+        {
+            state.PauseTiming();
+            tree = createTree();
+            fillTree(tree, elemArray);
+            nInsertIndex = 0;
+            state.ResumeTiming();
+        }
+        tree.insert(&insertArray[nInsertIndex++]);
+
+        for (int i = 0; i < nReadNum; ++i)
+        {
+            auto result = tree.query(toBBox(windowArray[nQueryIndex]));
+            nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (nReadNum + 1));
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_QuadTreeInsert, BenchQuadTree)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_QuadTreeInsert, BenchPolicyQuadTree)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_QuadTreeInsert, BenchCacheQuadTree)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_QuadTreeQuery, BenchQuadTree)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK_TEMPLATE(BM_QuadTreeQuery, BenchPolicyQuadTree)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK_TEMPLATE(BM_QuadTreeQuery, BenchCacheQuadTree)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK(BM_QuadTreeQueryInto)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK(BM_QuadTreeCount)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK(BM_FlatQuadTreeBuild)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FlatQuadTreeQuery)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK(BM_QuadTreeRemove)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_QuadTreeMixed)
+    ->ArgNames({"dist", "n", "reads"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {1, 10}});
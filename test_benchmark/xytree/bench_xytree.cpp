@@ -0,0 +1,585 @@
+#include <benchmark/benchmark.h>
+
+#include "Telos/xytree/collision_search.h"
+#include "Telos/xytree/xytree.h"
+#include "Telos/xytree/xytree.hpp"
+#include "Telos/xytree/xytree_compiled.h"
+#include "Telos/xytree/xytree_snapshot.h"
+#include "bench_data.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+using namespace Telos;
+using namespace TelosBench;
+
+namespace
+{
+
+#define XYTREE_BENCH_QUERY_NUM 4096  // 每轮查询使用的窗口数
+#define XYTREE_BENCH_DBU 10.0        // 整数坐标的数据库单位: 每个坐标单位对应的整数值
+
+std::vector<BoundRect2D> toBoundRectArray(const std::vector<BenchRect>& rectArray)
+{
+    std::vector<BoundRect2D> result;
+    result.reserve(rectArray.size());
+    for (const auto& rect : rectArray)
+    {
+        result.emplace_back(rect.mMinX, rect.mMinY, rect.mMaxX, rect.mMaxY);
+    }
+    return result;
+}
+
+// 逐个插入构建XYTree
+void fillTree(RXYTree& tree, const std::vector<BoundRect2D>& rectArray)
+{
+    tree.createTree(BENCH_WORLD_SIZE / 2, XYTREE_SPLIT_X);
+    for (size_t i = 0; i < rectArray.size(); ++i)
+    {
+        const BoundRect2D& rect = rectArray[i];
+        tree.addComponentArea(rect.getMinX(), rect.getMinY(), rect.getMaxX(), rect.getMaxY(), (int)(i % 8),
+                              (void*)(i + 1));
+    }
+}
+
+std::unique_ptr<RXYTree> buildTree(const std::vector<BoundRect2D>& rectArray)
+{
+    return std::unique_ptr<RXYTree>(new RXYTree(rectArray.data(), nullptr, (int)rectArray.size()));
+}
+
+// 逐个插入(插入时树叶原地分裂)
+void BM_XYTreeInsert(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    for (auto _ : state)
+    {
+        RXYTree tree;
+        fillTree(tree, rectArray);
+        benchmark::DoNotOptimize(tree.getRootNode());
+    }
+    state.SetItemsProcessed(state.iterations() * rectArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 批量构建
+void BM_XYTreeBulkLoad(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    for (auto _ : state)
+    {
+        RXYTree tree(rectArray.data(), nullptr, (int)rectArray.size());
+        benchmark::DoNotOptimize(tree.getRootNode());
+    }
+    state.SetItemsProcessed(state.iterations() * rectArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 对逐个插入(不分裂树叶)得到的未平衡树执行rebalance
+void BM_XYTreeRebalance(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        RXYTree tree;
+        tree.setLeafSplitFactor(0);
+        fillTree(tree, rectArray);
+        state.ResumeTiming();
+
+        tree.rebalance();
+        benchmark::DoNotOptimize(tree.getRootNode());
+
+        state.PauseTiming();  // 不统计析构时间
+        tree.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * rectArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 窗口查询: range(2) 为窗口面积比例(百万分之一)，0表示点查询
+void BM_XYTreeQuery(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(XYTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);
+
+    std::vector<ComponentArea*> resultArray;
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        const BenchRect& window = windowArray[nQueryIndex];
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        resultArray.clear();
+        nHitNum += tree->getCollideAreaArray(window.mMinX, window.mMinY, window.mMaxX, window.mMaxY, resultArray);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 编译形式的窗口查询: range(2) 为窗口面积比例(百万分之一)，range(3) 为1时使用紧凑模式
+void BM_XYTreeCompiledQuery(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(XYTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);
+    XYTreeCompiled compiled;
+    compiled.compile(*tree, state.range(3) != 0);
+
+    std::vector<ComponentArea*> resultArray;
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        const BenchRect& window = windowArray[nQueryIndex];
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        resultArray.clear();
+        nHitNum += compiled.getCollideAreaArray(window.mMinX, window.mMinY, window.mMaxX, window.mMaxY, resultArray);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.counters["nodeBytes"] = (double)compiled.getNodeBytes();
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 搜索盒分页取出窗口查询结果(每页 range(3) 个): range(2) 为窗口面积比例(百万分之一)
+void BM_XYTreeSearchBox(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(XYTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);
+    int nPageSize = (int)state.range(3);
+
+    RXYTreeSearchBox searchBox;
+    std::vector<ComponentArea*> pageArray;
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        const BenchRect& window = windowArray[nQueryIndex];
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        searchBox.begin(*tree, BoundRect2D(window.mMinX, window.mMinY, window.mMaxX, window.mMaxY));
+        while (!searchBox.isFinished())
+        {
+            pageArray.clear();
+            nHitNum += searchBox.next(nPageSize, pageArray);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 按类型过滤的窗口查询(40种类型，只查询其中1种): range(2) 为窗口面积比例(百万分之一)
+void BM_XYTreeQueryTyped(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(XYTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    std::vector<int> typeIdArray(rectArray.size());
+    for (size_t i = 0; i < typeIdArray.size(); ++i)
+    {
+        typeIdArray[i] = (int)(i % 40);
+    }
+    RXYTree tree(rectArray.data(), nullptr, (int)rectArray.size(), typeIdArray.data());
+
+    std::vector<ComponentArea*> resultArray;
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        const BenchRect& window = windowArray[nQueryIndex];
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        resultArray.clear();
+        nHitNum += tree.getCollideAreaArray(window.mMinX, window.mMinY, window.mMaxX, window.mMaxY, resultArray,
+                                            xyTreeTypeBit(7));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 打开快照并执行一次查询(与 BM_XYTreeBulkLoad 对比启动代价)
+void BM_XYTreeSnapshotOpen(benchmark::State& state)
+{
+    const char* pszFileName = "telos_bench_snapshot.bin";
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    XYTreeSnapshot::write(*buildTree(rectArray), pszFileName);
+
+    std::vector<int> slotArray;
+    for (auto _ : state)
+    {
+        XYTreeSnapshot snapshot;
+        snapshot.open(pszFileName);
+        slotArray.clear();
+        snapshot.getCollideAreaArray(0, 0, BENCH_WORLD_SIZE / 100, BENCH_WORLD_SIZE / 100, slotArray);
+        benchmark::DoNotOptimize(slotArray.data());
+    }
+    remove(pszFileName);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 快照上的窗口查询: range(2) 为窗口面积比例(百万分之一)
+void BM_XYTreeSnapshotQuery(benchmark::State& state)
+{
+    const char* pszFileName = "telos_bench_snapshot.bin";
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> windowArray = generateWindows(XYTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    XYTreeSnapshot::write(*buildTree(rectArray), pszFileName);
+    XYTreeSnapshot snapshot;
+    snapshot.open(pszFileName);
+
+    std::vector<int> slotArray;
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        const BenchRect& window = windowArray[nQueryIndex];
+        nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+        slotArray.clear();
+        nHitNum += snapshot.getCollideAreaArray(window.mMinX, window.mMinY, window.mMaxX, window.mMaxY, slotArray);
+    }
+    snapshot.close();
+    remove(pszFileName);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// k近邻查询: range(2) 为近邻数k
+void BM_XYTreeNearest(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BenchRect> pointArray = generateWindows(XYTREE_BENCH_QUERY_NUM, 0.0);
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);
+
+    std::vector<XYTreeNeighbor> resultArray;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        const BenchRect& point = pointArray[nQueryIndex];
+        nQueryIndex = (nQueryIndex + 1) % pointArray.size();
+        tree->getNearestAreaArray(BoundRect2D(point.mMinX, point.mMinY, point.mMaxX, point.mMaxY),
+                                  (int)state.range(2), resultArray);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 批量查询: 每次迭代执行 XYTREE_BENCH_QUERY_NUM 个窗口查询
+void BM_XYTreeQueryBatch(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BoundRect2D> windowArray =
+        toBoundRectArray(generateWindows(XYTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2))));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);
+
+    XYTreeBatchResult result;
+    for (auto _ : state)
+    {
+        tree->getCollideAreaBatch(windowArray.data(), (int)windowArray.size(), result);
+        benchmark::DoNotOptimize(result.mAreaArray.data());
+    }
+    state.SetItemsProcessed(state.iterations() * windowArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 读写混合: 每次迭代执行1次插入和 range(2) 次窗口查询(窗口面积比例为万分之一)
+void BM_XYTreeMixed(benchmark::State& state)
+{
+    int nCount = (int)state.range(1);
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), nCount));
+    std::vector<BoundRect2D> insertArray =
+        toBoundRectArray(generateRects((int)state.range(0), nCount, BENCH_SEED + 2));
+    std::vector<BenchRect> windowArray = generateWindows(XYTREE_BENCH_QUERY_NUM, 1e-4);
+    int nReadNum = (int)state.range(2);
+
+    std::unique_ptr<RXYTree> tree;
+    std::vector<ComponentArea*> resultArray;
+    size_t nInsertIndex = insertArray.size();
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        if (nInsertIndex == insertArray.size())  // 插入数据用完后重建树，保持树的规模稳定
+        {
+            state.PauseTiming();
+            tree = buildTree(rectArray);
+            nInsertIndex = 0;
+            state.ResumeTiming();
+        }
+        const BoundRect2D& rect = insertArray[nInsertIndex];
+        tree->addComponentArea(rect.getMinX(), rect.getMinY(), rect.getMaxX(), rect.getMaxY(), 0,
+                               (void*)(nCount + nInsertIndex + 1));
+        ++nInsertIndex;
+
+        for (int i = 0; i < nReadNum; ++i)
+        {
+            const BenchRect& window = windowArray[nQueryIndex];
+            nQueryIndex = (nQueryIndex + 1) % windowArray.size();
+            resultArray.clear();
+            tree->getCollideAreaArray(window.mMinX, window.mMinY, window.mMaxX, window.mMaxY, resultArray);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (nReadNum + 1));
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 删除: 每次迭代删除全部器件(按插入顺序)
+void BM_XYTreeDelete(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<XYTreeHandle> handleArray;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        RXYTree tree;
+        tree.createTree(BENCH_WORLD_SIZE / 2, XYTREE_SPLIT_X);
+        handleArray.clear();
+        for (const auto& rect : rectArray)
+        {
+            handleArray.push_back(
+                tree.addComponentArea(rect.getMinX(), rect.getMinY(), rect.getMaxX(), rect.getMaxY(), 0, nullptr));
+        }
+        state.ResumeTiming();
+
+        for (XYTreeHandle handle : handleArray)
+        {
+            tree.deleteComponentArea(handle);
+        }
+
+        state.PauseTiming();  // 不统计析构时间
+        tree.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * rectArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// ECO: 每次迭代删除 range(2) 个器件并重新插入相同的包围盒，range(3) 为1时在一次批量修改中完成
+void BM_XYTreeEco(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);  // 批量构建时第i个器件的句柄为i
+    std::vector<XYTreeHandle> handleArray(rectArray.size());
+    for (size_t i = 0; i < handleArray.size(); ++i)
+        handleArray[i] = (XYTreeHandle)i;
+
+    size_t nChangeNum = (size_t)state.range(2);
+    bool bBatch = state.range(3) != 0;
+    size_t nIndex = 0;
+    for (auto _ : state)
+    {
+        if (bBatch)
+            tree->beginBatch();
+        for (size_t i = 0; i < nChangeNum; ++i, nIndex = (nIndex + 1) % rectArray.size())
+        {
+            const BoundRect2D& rect = rectArray[nIndex];
+            tree->deleteComponentArea(handleArray[nIndex]);
+            handleArray[nIndex] =
+                tree->addComponentArea(rect.getMinX(), rect.getMinY(), rect.getMaxX(), rect.getMaxY(), 0, nullptr);
+        }
+        if (bBatch)
+            tree->commitBatch();
+    }
+    state.SetItemsProcessed(state.iterations() * nChangeNum * 2);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 拖动器件: 每次迭代将一个器件移动 range(2) 个单位(小位移通常仍落在原树叶)
+void BM_XYTreeUpdate(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);  // 批量构建时第i个器件的句柄为i
+
+    double dist = (double)state.range(2);
+    size_t nIndex = 0;
+    double sign = 1.0;
+    for (auto _ : state)
+    {
+        XYTreeHandle handle = (XYTreeHandle)nIndex;
+        const BoundRect2D* rect = tree->getComponentArea(handle)->getBoundRect();
+        tree->updateComponentArea(handle, rect->getMinX() + sign * dist, rect->getMinY() + sign * dist,
+                                  rect->getMaxX() + sign * dist, rect->getMaxY() + sign * dist);
+        if (++nIndex == rectArray.size())  // 往返移动，保持数据分布稳定
+        {
+            nIndex = 0;
+            sign = -sign;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 自连接: 找出全部相交的器件对，range(2) 为线程数(1时串行)
+void BM_XYTreeSelfJoin(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);
+    int nThreadNum = (int)state.range(2);
+    if (nThreadNum > 1)
+    {
+        tree->setThreadNum(nThreadNum);
+        tree->freeze();
+    }
+
+    std::atomic<long long> nPairNum{0};
+    for (auto _ : state)
+    {
+        nPairNum = 0;
+        if (nThreadNum > 1)
+            tree->selfJoinParallel([&](ComponentArea*, ComponentArea*)
+                                   { nPairNum.fetch_add(1, std::memory_order_relaxed); });
+        else
+            tree->selfJoin([&](ComponentArea*, ComponentArea*) { nPairNum.fetch_add(1, std::memory_order_relaxed); });
+    }
+    state.counters["pairs"] = (double)nPairNum.load();
+    state.SetItemsProcessed(state.iterations() * rectArray.size());
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 两棵树的空间连接(两层器件各 range(1) 个)，range(2) 为线程数(1时串行)
+void BM_XYTreeJoin(benchmark::State& state)
+{
+    std::vector<BoundRect2D> rectArray = toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1)));
+    std::vector<BoundRect2D> otherRectArray =
+        toBoundRectArray(generateRects((int)state.range(0), (int)state.range(1), BENCH_SEED + 3));
+    std::unique_ptr<RXYTree> tree = buildTree(rectArray);
+    std::unique_ptr<RXYTree> otherTree = buildTree(otherRectArray);
+    int nThreadNum = (int)state.range(2);
+    if (nThreadNum > 1)
+    {
+        tree->setThreadNum(nThreadNum);
+        tree->freeze();
+        otherTree->freeze();
+    }
+
+    std::atomic<long long> nPairNum{0};
+    for (auto _ : state)
+    {
+        nPairNum = 0;
+        auto callback = [&](ComponentArea*, ComponentArea*) { nPairNum.fetch_add(1, std::memory_order_relaxed); };
+        if (nThreadNum > 1)
+            tree->joinParallel(*otherTree, callback);
+        else
+            tree->join(*otherTree, callback);
+    }
+    state.counters["pairs"] = (double)nPairNum.load();
+    state.SetItemsProcessed(state.iterations() * (rectArray.size() + otherRectArray.size()));
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+// 将浮点矩形转换为模板XYTree的矩形(整数坐标按数据库单位取整)
+template <typename Coord>
+XYTreeRect<Coord> toTemplateRect(const BenchRect& rect)
+{
+    double fScale = std::is_integral<Coord>::value ? XYTREE_BENCH_DBU : 1.0;
+    return XYTreeRect<Coord>{(Coord)(rect.mMinX * fScale), (Coord)(rect.mMinY * fScale), (Coord)(rect.mMaxX * fScale),
+                             (Coord)(rect.mMaxY * fScale)};
+}
+
+// 模板XYTree的窗口查询(负载为int): range(2) 为窗口面积比例(百万分之一)
+template <typename Coord>
+void BM_XYTreeTemplateQuery(benchmark::State& state)
+{
+    std::vector<BenchRect> rectArray = generateRects((int)state.range(0), (int)state.range(1));
+    std::vector<BenchRect> windowArray = generateWindows(XYTREE_BENCH_QUERY_NUM, getSelectivity(state.range(2)));
+    std::vector<typename XYTree<Coord, int>::Entry> entryArray;
+    entryArray.reserve(rectArray.size());
+    for (size_t i = 0; i < rectArray.size(); ++i)
+    {
+        entryArray.push_back({toTemplateRect<Coord>(rectArray[i]), (int)i});
+    }
+    std::vector<XYTreeRect<Coord>> queryArray;
+    for (const BenchRect& window : windowArray)
+    {
+        queryArray.push_back(toTemplateRect<Coord>(window));
+    }
+    XYTree<Coord, int> tree(std::move(entryArray));
+
+    std::vector<int> resultArray;
+    size_t nHitNum = 0;
+    size_t nQueryIndex = 0;
+    for (auto _ : state)
+    {
+        const XYTreeRect<Coord>& window = queryArray[nQueryIndex];
+        nQueryIndex = (nQueryIndex + 1) % queryArray.size();
+        resultArray.clear();
+        nHitNum += tree.query(window, resultArray);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["hits"] = benchmark::Counter((double)nHitNum, benchmark::Counter::kAvgIterations);
+    state.SetLabel(getDistributionName((int)state.range(0)));
+}
+
+}  // namespace
+
+BENCHMARK(BM_XYTreeInsert)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_XYTreeBulkLoad)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_XYTreeRebalance)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_XYTreeQuery)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK(BM_XYTreeCompiledQuery)
+    ->ArgNames({"dist", "n", "ppm", "compact"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}, {0, 1}});
+BENCHMARK(BM_XYTreeSearchBox)
+    ->ArgNames({"dist", "n", "ppm", "page"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {100, 1000}, {16, 256}});
+BENCHMARK(BM_XYTreeQueryTyped)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {100, 1000}});
+BENCHMARK(BM_XYTreeSnapshotOpen)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_XYTreeSnapshotQuery)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK(BM_XYTreeNearest)
+    ->ArgNames({"dist", "n", "k"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {1, 10, 100}});
+BENCHMARK(BM_XYTreeQueryBatch)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 100}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_XYTreeMixed)
+    ->ArgNames({"dist", "n", "reads"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {1, 10}});
+BENCHMARK(BM_XYTreeDelete)
+    ->ArgNames({"dist", "n"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {10000, 100000}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_XYTreeEco)
+    ->ArgNames({"dist", "n", "change", "batch"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {1000, 10000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_XYTreeUpdate)
+    ->ArgNames({"dist", "n", "move"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {1, 1000}});
+BENCHMARK(BM_XYTreeSelfJoin)
+    ->ArgNames({"dist", "n", "threads"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_XYTreeJoin)
+    ->ArgNames({"dist", "n", "threads"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_XYTreeTemplateQuery, int32_t)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
+BENCHMARK_TEMPLATE(BM_XYTreeTemplateQuery, double)
+    ->ArgNames({"dist", "n", "ppm"})
+    ->ArgsProduct({{BENCH_UNIFORM, BENCH_CLUSTERED, BENCH_PCB}, {100000}, {0, 10, 100, 1000}});
@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 
+#include "Telos/quadtree/flat_quadtree.hpp"
 #include "Telos/quadtree/quadtree.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <random>
+
 struct MyStruct
 {
     int val;
@@ -17,10 +22,16 @@ struct MyStruct
     }
 };
 
+// 包围盒计算策略(函数对象)
+struct MyStructBBox
+{
+    BBox<double> operator()(const MyStruct* self) const { return self->_box; }
+};
+
 class QuadTreeTest : public ::testing::Test
 {
    protected:
-    QuadTree<MyStruct*, double> quadTree;
+    QuadTree<MyStruct*, double, BBoxFunc<MyStruct*, double>> quadTree;
     void SetUp() override
     {
         MyStruct ori = {0, {-100, -100, 100, 100}};
@@ -142,4 +153,297 @@ TEST_F(QuadTreeTest, query2)
     MyStruct range3 = {1, {0, 0, 0, 0}};
     auto ret3 = quadTree.query(range3._box);
     EXPECT_EQ(ret3.size(), 1);
-}
\ No newline at end of file
+}
+
+TEST(QuadTreePolicyTest, query)
+{
+    std::vector<MyStruct> elems = {{1, {-80, 40, -40, 60}}, {2, {-80, -80, -40, -20}}, {3, {40, -60, 60, -40}},
+                                   {4, {40, 30, 70, 60}},   {5, {-20, -20, 20, 20}},   {6, {10, 80, 20, 90}},
+                                   {7, {10, 55, 15, 65}},   {8, {35, 70, 40, 80}},     {9, {20, 70, 30, 80}},
+                                   {10, {20, 70, 30, 80}},  {11, {20, 70, 30, 80}},    {12, {20, 70, 30, 80}},
+                                   {13, {20, 70, 30, 80}}};
+
+    // 缓存包围盒后查询不再调用策略: 调用次数只与插入的元素数有关
+    int callCount = 0;
+    auto countBBox = [&callCount](MyStruct* self) -> BBox<double>
+    {
+        ++callCount;
+        return self->_box;
+    };
+    BBox<double> world(-100, -100, 100, 100);
+    QuadTree<MyStruct*, double, MyStructBBox> policyTree(world);
+    QuadTree<MyStruct*, double, MyStructBBox, true> cacheTree(world);
+    QuadTree<MyStruct*, double, decltype(countBBox), true> countTree(world, countBBox);
+    for (auto& e : elems)
+    {
+        EXPECT_EQ(0, policyTree.insert(&e));
+        EXPECT_EQ(0, cacheTree.insert(&e));
+        EXPECT_EQ(0, countTree.insert(&e));
+    }
+    EXPECT_EQ((int)elems.size(), callCount);
+
+    const std::vector<std::pair<BBox<double>, size_t>> ranges = {
+        {{-80, -80, 80, 80}, 13}, {{0, 0, 100, 100}, 10}, {{0, 0, 0, 0}, 1}};
+    for (const auto& range : ranges)
+    {
+        EXPECT_EQ(range.second, policyTree.query(range.first).size());
+        EXPECT_EQ(range.second, cacheTree.query(range.first).size());
+        EXPECT_EQ(range.second, countTree.query(range.first).size());
+    }
+    EXPECT_EQ((int)elems.size(), callCount);
+
+    cacheTree.remove(&elems[4]);
+    EXPECT_EQ(0u, cacheTree.query(BBox<double>(0, 0, 0, 0)).size());
+}
+
+// 提供 bbox() 成员函数的元素，使用默认的包围盒计算策略
+struct MemberBBoxElem
+{
+    int val;
+    BBox<double> box;
+    BBox<double> bbox() const { return box; }
+};
+
+TEST(QuadTreePolicyTest, defaultPolicy)
+{
+    // 无状态的策略不占用节点空间: 节点只有三个数组和包围盒
+    typedef QuadTree<MyStruct*, double, MyStructBBox> PolicyTree;
+    static_assert(sizeof(PolicyTree) == 3 * sizeof(std::vector<int>) + sizeof(BBox<double>),
+                  "stateless bbox policy must not take node space");
+    static_assert(sizeof(QuadTree<MemberBBoxElem*>) == sizeof(PolicyTree), "default bbox policy must be stateless");
+
+    std::vector<MemberBBoxElem> elems;
+    for (int i = 0; i < 100; ++i)
+        elems.push_back({i, BBox<double>(i - 50, i - 50, i - 49, i - 49)});
+    QuadTree<MemberBBoxElem*> tree(BBox<double>(-100, -100, 100, 100));
+    std::vector<MemberBBoxElem*> ptrs;
+    for (auto& e : elems)
+    {
+        EXPECT_EQ(0, tree.insert(&e));
+        ptrs.push_back(&e);
+    }
+    EXPECT_EQ(12u, tree.query(BBox<double>(-5, -5, 5, 5)).size());
+
+    FlatQuadTree<MemberBBoxElem*> flatTree(BBox<double>(-100, -100, 100, 100), ptrs);
+    EXPECT_EQ(12u, flatTree.query(BBox<double>(-5, -5, 5, 5)).size());
+}
+
+TEST(FlatQuadTreeTest, query)
+{
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> pos(-100.0, 90.0);
+    std::uniform_real_distribution<double> len(0.1, 10.0);
+    std::vector<MyStruct> elems;
+    for (int i = 0; i < 2000; ++i)
+    {
+        double x = pos(gen), y = pos(gen);
+        elems.push_back({i, {x, y, x + len(gen), y + len(gen)}});
+    }
+    elems.push_back({-1, {-200, -200, -150, -150}});  // 超出范围，构建时被忽略
+    std::vector<MyStruct*> ptrs;
+    for (auto& e : elems)
+        ptrs.push_back(&e);
+
+    BBox<double> world(-100, -100, 100, 100);
+    FlatQuadTree<MyStruct*, double, MyStructBBox> flatTree(world, ptrs);
+    FlatQuadTree<MyStruct*, double, MyStructBBox, true> cacheTree(world, ptrs);
+    EXPECT_EQ(elems.size() - 1, flatTree.size());
+    EXPECT_GT(flatTree.nodeCount(), 1u);
+
+    std::uniform_real_distribution<double> win(-110.0, 100.0);
+    for (int q = 0; q < 200; ++q)
+    {
+        double x = win(gen), y = win(gen);
+        BBox<double> range(x, y, x + 15.0, y + 15.0);
+        std::vector<int> expect, result, cacheResult;
+        for (size_t i = 0; i + 1 < elems.size(); ++i)
+        {
+            if (range.intersects(elems[i]._box))
+                expect.push_back(elems[i].val);
+        }
+        for (MyStruct* e : flatTree.query(range))
+            result.push_back(e->val);
+        for (MyStruct* e : cacheTree.query(range))
+            cacheResult.push_back(e->val);
+        std::sort(result.begin(), result.end());
+        std::sort(cacheResult.begin(), cacheResult.end());
+        EXPECT_EQ(expect, result);
+        EXPECT_EQ(expect, cacheResult);
+    }
+}
+
+TEST(FlatQuadTreeTest, visitAndCount)
+{
+    std::mt19937 gen(67890);
+    std::uniform_real_distribution<double> pos(-100.0, 90.0);
+    std::uniform_real_distribution<double> len(0.1, 10.0);
+    std::vector<MyStruct> elems;
+    for (int i = 0; i < 2000; ++i)
+    {
+        double x = pos(gen), y = pos(gen);
+        elems.push_back({i, {x, y, x + len(gen), y + len(gen)}});
+    }
+    std::vector<MyStruct*> ptrs;
+    for (auto& e : elems)
+        ptrs.push_back(&e);
+    FlatQuadTree<MyStruct*, double, MyStructBBox> tree(BBox<double>(-100, -100, 100, 100), ptrs);
+
+    std::uniform_real_distribution<double> win(-110.0, 100.0);
+    for (int q = 0; q < 200; ++q)
+    {
+        double x = win(gen), y = win(gen);
+        BBox<double> range(x, y, x + 15.0, y + 15.0);
+        std::vector<int> expect;
+        for (const auto& e : elems)
+        {
+            if (range.intersects(e._box))
+                expect.push_back(e.val);
+        }
+        EXPECT_EQ(expect.size(), tree.count(range));
+
+        // 输出迭代器与追加到容器的结果一致
+        std::vector<MyStruct*> iterResult, appendResult = {nullptr};
+        tree.query(range, std::back_inserter(iterResult));
+        tree.query(range, appendResult);
+        ASSERT_EQ(iterResult.size() + 1, appendResult.size());
+        EXPECT_TRUE(std::equal(iterResult.begin(), iterResult.end(), appendResult.begin() + 1));
+
+        std::vector<int> result;
+        for (MyStruct* e : iterResult)
+            result.push_back(e->val);
+        std::sort(result.begin(), result.end());
+        EXPECT_EQ(expect, result);
+
+        // 访问函数提前停止
+        size_t visitNum = 0;
+        bool finished = tree.visit(range, [&visitNum](MyStruct*) { return ++visitNum < 3; });
+        EXPECT_EQ(expect.size() < 3, finished);
+        EXPECT_EQ(std::min<size_t>(expect.size(), 3), visitNum);
+    }
+}
+
+TEST(QuadTreePolicyTest, visitAndCount)
+{
+    std::mt19937 gen(54321);
+    std::uniform_real_distribution<double> pos(-100.0, 90.0);
+    std::uniform_real_distribution<double> len(0.1, 10.0);
+    std::vector<MyStruct> elems;
+    for (int i = 0; i < 2000; ++i)
+    {
+        double x = pos(gen), y = pos(gen);
+        elems.push_back({i, {x, y, x + len(gen), y + len(gen)}});
+    }
+    QuadTree<MyStruct*, double, MyStructBBox, true> tree(BBox<double>(-100, -100, 100, 100));
+    for (auto& e : elems)
+        EXPECT_EQ(0, tree.insert(&e));
+
+    std::uniform_real_distribution<double> win(-110.0, 100.0);
+    for (int q = 0; q < 200; ++q)
+    {
+        double x = win(gen), y = win(gen);
+        BBox<double> range(x, y, x + 15.0, y + 15.0);
+        std::vector<int> expect;
+        for (const auto& e : elems)
+        {
+            if (range.intersects(e._box))
+                expect.push_back(e.val);
+        }
+        EXPECT_EQ(expect.size(), tree.count(range));
+
+        // 输出迭代器与追加到容器的结果一致
+        std::vector<MyStruct*> iterResult, appendResult = {nullptr};
+        tree.query(range, std::back_inserter(iterResult));
+        tree.query(range, appendResult);
+        ASSERT_EQ(iterResult.size() + 1, appendResult.size());
+        EXPECT_TRUE(std::equal(iterResult.begin(), iterResult.end(), appendResult.begin() + 1));
+
+        std::vector<int> result;
+        for (MyStruct* e : iterResult)
+            result.push_back(e->val);
+        std::sort(result.begin(), result.end());
+        EXPECT_EQ(expect, result);
+
+        // 访问函数提前停止
+        size_t visitNum = 0;
+        bool finished = tree.visit(range, [&visitNum](MyStruct*) { return ++visitNum < 3; });
+        EXPECT_EQ(expect.size() < 3, finished);
+        EXPECT_EQ(std::min<size_t>(expect.size(), 3), visitNum);
+    }
+}
+
+// 整数坐标的元素
+struct IntStruct
+{
+    int val;
+    BBox<int> _box;
+};
+
+struct IntStructBBox
+{
+    BBox<int> operator()(const IntStruct* self) const { return self->_box; }
+};
+
+TEST(QuadTreePolicyTest, integerCoord)
+{
+    // 整数坐标: 子节点包围盒不按 G_EP 放大，边界接触视为相交
+    std::vector<IntStruct> elems;
+    for (int i = 0; i < 400; ++i)
+    {
+        int x = (i * 37) % 190 - 100, y = (i * 53) % 190 - 100;
+        elems.push_back({i, BBox<int>(x, y, x + i % 10, y + i % 7)});
+    }
+    QuadTree<IntStruct*, int, IntStructBBox, true> tree(BBox<int>(-100, -100, 100, 100));
+    for (auto& e : elems)
+        EXPECT_EQ(0, tree.insert(&e));
+
+    for (int x = -100; x < 100; x += 13)
+    {
+        BBox<int> range(x, -x, x + 20, -x + 20);
+        size_t expect = 0;
+        for (const auto& e : elems)
+            expect += range.intersects(e._box) ? 1 : 0;
+        EXPECT_EQ(expect, tree.count(range));
+    }
+}
+
+// 没有默认构造函数的元素
+struct NoDefaultElem
+{
+    int val;
+    BBox<int> box;
+    NoDefaultElem(int v, const BBox<int>& b) : val(v), box(b) {}
+};
+
+struct NoDefaultElemBBox
+{
+    BBox<int> operator()(const NoDefaultElem& self) const { return self.box; }
+};
+
+TEST(FlatQuadTreeTest, noDefaultElem)
+{
+    static_assert(std::is_default_constructible<NoDefaultElem>::value == false, "element must not be default ctor");
+    std::vector<NoDefaultElem> elems;
+    for (int i = 0; i < 500; ++i)
+    {
+        int x = (i * 37) % 190 - 100, y = (i * 53) % 190 - 100;
+        elems.emplace_back(i, BBox<int>(x, y, x + i % 10, y + i % 7));
+    }
+    FlatQuadTree<NoDefaultElem, int, NoDefaultElemBBox> tree(BBox<int>(-100, -100, 100, 100), elems);
+    EXPECT_EQ(elems.size(), tree.size());
+    EXPECT_GT(tree.nodeCount(), 1u);
+
+    for (int x = -100; x < 100; x += 13)
+    {
+        BBox<int> range(x, -x, x + 20, -x + 20);
+        std::vector<int> expect, result;
+        for (const auto& e : elems)
+        {
+            if (range.intersects(e.box))
+                expect.push_back(e.val);
+        }
+        for (const auto& e : tree.query(range))
+            result.push_back(e.val);
+        std::sort(result.begin(), result.end());
+        EXPECT_EQ(expect, result);
+    }
+}
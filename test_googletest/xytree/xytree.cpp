@@ -2,4 +2,1582 @@
 
 #include "Telos/xytree/bound_rect2d.h"
 #include "Telos/xytree/xytree.h"
+#include "Telos/xytree/xytree.hpp"
+#include "Telos/xytree/xytree_compiled.h"
+#include "Telos/xytree/xytree_snapshot.h"
 #include "Telos/xytree/collision_search.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace Telos;
+
+class XYTreeTest : public ::testing::Test
+{
+   protected:
+    std::vector<BoundRect2D> rects;
+
+    // 生成随机分布的器件包围盒
+    void SetUp() override
+    {
+        std::mt19937 gen(12345);
+        std::uniform_real_distribution<double> pos(0.0, 1000.0);
+        std::uniform_real_distribution<double> len(0.5, 20.0);
+        for (int i = 0; i < 2000; ++i)
+        {
+            double x = pos(gen), y = pos(gen);
+            rects.emplace_back(x, y, x + len(gen), y + len(gen));
+        }
+    }
+
+    void TearDown() override {}
+
+    void fillTree(RXYTree& tree)
+    {
+        tree.createTree(500.0, XYTREE_SPLIT_X);
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            tree.addComponentArea(rects[i].getMinX(), rects[i].getMinY(), rects[i].getMaxX(), rects[i].getMaxY(),
+                                  (int)(i % 8), (void*)(i + 1));
+        }
+    }
+
+    // 暴力查找与窗口相交的器件
+    std::vector<void*> bruteForce(const BoundRect2D& window) const
+    {
+        std::vector<void*> result;
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            if (!window.isDisjoint(&rects[i]))
+                result.push_back((void*)(i + 1));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    static std::vector<void*> toAddrArray(const std::vector<ComponentArea*>& areaArray)
+    {
+        std::vector<void*> result;
+        for (auto* area : areaArray)
+        {
+            result.push_back(area->getAddr());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+TEST_F(XYTreeTest, memPool)
+{
+    XYTreeMemPool pool;
+    void* p1 = pool.allocate(40);
+    void* p2 = pool.allocate(40);
+    EXPECT_NE(p1, p2);
+    EXPECT_EQ(0u, (size_t)p1 % XY_MEMPOOL_ALIGN);
+
+    // 归还后同档位的内存被复用
+    pool.deallocate(p1, 40);
+    EXPECT_EQ(p1, pool.allocate(48));
+
+    // 超大对象单独申请内存块
+    void* big = pool.allocate(XY_MEMPOOL_BLOCK_SIZE * 2);
+    EXPECT_NE(nullptr, big);
+    EXPECT_GE(pool.getBlockBytes(), (size_t)XY_MEMPOOL_BLOCK_SIZE * 3);
+
+    // 接管的子内存池继续可用，并随父内存池一起释放
+    XYTreeMemPool* childPool = new XYTreeMemPool();
+    void* p3 = childPool->allocate(64);
+    size_t nBytes = pool.getBlockBytes();
+    pool.adopt(childPool);
+    EXPECT_EQ(nBytes + XY_MEMPOOL_BLOCK_SIZE, pool.getBlockBytes());
+    childPool->deallocate(p3, 64);
+
+    pool.release();
+    EXPECT_EQ(0u, pool.getBlockBytes());
+}
+
+TEST_F(XYTreeTest, query)
+{
+    RXYTree tree;
+    fillTree(tree);
+
+    BoundRect2D window(100, 100, 300, 250);
+    EXPECT_EQ(bruteForce(window), toAddrArray(tree.getCollideAreaArray(100, 100, 300, 250)));
+
+    EXPECT_TRUE(tree.rebalance());
+    EXPECT_EQ(bruteForce(window), toAddrArray(tree.getCollideAreaArray(100, 100, 300, 250)));
+
+    EXPECT_EQ(rects.size(), tree.getCollideAreaArray(-1, -1, 2000, 2000).size());
+
+    tree.clear();
+    tree.createTree(0.0);
+    EXPECT_TRUE(tree.getCollideAreaArray(-1, -1, 2000, 2000).empty());
+}
+
+TEST_F(XYTreeTest, bulkLoad)
+{
+    std::vector<void*> addrArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        addrArray.push_back((void*)(i + 1));
+    }
+    RXYTree tree(rects.data(), addrArray.data(), (int)rects.size());
+
+    const BoundRect2D windows[] = {{100, 100, 300, 250}, {0, 0, 5, 5}, {-10, -10, 2000, 2000}, {500, 500, 500, 500}};
+    for (const BoundRect2D& window : windows)
+    {
+        EXPECT_EQ(bruteForce(window), toAddrArray(tree.getCollideAreaArray(window.getMinX(), window.getMinY(),
+                                                                           window.getMaxX(), window.getMaxY())));
+    }
+
+    // 器件数量不足以分割时，全部存放在根节点的树叶中
+    EXPECT_FALSE(tree.bulkLoad(rects.data(), addrArray.data(), 3));
+    EXPECT_EQ(3u, tree.getCollideAreaArray(-10, -10, 2000, 2000).size());
+    EXPECT_FALSE(tree.bulkLoad(nullptr, nullptr, 0));
+    EXPECT_TRUE(tree.getCollideAreaArray(-10, -10, 2000, 2000).empty());
+}
+
+TEST_F(XYTreeTest, parallelRebalance)
+{
+    RXYTree serialTree;
+    fillTree(serialTree);
+    serialTree.rebalance();
+
+    RXYTree tree;
+    tree.setThreadNum(4);
+    tree.setParallelCutoff(64);
+    EXPECT_EQ(4, tree.getThreadNum());
+    fillTree(tree);
+    EXPECT_TRUE(tree.rebalance());
+
+    const BoundRect2D windows[] = {{100, 100, 300, 250}, {0, 0, 5, 5}, {-10, -10, 2000, 2000}, {700, 20, 980, 400}};
+    for (const BoundRect2D& window : windows)
+    {
+        auto expected = bruteForce(window);
+        EXPECT_EQ(expected, toAddrArray(tree.getCollideAreaArray(window.getMinX(), window.getMinY(),
+                                                                 window.getMaxX(), window.getMaxY())));
+        EXPECT_EQ(expected, toAddrArray(serialTree.getCollideAreaArray(window.getMinX(), window.getMinY(),
+                                                                       window.getMaxX(), window.getMaxY())));
+    }
+
+    // 反复并行重建时，上次构建接管的子内存池随旧树一起释放，内存不随重建次数增长
+    size_t nMemBytes = tree.getMemoryBytes();
+    const ComponentArea* firstArea = tree.getComponentArea(0);
+    tree.beginBatch();
+    XYTreeHandle handle = tree.addComponentArea(2000, 2000, 2010, 2010, 0, (void*)(rects.size() + 1));
+    const ComponentArea* batchArea = tree.getComponentArea(handle);
+    for (int i = 0; i < 20; ++i)
+    {
+        EXPECT_TRUE(tree.rebalance());
+    }
+    EXPECT_LE(tree.getMemoryBytes(), nMemBytes * 3 / 2);
+    EXPECT_TRUE(tree.commitBatch());
+
+    // 重建后句柄和 ComponentArea* 仍然有效
+    EXPECT_EQ(firstArea, tree.getComponentArea(0));
+    EXPECT_EQ(batchArea, tree.getComponentArea(handle));
+    EXPECT_EQ((void*)(rects.size() + 1), tree.getComponentArea(handle)->getAddr());
+    EXPECT_EQ((void*)1, tree.getComponentArea(0)->getAddr());
+    EXPECT_TRUE(tree.deleteComponentArea(0));
+    EXPECT_EQ(1u, tree.getCollideAreaArray(2000, 2000, 2010, 2010).size());
+    auto expected = bruteForce({-10, -10, 2000, 2000});
+    expected.erase(expected.begin());
+    expected.push_back((void*)(rects.size() + 1));
+    EXPECT_EQ(expected, toAddrArray(tree.getCollideAreaArray(-10, -10, 2000, 2000)));
+
+    tree.setThreadNum(1);
+    EXPECT_EQ(1, tree.getThreadNum());
+}
+
+// 递归统计树中树叶的最大area数
+static int getMaxLeafAreaNum(const XYTreeNode* node)
+{
+    int nMax = 0;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        XYTreeChildType childType = (XYTreeChildType)i;
+        if (node->isChildAreaArray(childType))
+        {
+            const XYTreeLeaf* leaf = node->getChildLeaf(childType);
+            if (leaf)
+                nMax = std::max(nMax, (int)leaf->getAreaArray().size());
+        }
+        else
+        {
+            nMax = std::max(nMax, getMaxLeafAreaNum(node->getChildNode(childType)));
+        }
+    }
+    return nMax;
+}
+
+TEST_F(XYTreeTest, incrementalSplit)
+{
+    RXYTree tree;
+    fillTree(tree);  // 未调用rebalance，插入过程中超限的树叶被原地分裂
+    EXPECT_LE(getMaxLeafAreaNum(tree.getRootNode()), XY_THRESHOLD * XY_LEAF_SPLIT_FACTOR * 2);
+
+    BoundRect2D window(100, 100, 300, 250);
+    EXPECT_EQ(bruteForce(window), toAddrArray(tree.getCollideAreaArray(100, 100, 300, 250)));
+
+    RXYTree noSplitTree;
+    noSplitTree.setLeafSplitFactor(0);
+    fillTree(noSplitTree);
+    EXPECT_GT(getMaxLeafAreaNum(noSplitTree.getRootNode()), XY_THRESHOLD * XY_LEAF_SPLIT_FACTOR * 2);
+}
+
+// 检查每个节点的包围盒和类型掩码是否恰好为子树的并集
+static void checkNodeBound(const XYTreeNode* node)
+{
+    BoundRect2D bound;
+    XYTreeTypeMask typeMask = 0;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        XYTreeChildType childType = (XYTreeChildType)i;
+        if (node->isChildAreaArray(childType))
+        {
+            const XYTreeLeaf* leaf = node->getChildLeaf(childType);
+            if (nullptr == leaf)
+                continue;
+            ASSERT_FALSE(leaf->getAreaArray().empty());
+            bound.expandBound(leaf->getBoundRect());
+            typeMask |= leaf->getTypeMask();
+        }
+        else
+        {
+            const XYTreeNode* child = node->getChildNode(childType);
+            checkNodeBound(child);
+            if (child->getBoundRect()->isValid())
+                bound.expandBound(child->getBoundRect());
+            typeMask |= child->getTypeMask();
+        }
+    }
+    EXPECT_EQ(bound.isValid(), node->getBoundRect()->isValid());
+    if (bound.isValid())
+    {
+        EXPECT_TRUE(bound.isEqual(node->getBoundRect()));
+    }
+    EXPECT_EQ(typeMask, node->getTypeMask());
+}
+
+TEST(XYTreeDeepTest, sortedInsert)
+{
+    // 按X坐标递增逐个插入: 过深时重建失衡子树，树高保持对数级
+    for (int nCount : {20000, 80000})
+    {
+        RXYTree tree;
+        tree.createTree(0.0, XYTREE_SPLIT_X);
+        std::vector<XYTreeHandle> handleArray;
+        for (int i = 0; i < nCount; ++i)
+        {
+            handleArray.push_back(tree.addComponentArea(i, (i * 7) % 100, i + 0.5, (i * 7) % 100 + 0.5, i % 8,
+                                                        (void*)(size_t)(i + 1)));
+        }
+        int nDepth = tree.getRootNode()->getHeight();
+        EXPECT_LE(nDepth, XYTreeNode::getHeightLimit(nCount, XY_REBUILD_DEPTH_FACTOR));
+        EXPECT_LT(nDepth, XY_SEARCH_STACK_SIZE);
+        checkNodeBound(tree.getRootNode());
+
+        EXPECT_EQ((size_t)nCount, tree.getCollideAreaArray(-1, -1, nCount + 1, 200).size());
+        EXPECT_EQ(3u, tree.getCollideAreaArray(nCount / 2, -1, nCount / 2 + 2, 200).size());
+
+        // 重建后句柄目录仍然正确
+        for (int i = 0; i < nCount; i += 7)
+        {
+            EXPECT_TRUE(tree.deleteComponentArea(handleArray[i]));
+        }
+        EXPECT_EQ((size_t)(nCount - (nCount + 6) / 7), tree.getCollideAreaArray(-1, -1, nCount + 1, 200).size());
+        checkNodeBound(tree.getRootNode());
+    }
+}
+
+TEST_F(XYTreeTest, visitorSearch)
+{
+    RXYTree tree;
+    fillTree(tree);
+    tree.rebalance();
+
+    BoundRect2D window(100, 100, 300, 250);
+    std::vector<ComponentArea*> visitArray;
+    EXPECT_TRUE(tree.search(window, [&visitArray](ComponentArea* area) { visitArray.push_back(area); }));
+    EXPECT_EQ(bruteForce(window), toAddrArray(visitArray));
+
+    // 访问者返回false时提前停止
+    int nVisit = 0;
+    EXPECT_FALSE(tree.search(window, [&nVisit](ComponentArea*) { return ++nVisit < 3; }));
+    EXPECT_EQ(3, nVisit);
+
+    EXPECT_TRUE(tree.isCollide(100, 100, 300, 250));
+    EXPECT_FALSE(tree.isCollide(-100, -100, -50, -50));
+    EXPECT_NE(nullptr, tree.getFirstCollideArea(100, 100, 300, 250));
+    EXPECT_EQ(nullptr, tree.getFirstCollideArea(-100, -100, -50, -50));
+
+    // 复用调用者提供的数组
+    std::vector<ComponentArea*> buffer;
+    int nCount = tree.getCollideAreaArray(100, 100, 300, 250, buffer);
+    EXPECT_EQ((int)buffer.size(), nCount);
+    nCount = tree.getCollideAreaArray(0, 0, 5, 5, buffer);
+    EXPECT_EQ(bruteForce(window).size() + bruteForce(BoundRect2D(0, 0, 5, 5)).size(), buffer.size());
+}
+
+TEST_F(XYTreeTest, batchQuery)
+{
+    RXYTree tree;
+    fillTree(tree);
+    tree.rebalance();
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    std::uniform_real_distribution<double> len(0.0, 60.0);
+    std::vector<BoundRect2D> queryArray;
+    for (int i = 0; i < 500; ++i)
+    {
+        double x = pos(gen), y = pos(gen);
+        queryArray.emplace_back(x, y, x + len(gen), y + len(gen));
+    }
+
+    XYTreeBatchResult result;
+    tree.getCollideAreaBatch(queryArray.data(), (int)queryArray.size(), result);
+    ASSERT_EQ((int)queryArray.size(), result.getQueryNum());
+    for (int i = 0; i < result.getQueryNum(); ++i)
+    {
+        const BoundRect2D& q = queryArray[i];
+        std::vector<ComponentArea*> batchArray(result.getResult(i), result.getResult(i) + result.getResultNum(i));
+        EXPECT_EQ(tree.getCollideAreaArray(q.getMinX(), q.getMinY(), q.getMaxX(), q.getMaxY()), batchArray);
+    }
+
+    tree.getCollideAreaBatch(nullptr, 0, result);
+    EXPECT_EQ(0, result.getQueryNum());
+    EXPECT_TRUE(result.mAreaArray.empty());
+    tree.getCollideAreaBatch(nullptr, -1, result);
+    EXPECT_EQ(0, result.getQueryNum());
+}
+
+TEST_F(XYTreeTest, frozenParallelQuery)
+{
+    RXYTree tree;
+    tree.setThreadNum(4);
+    fillTree(tree);
+    tree.rebalance();
+    tree.freeze();
+
+    // 冻结后拒绝修改
+    EXPECT_TRUE(tree.isFrozen());
+    EXPECT_EQ(XYTREE_INVALID_HANDLE, tree.addComponentArea(0, 0, 1, 1, 0, nullptr));
+    EXPECT_FALSE(tree.rebalance());
+    ComponentArea* area = tree.getFirstCollideArea(0, 0, 1000, 1000);
+    ASSERT_TRUE(area);
+    EXPECT_FALSE(tree.updateComponentArea(area->getHandle(), 0, 0, 1, 1));
+    EXPECT_FALSE(tree.deleteComponentArea(area->getHandle()));
+    EXPECT_TRUE(tree.isIndexed(area->getHandle()));
+
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    std::uniform_real_distribution<double> len(0.0, 40.0);
+    std::vector<BoundRect2D> queryArray;
+    for (int i = 0; i < 3000; ++i)
+    {
+        double x = pos(gen), y = pos(gen);
+        queryArray.emplace_back(x, y, x + len(gen), y + len(gen));
+    }
+
+    XYTreeBatchResult serialResult, parallelResult;
+    tree.getCollideAreaBatch(queryArray.data(), (int)queryArray.size(), serialResult);
+    tree.getCollideAreaBatchParallel(queryArray.data(), (int)queryArray.size(), parallelResult);
+    EXPECT_EQ(serialResult.mOffsetArray, parallelResult.mOffsetArray);
+    EXPECT_EQ(serialResult.mAreaArray, parallelResult.mAreaArray);
+
+    // 未冻结时退化为串行批量查询，结果相同
+    tree.unfreeze();
+    XYTreeBatchResult unfrozenResult;
+    tree.getCollideAreaBatchParallel(queryArray.data(), (int)queryArray.size(), unfrozenResult);
+    EXPECT_EQ(serialResult.mOffsetArray, unfrozenResult.mOffsetArray);
+    EXPECT_EQ(serialResult.mAreaArray, unfrozenResult.mAreaArray);
+    tree.freeze();
+
+    // 多个线程同时对冻结的树做单次查询
+    std::vector<int> mismatchArray(4, 0);
+    std::vector<std::thread> threadArray;
+    for (int t = 0; t < 4; ++t)
+    {
+        threadArray.emplace_back(
+            [&, t]
+            {
+                std::vector<ComponentArea*> buffer;
+                for (int i = t; i < (int)queryArray.size(); i += 4)
+                {
+                    const BoundRect2D& q = queryArray[i];
+                    buffer.clear();
+                    tree.getCollideAreaArray(q.getMinX(), q.getMinY(), q.getMaxX(), q.getMaxY(), buffer);
+                    std::vector<ComponentArea*> expected(serialResult.getResult(i),
+                                                         serialResult.getResult(i) + serialResult.getResultNum(i));
+                    if (buffer != expected)
+                        ++mismatchArray[t];
+                }
+            });
+    }
+    for (auto& thread : threadArray)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(std::vector<int>(4, 0), mismatchArray);
+
+    tree.unfreeze();
+    EXPECT_NE(XYTREE_INVALID_HANDLE, tree.addComponentArea(0, 0, 1, 1, 0, nullptr));
+}
+
+TEST_F(XYTreeTest, deleteAndUpdate)
+{
+    RXYTree tree;
+    tree.createTree(500.0, XYTREE_SPLIT_X);
+    std::vector<XYTreeHandle> handleArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        handleArray.push_back(tree.addComponentArea(rects[i].getMinX(), rects[i].getMinY(), rects[i].getMaxX(),
+                                                    rects[i].getMaxY(), (int)(i % 8), (void*)(i + 1)));
+        ASSERT_EQ((XYTreeHandle)i, handleArray.back());
+    }
+    EXPECT_FALSE(tree.deleteComponentArea(XYTREE_INVALID_HANDLE));
+    EXPECT_FALSE(tree.deleteComponentArea((XYTreeHandle)rects.size()));
+
+    std::mt19937 gen(99);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    std::uniform_real_distribution<double> step(-5.0, 5.0);
+    const BoundRect2D farRect(-1e9, -1e9, -1e9, -1e9);  // 已删除器件: 不与任何查询窗口相交
+
+    // 删除、微小移动(通常仍在原树叶)和大范围移动交替进行
+    auto modify = [&](size_t i)
+    {
+        const BoundRect2D& rect = rects[i];
+        switch (i % 4)
+        {
+            case 0:
+                EXPECT_TRUE(tree.deleteComponentArea(handleArray[i]));
+                EXPECT_FALSE(tree.isIndexed(handleArray[i]));
+                handleArray[i] = XYTREE_INVALID_HANDLE;
+                rects[i] = farRect;
+                break;
+            case 1:
+            {
+                double dx = step(gen), dy = step(gen);
+                rects[i] = BoundRect2D(rect.getMinX() + dx, rect.getMinY() + dy, rect.getMaxX() + dx,
+                                       rect.getMaxY() + dy);
+                break;
+            }
+            case 2:
+            {
+                double x = pos(gen), y = pos(gen);
+                rects[i] = BoundRect2D(x, y, x + rect.getMaxX() - rect.getMinX(), y + rect.getMaxY() - rect.getMinY());
+                break;
+            }
+            default:
+                return;
+        }
+        if (XYTREE_INVALID_HANDLE != handleArray[i])
+        {
+            EXPECT_TRUE(tree.updateComponentArea(handleArray[i], rects[i].getMinX(), rects[i].getMinY(),
+                                                 rects[i].getMaxX(), rects[i].getMaxY()));
+        }
+    };
+    auto verify = [&]()
+    {
+        for (int q = 0; q < 200; ++q)
+        {
+            double x = pos(gen), y = pos(gen);
+            BoundRect2D window(x, y, x + 40.0, y + 40.0);
+            ASSERT_EQ(bruteForce(window), toAddrArray(tree.getCollideAreaArray(x, y, x + 40.0, y + 40.0)));
+        }
+    };
+
+    for (size_t i = 0; i < rects.size(); i += 2)
+    {
+        modify(i);
+    }
+    verify();
+
+    // 句柄在 rebalance 后仍然有效
+    tree.rebalance();
+    for (size_t i = 1; i < rects.size(); i += 2)
+    {
+        modify(i);
+    }
+    verify();
+
+    // 删除全部器件后树为空，仍可继续插入
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        if (XYTREE_INVALID_HANDLE != handleArray[i])
+        {
+            EXPECT_TRUE(tree.deleteComponentArea(handleArray[i]));
+        }
+    }
+    EXPECT_TRUE(tree.getCollideAreaArray(-1e9, -1e9, 1e9, 1e9).empty());
+
+    // 已释放的句柄被复用
+    XYTreeHandle handle = tree.addComponentArea(0, 0, 1, 1, 0, nullptr);
+    EXPECT_TRUE(handle >= 0 && handle < (XYTreeHandle)rects.size());
+    EXPECT_EQ(handle, tree.getComponentArea(handle)->getHandle());
+    EXPECT_EQ(1u, tree.getCollideAreaArray(0, 0, 1, 1).size());
+}
+
+TEST_F(XYTreeTest, deleteSubTree)
+{
+    RXYTree tree;
+    fillTree(tree);
+    EXPECT_TRUE(tree.rebalance());
+
+    // 删除树根某个树节点子树中的全部area，子树变为空(包围盒无效)
+    const XYTreeNode* root = tree.getRootNode();
+    const XYTreeNode* subTree = nullptr;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM && nullptr == subTree; ++i)
+    {
+        if (!root->isChildAreaArray((XYTreeChildType)i))
+            subTree = root->getChildNode((XYTreeChildType)i);
+    }
+    ASSERT_TRUE(subTree);
+    BoundRect2D subBound = *subTree->getBoundRect();
+    std::vector<ComponentArea*> subAreaArray;
+    subTree->search(subBound, subAreaArray);
+    ASSERT_FALSE(subAreaArray.empty());
+    std::vector<XYTreeHandle> subHandleArray;
+    for (ComponentArea* area : subAreaArray)
+    {
+        subHandleArray.push_back(area->getHandle());
+        rects[(size_t)area->getAddr() - 1] = BoundRect2D(-1e9, -1e9, -1e9, -1e9);
+    }
+    for (XYTreeHandle handle : subHandleArray)
+    {
+        EXPECT_TRUE(tree.deleteComponentArea(handle));
+    }
+    EXPECT_FALSE(subTree->getBoundRect()->isValid());
+    EXPECT_EQ(0u, subTree->getTypeMask());
+    checkNodeBound(root);
+
+    // 再次查找、删除和查询均不进入空子树的分割判别
+    XYTreeMemPool memPool;
+    ComponentArea* probe = ComponentArea::createComponentArea(&memPool, subBound.getMinX(), subBound.getMinY(),
+                                                              subBound.getMaxX(), subBound.getMaxY(), 0, nullptr);
+    EXPECT_FALSE(root->isFindArea(probe));
+    for (XYTreeHandle handle : subHandleArray)
+    {
+        EXPECT_FALSE(tree.deleteComponentArea(handle));
+    }
+    EXPECT_EQ(bruteForce(subBound), toAddrArray(tree.getCollideAreaArray(subBound.getMinX(), subBound.getMinY(),
+                                                                          subBound.getMaxX(), subBound.getMaxY())));
+
+    // 空子树可以重新插入
+    rects.emplace_back(subBound.getMinX(), subBound.getMinY(), subBound.getMinX() + 1.0, subBound.getMinY() + 1.0);
+    XYTreeHandle handle = tree.addComponentArea(rects.back().getMinX(), rects.back().getMinY(), rects.back().getMaxX(),
+                                                rects.back().getMaxY(), 0, (void*)rects.size());
+    EXPECT_TRUE(tree.isIndexed(handle));
+    EXPECT_TRUE(subTree->getBoundRect()->isValid());
+    checkNodeBound(root);
+    EXPECT_EQ(bruteForce(subBound), toAddrArray(tree.getCollideAreaArray(subBound.getMinX(), subBound.getMinY(),
+                                                                          subBound.getMaxX(), subBound.getMaxY())));
+    EXPECT_TRUE(tree.deleteComponentArea(handle));
+}
+
+TEST_F(XYTreeTest, bulkLoadHandle)
+{
+    // 批量构建时第i个器件的句柄为i
+    std::vector<void*> addrArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        addrArray.push_back((void*)(i + 1));
+    }
+    RXYTree tree(rects.data(), addrArray.data(), (int)rects.size());
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        ComponentArea* area = tree.getComponentArea((XYTreeHandle)i);
+        ASSERT_TRUE(area);
+        EXPECT_EQ(addrArray[i], area->getAddr());
+    }
+    EXPECT_FALSE(tree.isIndexed((XYTreeHandle)rects.size()));
+
+    // 删除后的查询与暴力结果一致
+    for (size_t i = 0; i < rects.size(); i += 2)
+    {
+        EXPECT_TRUE(tree.deleteComponentArea((XYTreeHandle)i));
+        rects[i] = BoundRect2D(-1e9, -1e9, -1e9, -1e9);
+    }
+    BoundRect2D window(200.0, 200.0, 600.0, 600.0);
+    EXPECT_EQ(bruteForce(window), toAddrArray(tree.getCollideAreaArray(200.0, 200.0, 600.0, 600.0)));
+}
+
+TEST_F(XYTreeTest, nearest)
+{
+    RXYTree tree;
+    fillTree(tree);
+    tree.deleteComponentArea(0);  // 包含已删除的器件
+    rects[0] = BoundRect2D(-1e9, -1e9, -1e9, -1e9);
+
+    // 暴力计算与查询矩形的距离，返回按距离排序的前 nCount 个距离
+    auto bruteForceNearest = [&](const BoundRect2D& srcRect, int nCount, double maxDist, XYTreeTypeMask typeMask)
+    {
+        std::vector<double> distArray;
+        for (size_t i = 1; i < rects.size(); ++i)
+        {
+            double dist = sqrt(srcRect.getSqrDistance(&rects[i]));
+            if (dist <= maxDist && (typeMask & xyTreeTypeBit((int)(i % 8))))
+                distArray.push_back(dist);
+        }
+        std::sort(distArray.begin(), distArray.end());
+        if (nCount > 0 && (int)distArray.size() > nCount)
+            distArray.resize(nCount);
+        return distArray;
+    };
+
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> pos(-100.0, 1100.0);
+    std::vector<XYTreeNeighbor> resultArray;
+    for (int q = 0; q < 100; ++q)
+    {
+        double x = pos(gen), y = pos(gen);
+        BoundRect2D srcRect(x, y, x + (q % 2) * 15.0, y + (q % 3) * 10.0);  // 点查询和矩形查询
+        XYTreeTypeMask typeMask = (q % 4 == 0) ? xyTreeTypeBit(3) | xyTreeTypeBit(5) : XYTREE_TYPE_MASK_ALL;
+        double maxDist = (q % 5 == 0) ? 20.0 : DBL_MAX;
+
+        tree.getNearestAreaArray(srcRect, 10, resultArray, maxDist, typeMask);
+        std::vector<double> distArray;
+        for (const auto& neighbor : resultArray)
+        {
+            distArray.push_back(neighbor.mDistance);
+            EXPECT_DOUBLE_EQ(sqrt(srcRect.getSqrDistance(neighbor.mArea->getBoundRect())), neighbor.mDistance);
+            EXPECT_TRUE(typeMask & xyTreeTypeBit(neighbor.mArea->getTypeId()));
+        }
+        EXPECT_EQ(bruteForceNearest(srcRect, 10, maxDist, typeMask), distArray);
+    }
+
+    // 不限数量: 返回距离范围内的全部器件
+    BoundRect2D srcRect(500.0, 500.0, 500.0, 500.0);
+    tree.getNearestAreaArray(srcRect, 0, resultArray, 50.0);
+    EXPECT_EQ(bruteForceNearest(srcRect, 0, 50.0, XYTREE_TYPE_MASK_ALL).size(), resultArray.size());
+
+    double dist = -1.0;
+    ComponentArea* area = tree.getNearestArea(srcRect, &dist);
+    ASSERT_TRUE(area);
+    EXPECT_DOUBLE_EQ(bruteForceNearest(srcRect, 1, DBL_MAX, XYTREE_TYPE_MASK_ALL)[0], dist);
+    EXPECT_EQ(nullptr, tree.getNearestArea(BoundRect2D(1e6, 1e6, 1e6, 1e6), nullptr, 10.0));
+}
+
+// 递归校验子树的类型掩码与其中area的类型一致，返回子树的类型掩码
+static XYTreeTypeMask checkTypeMask(const XYTreeNode* node)
+{
+    XYTreeTypeMask typeMask = 0;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        XYTreeChildType childType = (XYTreeChildType)i;
+        if (node->isChildAreaArray(childType))
+        {
+            const XYTreeLeaf* leaf = node->getChildLeaf(childType);
+            if (nullptr == leaf)
+                continue;
+            XYTreeTypeMask leafMask = 0;
+            for (const ComponentArea* area : leaf->getAreaArray())
+            {
+                leafMask |= xyTreeTypeBit(area->getTypeId());
+            }
+            EXPECT_EQ(leafMask, leaf->getTypeMask());
+            typeMask |= leafMask;
+        }
+        else
+        {
+            typeMask |= checkTypeMask(node->getChildNode(childType));
+        }
+    }
+    EXPECT_EQ(typeMask, node->getTypeMask());
+    return typeMask;
+}
+
+TEST_F(XYTreeTest, typeMask)
+{
+    // 40种类型，另有少量默认类型(-1)
+    auto getTypeId = [](size_t i) { return 0 == i % 97 ? -1 : (int)(i * 7 % 40); };
+    RXYTree tree;
+    tree.createTree(500.0, XYTREE_SPLIT_X);
+    std::vector<XYTreeHandle> handleArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        handleArray.push_back(tree.addComponentArea(rects[i].getMinX(), rects[i].getMinY(), rects[i].getMaxX(),
+                                                    rects[i].getMaxY(), getTypeId(i), (void*)(i + 1)));
+    }
+    checkTypeMask(tree.getRootNode());
+
+    auto verifyQuery = [&](XYTreeTypeMask typeMask)
+    {
+        const BoundRect2D windows[] = {{100, 100, 300, 250}, {-10, -10, 2000, 2000}, {700, 20, 980, 400}};
+        for (const BoundRect2D& window : windows)
+        {
+            std::vector<void*> expected;
+            for (size_t i = 0; i < rects.size(); ++i)
+            {
+                if (tree.isIndexed(handleArray[i]) && !window.isDisjoint(&rects[i]) &&
+                    (typeMask & xyTreeTypeBit(getTypeId(i))))
+                    expected.push_back((void*)(i + 1));
+            }
+            std::sort(expected.begin(), expected.end());
+            EXPECT_EQ(expected, toAddrArray(tree.getCollideAreaArray(window.getMinX(), window.getMinY(),
+                                                                     window.getMaxX(), window.getMaxY(), typeMask)));
+            ComponentArea* firstArea = tree.getFirstCollideArea(window.getMinX(), window.getMinY(), window.getMaxX(),
+                                                                window.getMaxY(), typeMask);
+            EXPECT_EQ(expected.empty(), nullptr == firstArea);
+            EXPECT_TRUE(nullptr == firstArea || (typeMask & xyTreeTypeBit(firstArea->getTypeId())));
+            EXPECT_EQ(!expected.empty(), tree.isCollide(window.getMinX(), window.getMinY(), window.getMaxX(),
+                                                        window.getMaxY(), typeMask));
+        }
+    };
+    verifyQuery(xyTreeTypeBit(3));
+    verifyQuery(xyTreeTypeBit(5) | xyTreeTypeBit(17));
+    verifyQuery(xyTreeTypeBit(-1));
+    verifyQuery(XYTREE_TYPE_MASK_ALL);
+    verifyQuery(xyTreeTypeBit(50));  // 没有该类型的器件
+
+    // 负数和>=63的类型共用第63位
+    EXPECT_EQ(xyTreeTypeBit(-1), xyTreeTypeBit(63));
+    EXPECT_EQ(xyTreeTypeBit(-1), xyTreeTypeBit(100));
+
+    // 删除某类型的全部器件后，不再有子树包含该类型
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        if (3 == getTypeId(i))
+        {
+            EXPECT_TRUE(tree.deleteComponentArea(handleArray[i]));
+        }
+        else if (0 == i % 5)  // 移动部分器件
+        {
+            tree.updateComponentArea(handleArray[i], rects[i].getMinX() + 1, rects[i].getMinY(),
+                                     rects[i].getMaxX() + 1, rects[i].getMaxY());
+        }
+    }
+    for (size_t i = 0; i < rects.size(); i += 5)
+    {
+        if (3 != getTypeId(i))
+            rects[i] = BoundRect2D(rects[i].getMinX() + 1, rects[i].getMinY(), rects[i].getMaxX() + 1,
+                                   rects[i].getMaxY());
+    }
+    EXPECT_EQ(0u, checkTypeMask(tree.getRootNode()) & xyTreeTypeBit(3));
+    verifyQuery(xyTreeTypeBit(3));
+    verifyQuery(xyTreeTypeBit(5) | xyTreeTypeBit(17));
+
+    tree.rebalance();
+    checkTypeMask(tree.getRootNode());
+    verifyQuery(xyTreeTypeBit(5) | xyTreeTypeBit(17));
+
+    // 近邻查询同样按类型掩码剪枝
+    std::vector<XYTreeNeighbor> resultArray;
+    tree.getNearestAreaArray(BoundRect2D(500, 500, 500, 500), 5, resultArray, DBL_MAX, xyTreeTypeBit(3));
+    EXPECT_TRUE(resultArray.empty());
+}
+
+TEST_F(XYTreeTest, snapshot)
+{
+    std::vector<int> typeIdArray;
+    std::vector<void*> addrArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        typeIdArray.push_back((int)(i % 40));
+        addrArray.push_back((void*)(i + 1));
+    }
+    RXYTree tree(rects.data(), addrArray.data(), (int)rects.size(), typeIdArray.data());
+    tree.deleteComponentArea(7);  // 含已删除的器件
+
+    const char* pszFileName = "xytree_snapshot_test.bin";
+    ASSERT_TRUE(XYTreeSnapshot::write(tree, pszFileName));
+
+    XYTreeSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(pszFileName));
+    EXPECT_EQ((int)rects.size() - 1, snapshot.getAreaNum());
+
+    std::mt19937 gen(21);
+    std::uniform_real_distribution<double> pos(-50.0, 1050.0);
+    std::uniform_real_distribution<double> len(0.0, 80.0);
+    std::vector<int> slotArray;
+    for (int q = 0; q < 200; ++q)
+    {
+        double x = pos(gen), y = pos(gen);
+        BoundRect2D window(x, y, x + len(gen), y + len(gen));
+        XYTreeTypeMask typeMask = (q % 3 == 0) ? xyTreeTypeBit(q % 40) : XYTREE_TYPE_MASK_ALL;
+
+        std::vector<void*> expected;
+        for (auto* area : tree.getCollideAreaArray(window.getMinX(), window.getMinY(), window.getMaxX(),
+                                                   window.getMaxY(), typeMask))
+        {
+            expected.push_back(area->getAddr());
+        }
+        std::sort(expected.begin(), expected.end());
+
+        slotArray.clear();
+        snapshot.getCollideAreaArray(window.getMinX(), window.getMinY(), window.getMaxX(), window.getMaxY(), slotArray,
+                                     typeMask);
+        std::vector<void*> result;
+        for (int nSlot : slotArray)
+        {
+            size_t nIndex = (size_t)snapshot.getAreaUserData(nSlot) - 1;
+            EXPECT_EQ(typeIdArray[nIndex], snapshot.getAreaTypeId(nSlot));
+            EXPECT_EQ((XYTreeHandle)nIndex, snapshot.getAreaHandle(nSlot));  // 批量构建时第i个器件的句柄为i
+            EXPECT_TRUE(snapshot.getAreaRect(nSlot).isEqual(&rects[nIndex]));
+            result.push_back((void*)(size_t)snapshot.getAreaUserData(nSlot));
+        }
+        std::sort(result.begin(), result.end());
+        EXPECT_EQ(expected, result);
+    }
+    snapshot.close();
+    EXPECT_FALSE(snapshot.isOpen());
+
+    // 版本不一致的文件拒绝加载
+    FILE* file = fopen(pszFileName, "r+b");
+    ASSERT_TRUE(file);
+    unsigned int nVersion = XYTREE_SNAPSHOT_VERSION + 1;
+    fseek(file, 8, SEEK_SET);
+    fwrite(&nVersion, sizeof(nVersion), 1, file);
+    fclose(file);
+    EXPECT_FALSE(snapshot.open(pszFileName));
+    EXPECT_FALSE(snapshot.open("xytree_snapshot_missing.bin"));
+    remove(pszFileName);
+
+    // 显式指定用户ID
+    ASSERT_TRUE(XYTreeSnapshot::write(tree, pszFileName,
+                                      [](const ComponentArea* area) { return 1000 + (uint64_t)area->getHandle(); }));
+    ASSERT_TRUE(snapshot.open(pszFileName));
+    slotArray.clear();
+    EXPECT_EQ((int)rects.size() - 1, snapshot.getCollideAreaArray(-1e9, -1e9, 1e9, 1e9, slotArray));
+    for (int nSlot : slotArray)
+    {
+        EXPECT_EQ(1000 + (uint64_t)snapshot.getAreaHandle(nSlot), snapshot.getAreaUserData(nSlot));
+    }
+    snapshot.close();
+    remove(pszFileName);
+
+    // 空树
+    RXYTree emptyTree;
+    emptyTree.createTree(0.0);
+    ASSERT_TRUE(XYTreeSnapshot::write(emptyTree, pszFileName));
+    ASSERT_TRUE(snapshot.open(pszFileName));
+    EXPECT_EQ(0, snapshot.getCollideAreaArray(-1e9, -1e9, 1e9, 1e9, slotArray));
+    snapshot.close();
+    remove(pszFileName);
+}
+
+TEST_F(XYTreeTest, selfJoin)
+{
+    RXYTree tree;
+    tree.setThreadNum(4);
+    fillTree(tree);
+    tree.rebalance();
+
+    typedef std::pair<void*, void*> AddrPair;
+    auto makePair = [](void* addr1, void* addr2)
+    { return addr1 < addr2 ? AddrPair(addr1, addr2) : AddrPair(addr2, addr1); };
+
+    // 暴力计算全部相交的无序对
+    auto bruteForcePair = [&](double clearance)
+    {
+        std::vector<AddrPair> pairArray;
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            BoundRect2D rect(rects[i].getMinX() - clearance, rects[i].getMinY() - clearance,
+                             rects[i].getMaxX() + clearance, rects[i].getMaxY() + clearance);
+            for (size_t j = i + 1; j < rects.size(); ++j)
+            {
+                if (!rect.isDisjoint(&rects[j]))
+                    pairArray.push_back(makePair((void*)(i + 1), (void*)(j + 1)));
+            }
+        }
+        std::sort(pairArray.begin(), pairArray.end());
+        return pairArray;
+    };
+
+    for (double clearance : {0.0, 3.0})
+    {
+        std::vector<AddrPair> pairArray;
+        EXPECT_TRUE(tree.selfJoin([&](ComponentArea* area1, ComponentArea* area2)
+                                  { pairArray.push_back(makePair(area1->getAddr(), area2->getAddr())); },
+                                  clearance));
+        std::sort(pairArray.begin(), pairArray.end());
+        auto expected = bruteForcePair(clearance);
+        EXPECT_FALSE(expected.empty());
+        EXPECT_EQ(expected, pairArray);  // 每个无序对恰好报告一次
+
+        tree.freeze();
+        std::mutex mutex;
+        std::vector<AddrPair> parallelPairArray;
+        tree.selfJoinParallel(
+            [&](ComponentArea* area1, ComponentArea* area2)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                parallelPairArray.push_back(makePair(area1->getAddr(), area2->getAddr()));
+            },
+            clearance);
+        std::sort(parallelPairArray.begin(), parallelPairArray.end());
+        EXPECT_EQ(expected, parallelPairArray);
+        tree.unfreeze();
+    }
+
+    // 未冻结时在调用线程中串行执行
+    std::thread::id callerId = std::this_thread::get_id();
+    size_t nPairNum = 0;
+    bool bCallerThread = true;
+    tree.selfJoinParallel(
+        [&](ComponentArea*, ComponentArea*)
+        {
+            ++nPairNum;
+            bCallerThread = bCallerThread && std::this_thread::get_id() == callerId;
+        });
+    EXPECT_TRUE(bCallerThread);
+    EXPECT_EQ(bruteForcePair(0.0).size(), nPairNum);
+
+    // 访问者返回false时提前停止
+    int nCount = 0;
+    EXPECT_FALSE(tree.selfJoin([&](ComponentArea*, ComponentArea*) { return ++nCount < 5; }));
+    EXPECT_EQ(5, nCount);
+}
+
+TEST_F(XYTreeTest, treeJoin)
+{
+    RXYTree tree;
+    tree.setThreadNum(4);
+    fillTree(tree);
+    tree.rebalance();
+
+    // 另一层的器件
+    std::mt19937 gen(77);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    std::uniform_real_distribution<double> len(0.5, 10.0);
+    std::vector<BoundRect2D> otherRects;
+    RXYTree otherTree;
+    otherTree.createTree(500.0, XYTREE_SPLIT_Y);
+    for (int i = 0; i < 1500; ++i)
+    {
+        double x = pos(gen), y = pos(gen);
+        otherRects.emplace_back(x, y, x + len(gen), y + len(gen));
+        otherTree.addComponentArea(x, y, otherRects.back().getMaxX(), otherRects.back().getMaxY(), 0,
+                                   (void*)(size_t)(i + 1));
+    }
+
+    typedef std::pair<void*, void*> AddrPair;
+    for (double clearance : {0.0, 2.5})
+    {
+        std::vector<AddrPair> expected;
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            BoundRect2D rect(rects[i].getMinX() - clearance, rects[i].getMinY() - clearance,
+                             rects[i].getMaxX() + clearance, rects[i].getMaxY() + clearance);
+            for (size_t j = 0; j < otherRects.size(); ++j)
+            {
+                if (!rect.isDisjoint(&otherRects[j]))
+                    expected.emplace_back((void*)(i + 1), (void*)(j + 1));
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        EXPECT_FALSE(expected.empty());
+
+        std::vector<AddrPair> pairArray;
+        EXPECT_TRUE(tree.join(otherTree, [&](ComponentArea* area1, ComponentArea* area2)
+                              { pairArray.emplace_back(area1->getAddr(), area2->getAddr()); },
+                              clearance));
+        std::sort(pairArray.begin(), pairArray.end());
+        EXPECT_EQ(expected, pairArray);
+
+        tree.freeze();
+        otherTree.freeze();
+        std::mutex mutex;
+        std::vector<AddrPair> parallelPairArray;
+        tree.joinParallel(
+            otherTree,
+            [&](ComponentArea* area1, ComponentArea* area2)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                parallelPairArray.emplace_back(area1->getAddr(), area2->getAddr());
+            },
+            clearance);
+        std::sort(parallelPairArray.begin(), parallelPairArray.end());
+        EXPECT_EQ(expected, parallelPairArray);
+
+        // 另一棵树未冻结时在调用线程中串行执行
+        otherTree.unfreeze();
+        std::thread::id callerId = std::this_thread::get_id();
+        size_t nPairNum = 0;
+        bool bCallerThread = true;
+        tree.joinParallel(
+            otherTree,
+            [&](ComponentArea*, ComponentArea*)
+            {
+                ++nPairNum;
+                bCallerThread = bCallerThread && std::this_thread::get_id() == callerId;
+            },
+            clearance);
+        EXPECT_TRUE(bCallerThread);
+        EXPECT_EQ(expected.size(), nPairNum);
+        tree.unfreeze();
+    }
+
+    // 与空树连接
+    RXYTree emptyTree;
+    EXPECT_TRUE(tree.join(emptyTree, [](ComponentArea*, ComponentArea*) { ADD_FAILURE(); }));
+}
+
+TEST_F(XYTreeTest, searchBox)
+{
+    RXYTree tree;
+    fillTree(tree);
+    EXPECT_TRUE(tree.rebalance());
+
+    // 分批取出的结果与一次性搜索的结果和顺序相同
+    std::mt19937 gen(99);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    RXYTreeSearchBox searchBox;
+    for (int q = 0; q < 50; ++q)
+    {
+        double x = pos(gen), y = pos(gen);
+        BoundRect2D window(x, y, x + 120.0, y + 80.0);
+        XYTreeTypeMask typeMask = (q % 2) ? XYTREE_TYPE_MASK_ALL : (xyTreeTypeBit(1) | xyTreeTypeBit(6));
+        std::vector<ComponentArea*> expect;
+        tree.search(window, [&expect](ComponentArea* area) { expect.push_back(area); }, typeMask);
+
+        std::vector<ComponentArea*> result;
+        searchBox.begin(tree, window, typeMask);
+        while (7 == searchBox.next(7, result))
+        {
+        }
+        EXPECT_TRUE(searchBox.isFinished());
+        EXPECT_EQ(expect, result);
+        EXPECT_EQ(nullptr, searchBox.next());
+    }
+
+    // 两个搜索盒交替取出，互不影响
+    BoundRect2D window(100, 100, 600, 500);
+    RXYTreeSearchBox searchBox2;
+    searchBox.begin(tree, window);
+    searchBox2.begin(tree, window);
+    std::vector<ComponentArea*> result1, result2;
+    while (!searchBox.isFinished() || !searchBox2.isFinished())
+    {
+        searchBox.next(3, result1);
+        searchBox2.next(5, result2);
+    }
+    EXPECT_EQ(bruteForce(window), toAddrArray(result1));
+    EXPECT_EQ(result1, result2);
+
+    searchBox.begin(tree, BoundRect2D(-100, -100, -50, -50));
+    EXPECT_EQ(nullptr, searchBox.next());
+    EXPECT_TRUE(searchBox.isFinished());
+}
+
+TEST_F(XYTreeTest, compiled)
+{
+    RXYTree tree;
+    fillTree(tree);
+    EXPECT_TRUE(tree.rebalance());
+
+    for (bool bCompact : {false, true})
+    {
+        XYTreeCompiled compiled;
+        compiled.compile(tree, bCompact);
+        EXPECT_EQ(bCompact, compiled.isCompact());
+        EXPECT_EQ((int)rects.size(), compiled.getAreaNum());
+        EXPECT_GT(compiled.getNodeNum(), 1);
+
+        // 结果及顺序与原树的搜索完全相同
+        std::mt19937 gen(4321);
+        std::uniform_real_distribution<double> pos(0.0, 1000.0);
+        for (int q = 0; q < 100; ++q)
+        {
+            double x = pos(gen), y = pos(gen);
+            BoundRect2D window(x, y, x + 60.0, y + 60.0);
+            XYTreeTypeMask typeMask = (q % 2) ? XYTREE_TYPE_MASK_ALL : (xyTreeTypeBit(2) | xyTreeTypeBit(5));
+            std::vector<ComponentArea*> expect, result;
+            tree.search(window, [&expect](ComponentArea* area) { expect.push_back(area); }, typeMask);
+            EXPECT_EQ((int)expect.size(), compiled.getCollideAreaArray(x, y, x + 60.0, y + 60.0, result, typeMask));
+            EXPECT_EQ(expect, result);
+        }
+
+        // 访问者提前停止
+        int nCount = 0;
+        EXPECT_FALSE(
+            compiled.search(BoundRect2D(-1, -1, 2000, 2000), [&nCount](ComponentArea*) { return ++nCount < 5; }));
+        EXPECT_EQ(5, nCount);
+    }
+
+    // 紧凑模式的节点记录约为精确模式的一半
+    XYTreeCompiled exact, compact;
+    exact.compile(tree);
+    compact.compile(tree, true);
+    EXPECT_EQ(exact.getNodeNum(), compact.getNodeNum());
+    EXPECT_EQ(exact.getLeafNum(), compact.getLeafNum());
+    EXPECT_LT(compact.getNodeBytes() * 10, exact.getNodeBytes() * 7);
+
+    XYTreeCompiled compiled;
+    RXYTree emptyTree;
+    compiled.compile(emptyTree);
+    EXPECT_EQ(0, compiled.getNodeNum());
+    std::vector<ComponentArea*> result;
+    EXPECT_EQ(0, compiled.getCollideAreaArray(-1, -1, 2000, 2000, result));
+}
+
+// 坐标不能被float精确表示时，紧凑模式的保守包围盒不漏掉恰好接触的area
+TEST(XYTreeCompactTest, touchingBound)
+{
+    std::vector<BoundRect2D> rectArray;
+    RXYTree tree;
+    tree.createTree(10.0, XYTREE_SPLIT_X);
+    for (int i = 0; i < 200; ++i)
+    {
+        double x = 0.1 * i + 1e-9, y = 0.3 * (i % 7) + 1e-9;
+        rectArray.emplace_back(x, y, x + 0.07, y + 0.11);
+        tree.addComponentArea(x, y, x + 0.07, y + 0.11, 0, (void*)(intptr_t)(i + 1));
+    }
+    EXPECT_TRUE(tree.rebalance());
+    XYTreeCompiled compact;
+    compact.compile(tree, true);
+
+    for (size_t i = 0; i < rectArray.size(); ++i)
+    {
+        // 以area的四条边为搜索区域的边
+        double minX = rectArray[i].getMinX(), minY = rectArray[i].getMinY();
+        double maxX = rectArray[i].getMaxX(), maxY = rectArray[i].getMaxY();
+        BoundRect2D windowArray[] = {BoundRect2D(maxX, minY, maxX + 1, maxY), BoundRect2D(minX - 1, minY, minX, maxY),
+                                     BoundRect2D(minX, maxY, maxX, maxY + 1), BoundRect2D(minX, minY - 1, maxX, minY)};
+        for (const BoundRect2D& window : windowArray)
+        {
+            std::vector<ComponentArea*> expect, result;
+            tree.search(window, [&expect](ComponentArea* area) { expect.push_back(area); });
+            compact.search(window, [&result](ComponentArea* area) { result.push_back(area); });
+            EXPECT_EQ(expect, result);
+            EXPECT_TRUE(std::any_of(result.begin(), result.end(), [i](ComponentArea* area)
+                                    { return area->getAddr() == (void*)(intptr_t)(i + 1); }));
+        }
+    }
+}
+
+static int getTreeDepth(const XYTreeNode* node)
+{
+    int nDepth = 0;
+    for (int i = XYTREE_CHILD_LEFT; i < XYTREE_CHILD_NUM; ++i)
+    {
+        const XYTreeNode* child = node->getChildNode((XYTreeChildType)i);
+        if (child)
+            nDepth = std::max(nDepth, getTreeDepth(child));
+    }
+    return nDepth + 1;
+}
+
+TEST(XYTreeSmallStackTest, overflow)
+{
+    // 超出固定容量后转用堆内存，仍保持后进先出
+    XYTreeSmallStack<int> stack;
+    for (int i = 0; i < XY_SEARCH_STACK_SIZE * 3; ++i)
+        stack.push(i);
+    EXPECT_EQ(XY_SEARCH_STACK_SIZE * 3, stack.size());
+    for (int i = XY_SEARCH_STACK_SIZE * 3 - 1; i >= 0; --i)
+        EXPECT_EQ(i, stack.pop());
+    EXPECT_TRUE(stack.empty());
+}
+
+TEST(XYTreeDeepTest, search)
+{
+    // 按X坐标递增逐个插入且不重建失衡子树: 树叶不断在最右侧分裂，得到退化的深树
+    std::vector<BoundRect2D> rects;
+    RXYTree tree;
+    tree.setRebuildDepthFactor(0);
+    tree.createTree(0.0, XYTREE_SPLIT_X);
+    for (int i = 0; i < 20000; ++i)
+    {
+        rects.emplace_back(i, (i * 7) % 100, i + 0.5, (i * 7) % 100 + 0.5);
+        tree.addComponentArea(i, (i * 7) % 100, i + 0.5, (i * 7) % 100 + 0.5, 0, (void*)(size_t)(i + 1));
+    }
+    EXPECT_GT(getTreeDepth(tree.getRootNode()), XY_SEARCH_STACK_SIZE);
+
+    for (double x : {0.0, 5000.0, 19990.0})
+    {
+        BoundRect2D window(x, 10.0, x + 300.0, 60.0);
+        size_t nExpect = 0;
+        for (const auto& rect : rects)
+            nExpect += window.isDisjoint(&rect) ? 0 : 1;
+        EXPECT_EQ(nExpect, tree.getCollideAreaArray(x, 10.0, x + 300.0, 60.0).size());
+    }
+    EXPECT_EQ(rects.size(), tree.getCollideAreaArray(-1, -1, 30000, 200).size());
+
+    // 快照按相同的显式栈遍历深树
+    const char* pszFileName = "xytree_deep_snapshot_test.bin";
+    ASSERT_TRUE(XYTreeSnapshot::write(tree, pszFileName));
+    {
+        XYTreeSnapshot snapshot;
+        ASSERT_TRUE(snapshot.open(pszFileName));
+        std::vector<int> slotArray;
+        EXPECT_EQ((int)rects.size(), snapshot.getCollideAreaArray(-1, -1, 30000, 200, slotArray));
+    }
+    remove(pszFileName);
+
+    // 深树上的空间连接使用显式栈，结果与按X排序的扫描一致
+    const double clearance = 8.0;
+    size_t nExpectPair = 0;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        BoundRect2D rect(rects[i].getMinX() - clearance, rects[i].getMinY() - clearance,
+                         rects[i].getMaxX() + clearance, rects[i].getMaxY() + clearance);
+        for (size_t j = i + 1; j < rects.size() && rects[j].getMinX() <= rect.getMaxX(); ++j)
+            nExpectPair += rect.isDisjoint(&rects[j]) ? 0 : 1;
+    }
+    size_t nSelfPair = 0, nCrossPair = 0;
+    EXPECT_TRUE(tree.selfJoin([&nSelfPair](ComponentArea*, ComponentArea*) { ++nSelfPair; }, clearance));
+    EXPECT_TRUE(tree.join(tree, [&nCrossPair](ComponentArea*, ComponentArea*) { ++nCrossPair; }, clearance));
+    EXPECT_GT(nExpectPair, 0u);
+    EXPECT_EQ(nExpectPair, nSelfPair);
+    EXPECT_EQ(nExpectPair * 2 + rects.size(), nCrossPair);
+}
+
+TEST_F(XYTreeTest, batch)
+{
+    RXYTree tree;
+    tree.createTree(500.0, XYTREE_SPLIT_X);
+    EXPECT_FALSE(tree.commitBatch());
+
+    // 空树上批量插入: 提交前不可见，提交后超过门限的树叶被分裂
+    tree.beginBatch();
+    EXPECT_TRUE(tree.isInBatch());
+    std::vector<XYTreeHandle> handleArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        handleArray.push_back(tree.addComponentArea(rects[i].getMinX(), rects[i].getMinY(), rects[i].getMaxX(),
+                                                    rects[i].getMaxY(), (int)(i % 8), (void*)(i + 1)));
+        ASSERT_EQ((XYTreeHandle)i, handleArray.back());
+    }
+    EXPECT_TRUE(tree.getCollideAreaArray(-1e9, -1e9, 1e9, 1e9).empty());
+    EXPECT_TRUE(tree.commitBatch());
+    EXPECT_FALSE(tree.isInBatch());
+    EXPECT_GT(getTreeDepth(tree.getRootNode()), 2);
+    checkNodeBound(tree.getRootNode());
+
+    std::mt19937 gen(777);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    const BoundRect2D farRect(-1e9, -1e9, -1e9, -1e9);  // 已删除器件: 不与任何查询窗口相交
+    auto verify = [&]()
+    {
+        for (int q = 0; q < 200; ++q)
+        {
+            double x = pos(gen), y = pos(gen);
+            BoundRect2D window(x, y, x + 40.0, y + 40.0);
+            ASSERT_EQ(bruteForce(window), toAddrArray(tree.getCollideAreaArray(x, y, x + 40.0, y + 40.0)));
+        }
+    };
+    verify();
+
+    // 混合修改: 删除、插入、修改和删除待插入的area、立即生效的修改
+    tree.beginBatch();
+    for (size_t i = 0; i < handleArray.size(); i += 3)
+    {
+        EXPECT_TRUE(tree.deleteComponentArea(handleArray[i]));
+        EXPECT_FALSE(tree.isIndexed(handleArray[i]));
+        EXPECT_FALSE(tree.deleteComponentArea(handleArray[i]));
+        handleArray[i] = XYTREE_INVALID_HANDLE;
+        rects[i] = farRect;
+    }
+    EXPECT_FALSE(tree.getCollideAreaArray(-1e9, -1e9, 1e9, 1e9).empty());  //提交前已删除的area仍在树中
+    size_t nOldNum = rects.size();
+    for (size_t i = nOldNum; i < nOldNum + 500; ++i)
+    {
+        double x = pos(gen), y = pos(gen);
+        rects.emplace_back(x, y, x + 3.0, y + 2.0);
+        handleArray.push_back(tree.addComponentArea(x, y, x + 3.0, y + 2.0, (int)(i % 8), (void*)(i + 1)));
+        EXPECT_TRUE(tree.isIndexed(handleArray.back()));
+    }
+    for (size_t i = nOldNum; i < rects.size(); i += 5)
+    {
+        EXPECT_TRUE(tree.deleteComponentArea(handleArray[i]));
+        handleArray[i] = XYTREE_INVALID_HANDLE;
+        rects[i] = farRect;
+    }
+    for (size_t i = nOldNum + 1; i < rects.size(); i += 5)
+    {
+        double x = pos(gen), y = pos(gen);
+        rects[i] = BoundRect2D(x, y, x + 1.0, y + 1.0);
+        EXPECT_TRUE(tree.updateComponentArea(handleArray[i], x, y, x + 1.0, y + 1.0));
+    }
+    for (size_t i = 1; i < nOldNum; i += 30)
+    {
+        double x = pos(gen), y = pos(gen);
+        rects[i] = BoundRect2D(x, y, x + 2.0, y + 2.0);
+        EXPECT_TRUE(tree.updateComponentArea(handleArray[i], x, y, x + 2.0, y + 2.0));
+    }
+    EXPECT_TRUE(tree.commitBatch());
+    checkNodeBound(tree.getRootNode());
+    verify();
+
+    // 提交后句柄目录正确: 逐个修改仍然生效
+    for (size_t i = 0; i < handleArray.size(); ++i)
+    {
+        if (XYTREE_INVALID_HANDLE == handleArray[i])
+            continue;
+        EXPECT_EQ(handleArray[i], tree.getComponentArea(handleArray[i])->getHandle());
+        if (i % 7 == 0)
+        {
+            double x = pos(gen), y = pos(gen);
+            rects[i] = BoundRect2D(x, y, x + 5.0, y + 5.0);
+            EXPECT_TRUE(tree.updateComponentArea(handleArray[i], x, y, x + 5.0, y + 5.0));
+        }
+    }
+    checkNodeBound(tree.getRootNode());
+    verify();
+
+    // 批量删除全部
+    tree.beginBatch();
+    for (XYTreeHandle handle : handleArray)
+    {
+        if (XYTREE_INVALID_HANDLE != handle)
+        {
+            EXPECT_TRUE(tree.deleteComponentArea(handle));
+        }
+    }
+    EXPECT_TRUE(tree.commitBatch());
+    checkNodeBound(tree.getRootNode());
+    EXPECT_TRUE(tree.getCollideAreaArray(-1e9, -1e9, 1e9, 1e9).empty());
+}
+
+TEST_F(XYTreeTest, batchGuard)
+{
+    RXYTree tree;
+    fillTree(tree);
+
+    // 冻结的树和已处于批量修改中的树不能开始批量修改
+    tree.freeze();
+    EXPECT_FALSE(tree.beginBatch());
+    EXPECT_FALSE(tree.isInBatch());
+    tree.unfreeze();
+    EXPECT_TRUE(tree.beginBatch());
+    EXPECT_FALSE(tree.beginBatch());
+    EXPECT_TRUE(tree.isInBatch());
+
+    // 批量修改中清空或批量构建被拒绝，已登记的修改和句柄保持有效
+    XYTreeHandle handle = tree.addComponentArea(2000, 2000, 2010, 2010, 0, (void*)(rects.size() + 1));
+    EXPECT_TRUE(tree.deleteComponentArea(0));
+    EXPECT_FALSE(tree.clear());
+    EXPECT_FALSE(tree.bulkLoad(rects.data(), nullptr, (int)rects.size()));
+    EXPECT_TRUE(tree.isInBatch());
+    EXPECT_TRUE(tree.isIndexed(handle));
+    EXPECT_TRUE(tree.commitBatch());
+    EXPECT_EQ(rects.size(), tree.getCollideAreaArray(-1, -1, 3000, 3000).size());
+    EXPECT_EQ(1u, tree.getCollideAreaArray(2000, 2000, 2000, 2000).size());
+
+    // 冻结的树不能清空，提交后可以清空
+    tree.freeze();
+    EXPECT_FALSE(tree.clear());
+    tree.unfreeze();
+    EXPECT_TRUE(tree.clear());
+    EXPECT_FALSE(tree.isIndexed(handle));
+    EXPECT_TRUE(tree.bulkLoad(rects.data(), nullptr, (int)rects.size()));
+    EXPECT_EQ(rects.size(), tree.getCollideAreaArray(-1, -1, 3000, 3000).size());
+}
+
+TEST(XYTreeSimdTest, overlapMask)
+{
+    XYTreeRectArray rectArray;
+    rectArray.push(BoundRect2D(0, 0, 10, 10));
+    rectArray.push(BoundRect2D(10, 10, 20, 20));  // 与查询矩形角点接触
+    rectArray.push(BoundRect2D(30, 30, 40, 40));
+    rectArray.push(BoundRect2D(-5, 5, 0, 6));  // 与查询矩形边接触
+    rectArray.push(BoundRect2D(5, 5, 6, 6));
+    BoundRect2D window(0, 0, 10, 10);
+
+    // 掩码结果与 isDisjoint 完全一致，尾部填充位不命中
+    for (int nBlock = 0; nBlock < rectArray.getBlockNum(); ++nBlock)
+    {
+        unsigned int nMask = xyTreeOverlapMask(rectArray, nBlock * XY_SIMD_BLOCK, window);
+        for (int i = 0; i < XY_SIMD_BLOCK; ++i)
+        {
+            int nIndex = nBlock * XY_SIMD_BLOCK + i;
+            bool bExpect = false;
+            if (nIndex < rectArray.size())
+            {
+                BoundRect2D rect(rectArray.getMinX()[nIndex], rectArray.getMinY()[nIndex], rectArray.getMaxX()[nIndex],
+                                 rectArray.getMaxY()[nIndex]);
+                bExpect = !window.isDisjoint(&rect);
+            }
+            EXPECT_EQ(bExpect, 0 != (nMask & (1u << i))) << nIndex;
+        }
+    }
+    EXPECT_EQ(0x1bu, xyTreeOverlapMask(rectArray, 0, window) | (xyTreeOverlapMask(rectArray, 4, window) << 4));
+
+    rectArray.erase(1);
+    EXPECT_EQ(4, rectArray.size());
+    EXPECT_EQ(0xdu, xyTreeOverlapMask(rectArray, 0, window));
+    EXPECT_EQ(0u, xyTreeOverlapMask(rectArray, 4, window));
+}
+
+TEST_F(XYTreeTest, simdLeafAfterDelete)
+{
+    std::vector<ComponentArea*> areaArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        areaArray.push_back(ComponentArea::createComponentArea(rects[i].getMinX(), rects[i].getMinY(), rects[i].getMaxX(),
+                                                               rects[i].getMaxY(), (int)(i % 8), (void*)(i + 1)));
+    }
+    XYTreeLeaf leaf(nullptr);
+    leaf.setAreaArray(areaArray.data(), (int)areaArray.size(), BoundRect2D(0.0, 0.0, 1100.0, 1100.0));
+
+    // 删除部分器件后树叶中的SoA坐标仍与area列表一致
+    std::vector<bool> isDeleted(rects.size(), false);
+    for (size_t i = 0; i < rects.size(); i += 3)
+    {
+        isDeleted[i] = true;
+        leaf.deleteArea(areaArray[i]);
+    }
+
+    std::mt19937 gen(777);
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    for (int q = 0; q < 100; ++q)
+    {
+        double x = pos(gen), y = pos(gen);
+        BoundRect2D window(x, y, x + 40.0, y + 40.0);
+        std::vector<void*> expect;
+        for (void* addr : bruteForce(window))
+        {
+            if (!isDeleted[(size_t)addr - 1])
+                expect.push_back(addr);
+        }
+        std::vector<ComponentArea*> resultArray;
+        leaf.getJointArea(window, resultArray);
+        EXPECT_EQ(expect, toAddrArray(resultArray));
+    }
+}
+
+// 模板XYTree的查询结果与暴力搜索比较(结果按负载排序)
+template <typename Coord>
+static void checkTemplateTree(const XYTree<Coord, int>& tree, const std::vector<XYTreeRect<Coord>>& rectArray,
+                              const std::vector<bool>& isDeleted, std::mt19937& gen)
+{
+    std::uniform_real_distribution<double> pos(0.0, 1000.0);
+    for (int q = 0; q < 100; ++q)
+    {
+        Coord x = (Coord)pos(gen), y = (Coord)pos(gen);
+        XYTreeRect<Coord> window{x, y, (Coord)(x + 40), (Coord)(y + 40)};
+        std::vector<int> expect;
+        for (size_t i = 0; i < rectArray.size(); ++i)
+        {
+            if (!isDeleted[i] && !rectArray[i].isDisjoint(window))
+                expect.push_back((int)i);
+        }
+        std::vector<int> result;
+        EXPECT_EQ((int)expect.size(), tree.query(window, result));
+        std::sort(result.begin(), result.end());
+        EXPECT_EQ(expect, result);
+    }
+}
+
+template <typename Coord>
+static void testTemplateTree(const std::vector<BoundRect2D>& rects)
+{
+    std::vector<XYTreeRect<Coord>> rectArray;
+    std::vector<typename XYTree<Coord, int>::Entry> entryArray;
+    for (size_t i = 0; i < rects.size(); ++i)
+    {
+        XYTreeRect<Coord> rect{(Coord)rects[i].getMinX(), (Coord)rects[i].getMinY(), (Coord)rects[i].getMaxX(),
+                               (Coord)rects[i].getMaxY()};
+        rectArray.push_back(rect);
+        entryArray.push_back({rect, (int)i});
+    }
+    std::vector<bool> isDeleted(rects.size(), false);
+    std::mt19937 gen(2024);
+
+    // 逐个插入
+    XYTree<Coord, int> tree;
+    for (size_t i = 0; i < rectArray.size(); ++i)
+    {
+        tree.insert(rectArray[i], (int)i);
+    }
+    EXPECT_EQ(rectArray.size(), tree.size());
+    checkTemplateTree(tree, rectArray, isDeleted, gen);
+
+    // 删除后再平衡
+    for (size_t i = 0; i < rectArray.size(); i += 3)
+    {
+        EXPECT_TRUE(tree.remove(rectArray[i], (int)i));
+        isDeleted[i] = true;
+    }
+    EXPECT_FALSE(tree.remove(rectArray[0], 0));
+    checkTemplateTree(tree, rectArray, isDeleted, gen);
+    tree.rebalance();
+    checkTemplateTree(tree, rectArray, isDeleted, gen);
+
+    // 批量构建，访问者提前停止
+    XYTree<Coord, int> bulkTree(entryArray);
+    std::fill(isDeleted.begin(), isDeleted.end(), false);
+    checkTemplateTree(bulkTree, rectArray, isDeleted, gen);
+    int nCount = 0;
+    XYTreeRect<Coord> all{0, 0, (Coord)1100, (Coord)1100};
+    EXPECT_FALSE(bulkTree.search(all, [&nCount](const typename XYTree<Coord, int>::Entry&) { return ++nCount < 10; }));
+    EXPECT_EQ(10, nCount);
+}
+
+TEST_F(XYTreeTest, templateTree)
+{
+    static_assert(sizeof(XYTreeRect<int32_t>) == 16, "int32 rect must take 16 bytes");
+    testTemplateTree<int32_t>(rects);
+    testTemplateTree<float>(rects);
+    testTemplateTree<double>(rects);
+}
+
+TEST(XYTreeDeepTest, templateSortedInsert)
+{
+    // 按X坐标递增逐个插入: 过深时重建失衡子树，树高保持对数级
+    const int nCount = 80000;
+    XYTree<int32_t, int> tree;
+    for (int i = 0; i < nCount; ++i)
+    {
+        tree.insert(XYTreeRect<int32_t>{i * 2, (i * 7) % 100, i * 2 + 1, (i * 7) % 100 + 1}, i);
+    }
+    EXPECT_EQ((size_t)nCount, tree.size());
+    EXPECT_LE(tree.getHeight(), XYTreeNode::getHeightLimit(nCount, XY_REBUILD_DEPTH_FACTOR));
+
+    std::vector<int> resultArray;
+    EXPECT_EQ(nCount, tree.query(XYTreeRect<int32_t>{-1, -1, nCount * 2, 200}, resultArray));
+    resultArray.clear();
+    EXPECT_EQ(2, tree.query(XYTreeRect<int32_t>{nCount, -1, nCount + 2, 200}, resultArray));
+    for (int i = 0; i < nCount; i += 7)
+    {
+        EXPECT_TRUE(tree.remove(XYTreeRect<int32_t>{i * 2, (i * 7) % 100, i * 2 + 1, (i * 7) % 100 + 1}, i));
+    }
+    resultArray.clear();
+    EXPECT_EQ(nCount - (nCount + 6) / 7, tree.query(XYTreeRect<int32_t>{-1, -1, nCount * 2, 200}, resultArray));
+
+    // 关闭重建时退化为链状
+    XYTree<int32_t, int> chainTree;
+    chainTree.setRebuildDepthFactor(0);
+    for (int i = 0; i < nCount / 8; ++i)
+    {
+        chainTree.insert(XYTreeRect<int32_t>{i * 2, 0, i * 2 + 1, 1}, i);
+    }
+    EXPECT_GT(chainTree.getHeight(), XYTreeNode::getHeightLimit(nCount / 8, XY_REBUILD_DEPTH_FACTOR));
+    EXPECT_GT(chainTree.getHeight(), XY_SEARCH_STACK_SIZE);  //迭代搜索的栈超出固定容量
+    resultArray.clear();
+    EXPECT_EQ(nCount / 8, chainTree.query(XYTreeRect<int32_t>{-1, -1, nCount, 2}, resultArray));
+}
+
+TEST(XYTreeTemplateTest, integerMidPos)
+{
+    // 整数坐标取中点: 区间[1,3]的中点为2(分别取半相加得1，无法分割)，两组子树均可再按X分割
+    std::vector<XYTree<int32_t, int>::Entry> entryArray;
+    for (int32_t x : {1, 3, 201, 203})
+    {
+        for (int i = 0; i < XY_THRESHOLD * 2; ++i)
+            entryArray.push_back({XYTreeRect<int32_t>{x, 0, x, 0}, x});
+    }
+    XYTree<int32_t, int> tree(entryArray);
+    EXPECT_EQ(2, tree.getHeight());
+    std::vector<int> resultArray;
+    EXPECT_EQ(XY_THRESHOLD * 2, tree.query(XYTreeRect<int32_t>{3, 0, 100, 0}, resultArray));
+
+    // 取值跨越整个int32范围时不溢出
+    entryArray.clear();
+    for (int i = 0; i < XY_THRESHOLD * 4; ++i)
+    {
+        int32_t x = (i % 2) ? INT32_MAX : INT32_MIN;
+        entryArray.push_back({XYTreeRect<int32_t>{x, 0, x, 0}, i});
+    }
+    XYTree<int32_t, int> wideTree(entryArray);
+    resultArray.clear();
+    EXPECT_EQ(XY_THRESHOLD * 2, wideTree.query(XYTreeRect<int32_t>{INT32_MAX, 0, INT32_MAX, 0}, resultArray));
+    resultArray.clear();
+    EXPECT_EQ(XY_THRESHOLD * 4, wideTree.query(XYTreeRect<int32_t>{INT32_MIN, 0, INT32_MAX, 0}, resultArray));
+}